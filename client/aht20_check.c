@@ -0,0 +1,138 @@
+/* aht20_check.c - pilote AHT20 sur le bus simulé : conversion, défauts injectés, formes d'onde
+ *
+ * Usage : ./aht20_check   (make check)
+ *
+ * Chemin complet pilote -> interface -> iic -> émulateur (iic_sim.h), un capteur
+ * par canal du TCA9548A simulé : relecture des valeurs, CRC corrompu, bit busy
+ * bloqué, NAK, forme carrée et triangle.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "driver_aht20_multi.h"
+#include "iic_sim.h"
+#include "check.h"
+
+enum { CH_CONST, CH_CRC, CH_BUSY, CH_NAK, CH_SQUARE, CH_TRIANGLE, CH_FULL, N_SENSORS };
+
+/* Une mesure complète : déclenchement, attente du busy, lecture de la trame */
+static uint8_t measure(aht20_multi_sensor_t *s, float *t, uint8_t *h) {
+    uint32_t t_raw, h_raw;
+    uint8_t res = aht20_start_measurement(&s->handle);
+    if (res == 0) res = aht20_wait_ready(&s->handle, 200);
+    if (res == 0) res = aht20_fetch_result(&s->handle, &t_raw, t, &h_raw, h);
+    return res;
+}
+
+static aht20_stats_t stats_of(aht20_multi_sensor_t *s) {
+    aht20_stats_t st;
+    aht20_get_stats(&s->handle, &st);
+    return st;
+}
+
+int main(void) {
+    aht20_multi_sensor_t sensors[N_SENSORS];
+    iic_sim_aht20_t model;
+    aht20_stats_t st;
+    float t;
+    uint8_t h;
+
+    // Modèles par canal, posés avant l'ouverture du bus
+    memset(sensors, 0, sizeof sensors);
+    for (uint8_t i = 0; i < N_SENSORS; ++i) {
+        iic_sim_aht20_default(&model);
+        model.conversion_ms = 10;
+        switch (i) {
+        case CH_SQUARE:
+            model.temperature = (iic_sim_waveform_t){ IIC_SIM_WAVE_SQUARE, 20.0f, 5.0f, 200 };
+            model.humidity = (iic_sim_waveform_t){ IIC_SIM_WAVE_SQUARE, 50.0f, 10.0f, 200 };
+            break;
+        case CH_TRIANGLE:
+            model.temperature = (iic_sim_waveform_t){ IIC_SIM_WAVE_TRIANGLE, 10.0f, 4.0f, 120 };
+            break;
+        case CH_FULL:
+            model.temperature.base = 150.0f;
+            model.humidity.base = 100.0f;
+            break;
+        default:
+            break;
+        }
+        iic_sim_aht20_set(i, &model);
+        sensors[i].device = (aht20_interface_device_t){ IIC_SIM_NAME, 0, 0xE0, i };
+    }
+    CHECK(aht20_multi_init(sensors, N_SENSORS) == 0);
+
+    // Valeurs constantes : 45 % relu 45 (encodage et conversion arrondis), 21,5 °C à 1e-3 près
+    CHECK(measure(&sensors[CH_CONST], &t, &h) == 0);
+    CHECK(h == 45);
+    CHECK(t > 21.499f && t < 21.501f);
+    st = stats_of(&sensors[CH_CONST]);
+    CHECK(st.measurements == 1 && st.iic_errors == 0 && st.crc_errors == 0 && st.busy_timeouts == 0);
+
+    // Pleine échelle : 100 % et 150 °C restent sur 20 bits
+    CHECK(measure(&sensors[CH_FULL], &t, &h) == 0);
+    CHECK(h == 100);
+    CHECK(t > 149.99f && t <= 150.0f);
+
+    // CRC corrompu à chaque trame : erreur 5, comptée, la mesure suivante repasse une fois le défaut levé
+    iic_sim_aht20_default(&model);
+    model.conversion_ms = 10;
+    model.crc_permille = 1000;
+    iic_sim_aht20_set(CH_CRC, &model);
+    CHECK(measure(&sensors[CH_CRC], &t, &h) == 5);
+    CHECK(measure(&sensors[CH_CRC], &t, &h) == 5);
+    CHECK(stats_of(&sensors[CH_CRC]).crc_errors == 2);
+    model.crc_permille = 0;
+    iic_sim_aht20_set(CH_CRC, &model);
+    CHECK(measure(&sensors[CH_CRC], &t, &h) == 0 && h == 45);
+    CHECK(stats_of(&sensors[CH_CRC]).crc_errors == 2);
+
+    // Busy bloqué : pas prêt (4) après le délai, timeout compté ; lecture forcée refusée
+    iic_sim_aht20_default(&model);
+    model.stuck_busy = 1;
+    iic_sim_aht20_set(CH_BUSY, &model);
+    CHECK(measure(&sensors[CH_BUSY], &t, &h) == 4);
+    st = stats_of(&sensors[CH_BUSY]);
+    CHECK(st.busy_timeouts == 1 && st.crc_errors == 0);
+    {
+        uint32_t t_raw, h_raw;
+        CHECK(aht20_fetch_result(&sensors[CH_BUSY].handle, &t_raw, &t, &h_raw, &h) == 4);
+        CHECK(stats_of(&sensors[CH_BUSY]).busy_at_fetch == 1);
+    }
+
+    // NAK systématique : le déclenchement échoue (1), erreur de bus comptée, mesure non comptée
+    iic_sim_aht20_default(&model);
+    model.nak_permille = 1000;
+    iic_sim_aht20_set(CH_NAK, &model);
+    CHECK(measure(&sensors[CH_NAK], &t, &h) == 1);
+    st = stats_of(&sensors[CH_NAK]);
+    CHECK(st.iic_errors == 1 && st.measurements == 0);
+    {
+        uint8_t ready = 0;
+        CHECK(aht20_poll_ready(&sensors[CH_NAK].handle, &ready) == 1);
+        CHECK(stats_of(&sensors[CH_NAK]).iic_errors == 2);
+    }
+    // Les autres canaux du même bus ne sont pas touchés
+    CHECK(measure(&sensors[CH_CONST], &t, &h) == 0 && h == 45);
+
+    // Formes d'onde : les deux niveaux du carré, le triangle reste dans base +/- amplitude
+    int low = 0, high = 0, other = 0, out = 0;
+    float t_min = 1000.0f, t_max = -1000.0f;
+    for (int i = 0; i < 24; ++i) {
+        CHECK(measure(&sensors[CH_SQUARE], &t, &h) == 0);
+        if (h == 40 && t > 14.99f && t < 15.01f) low++;
+        else if (h == 60 && t > 24.99f && t < 25.01f) high++;
+        else other++;
+
+        CHECK(measure(&sensors[CH_TRIANGLE], &t, &h) == 0);
+        if (t < 5.99f || t > 14.01f) out++;
+        t_min = (t < t_min) ? t : t_min;
+        t_max = (t > t_max) ? t : t_max;
+    }
+    CHECK(low > 0 && high > 0 && other == 0);
+    CHECK(out == 0);
+    CHECK(t_max - t_min > 4.0f);
+
+    CHECK(aht20_multi_deinit(sensors, N_SENSORS) == 0);
+    return check_report("aht20");
+}
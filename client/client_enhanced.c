@@ -2,6 +2,11 @@
 #include "driver_aht20.h"
 #include "driver_aht20_interface.h"
 #include "mqtt_transport.h"
+#include "offline_buffer.h"
+#include "report_policy.h"
+#include "sample_summary.h"
+#include "scheduler.h"
+#include "reading_history.h"
 
 #include <getopt.h>
 #include <stdlib.h>
@@ -14,23 +19,64 @@
 #include <strings.h>
 #include <ctype.h>
 #include <stdint.h>
+#include <stdarg.h>
 
 #define TOPIC_DATA        "weather"          /* topic de données */
-#define TOPIC_STATUS      "weather/status"   /* topic statut online/offline */
-#define TOPIC_COMMAND     "weather/command"  /* topic pour commandes */
+#define TOPIC_STATUS      "weather/status"   /* racine du statut online/offline : weather/status/<sensor_id> */
+#define TOPIC_COMMAND     "weather/command"  /* racine des commandes (ancien topic diffusé) */
+#define TOPIC_COMMAND_ALL "weather/command/all"
+#define TOPIC_TELEMETRY   "weather/telemetry" /* compteurs I2C / capteur */
+/* Topics ciblés : weather/command/<sensor_id> et weather/command/room/<room_id> */
 #define QOS               1
-#define INTERVAL_SEC      300               /* période entre mesures (5 min) */
+#define INTERVAL_SEC      300               /* période entre mesures par défaut (5 min) */
 #define MAX_BROKER_IP_LEN 64
+#define DEFAULT_PERSIST_DIR "/home/pi/Documents/techtemp/mqtt-persist"
+#define DEFAULT_BACKLOG_FILE "/home/pi/Documents/techtemp/backlog.bin"
+#define COMMAND_MAX_AGE_SEC 120             /* capture demandée il y a plus longtemps : ignorée */
+#define BACKLOG_MAX_BATCH 50
+
+/* Options facultatives de /etc/surveillance.conf */
+typedef struct {
+    MqttPersistType persist;      /* MQTT_PERSIST=none|file|mmap */
+    char persist_dir[128];        /* MQTT_PERSIST_DIR=... */
+    char backlog_file[128];       /* BACKLOG_FILE=... (mesures non publiées) */
+    uint32_t backlog_capacity;    /* BACKLOG_CAPACITY=2016 (7 jours à 5 min) */
+    int backlog_batch;            /* BACKLOG_BATCH=20 mesures par message */
+    int backlog_drain_ms;         /* BACKLOG_DRAIN_MS=1000 entre deux lots */
+    int sample_interval_sec;      /* SAMPLE_INTERVAL_SEC=300 */
+    ReportPolicyConfig report;    /* REPORT_DEADBAND_TEMP / _HUM, REPORT_MAX_SILENCE_SEC */
+    int telemetry_interval_sec;   /* TELEMETRY_INTERVAL_SEC=900, 0 = désactivé */
+    int summary_interval_sec;     /* SUMMARY_INTERVAL_SEC=300 : résumé au lieu des mesures brutes, 0 = désactivé */
+    int sample_phase_sec;         /* SAMPLE_PHASE_SEC=-1 : décalage dans le créneau, -1 = réparti selon SENSOR_ID */
+    uint32_t history_capacity;    /* HISTORY_CAPACITY=288 mesures gardées pour le backfill, 0 = désactivé */
+} ClientOptions;
 
 /* Variables globales pour communication entre threads */
 static atomic_int g_stop = 0;
 static atomic_int g_capture_now = 0;  /* flag pour capture immédiate */
 static uint8_t g_sensor_id = 0;
 static uint8_t g_room_id = 0;
+static ClientOptions g_opts = { MQTT_PERSIST_NONE, DEFAULT_PERSIST_DIR,
+                                DEFAULT_BACKLOG_FILE, 2016, 20, 1000,
+                                INTERVAL_SEC, { 0.0f, 0.0f, 3600 }, 900, 0, -1, 288 };
+static OfflineBuffer g_backlog = { .fd = -1 };
+static ReportPolicy g_policy;
+static SampleSummary g_summary;
+static Scheduler g_sched = { -1, -1 };
+/* Séquence par démarrage : le serveur écarte les doublons (retries, redélivrance QoS1)
+   et compte les trous. boot = epoch du démarrage, seq = 1, 2, ... par message publié. */
+static uint32_t g_boot = 0;
+static uint32_t g_seq = 0;
+static ReadingHistory g_history;
+/* Demande de backfill reçue par le thread MQTT, servie par la boucle principale */
+static atomic_int g_backfill_pending = 0;
+static atomic_uint g_backfill_from = 0;
+static atomic_uint g_backfill_to = 0;
 
 static void on_signal(int signo) { 
     (void)signo; 
     g_stop = 1; 
+    scheduler_wake(&g_sched);
 }
 
 static void sleep_ms(long ms) {
@@ -42,6 +88,12 @@ static void sleep_ms(long ms) {
     }
 }
 
+static int64_t monotonic_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec;
+}
+
 static void trim_ascii_inplace(char *s) {
     char *p = s;
     while (*p && isspace((unsigned char)*p)) p++;
@@ -50,33 +102,146 @@ static void trim_ascii_inplace(char *s) {
     while (n && isspace((unsigned char)s[n-1])) s[--n] = '\0';
 }
 
-/* Callback pour les messages MQTT reçus (commandes) */
+/* Début de la valeur de "key" dans un JSON plat (espaces tolérés autour du ':') ; NULL si absente */
+static const char* json_value(const char* msg, const char* key) {
+    char quoted[32];
+    snprintf(quoted, sizeof(quoted), "\"%s\"", key);
+    for (const char* p = strstr(msg, quoted); p; p = strstr(p + 1, quoted)) {
+        const char* v = p + strlen(quoted);
+        while (isspace((unsigned char)*v)) v++;
+        if (*v != ':') continue;
+        v++;
+        while (isspace((unsigned char)*v)) v++;
+        return v;
+    }
+    return NULL;
+}
+
+/* Valeur numérique de "key" ; 0 si absente */
+static unsigned long json_ulong(const char* msg, const char* key) {
+    const char* v = json_value(msg, key);
+    return v ? strtoul(v, NULL, 10) : 0;
+}
+
+/* true si "key" vaut la chaîne expected */
+static int json_string_is(const char* msg, const char* key, const char* expected) {
+    const char* v = json_value(msg, key);
+    size_t n = strlen(expected);
+    return v && *v == '"' && strncmp(v + 1, expected, n) == 0 && v[1 + n] == '"';
+}
+
+/* {"action":"backfill","boot":..,"from":..,"to":..} : noté ici, servi par la boucle
+   principale (publier en QoS1 depuis un callback Paho bloquerait) */
+static void request_backfill(const char* msg) {
+    unsigned long boot = json_ulong(msg, "boot");
+    unsigned long from = json_ulong(msg, "from");
+    unsigned long to = json_ulong(msg, "to");
+    if (boot != g_boot || from == 0 || to < from) {
+        printf("[BACKFILL] ignored (boot %lu, current %u, seq %lu..%lu)\n", boot, g_boot, from, to);
+        return;
+    }
+    if (g_backfill_pending) {
+        if (from > g_backfill_from) from = g_backfill_from;
+        if (to < g_backfill_to) to = g_backfill_to;
+    }
+    g_backfill_from = (unsigned)from;
+    g_backfill_to = (unsigned)to;
+    g_backfill_pending = 1;
+    scheduler_wake(&g_sched);
+}
+
+/* Handler des topics de commande ciblés (le broker a déjà filtré) */
 static void on_mqtt_command(const char* topic, const void* payload, size_t len, void* user) {
     (void)user;
     
-    if (strcmp(topic, TOPIC_COMMAND) != 0) return;
-    
     char msg[256];
     if (len >= sizeof(msg)) len = sizeof(msg) - 1;
     memcpy(msg, payload, len);
     msg[len] = '\0';
     
-    printf("[COMMAND] Received: %s\n", msg);
+    printf("[COMMAND] Received on %s: %s\n", topic, msg);
     
-    // Parser la commande JSON simple
-    if (strstr(msg, "\"action\":\"capture\"") != NULL) {
-        // Vérifier si c'est pour notre capteur
-        char sensor_pattern[32];
-        snprintf(sensor_pattern, sizeof(sensor_pattern), "\"sensor_id\":%u", g_sensor_id);
-        
-        if (strstr(msg, sensor_pattern) != NULL || strstr(msg, "\"sensor_id\":\"all\"") != NULL) {
-            printf("[COMMAND] Triggering immediate capture for sensor %u\n", g_sensor_id);
-            g_capture_now = 1;
+    if (json_string_is(msg, "action", "backfill")) {
+        request_backfill(msg);
+        return;
+    }
+
+    // Session durable : le broker (ou la persistance du serveur) peut rejouer une vieille commande
+    unsigned long sent_at = json_ulong(msg, "ts");
+    if (sent_at != 0 && (long)time(NULL) - (long)sent_at > COMMAND_MAX_AGE_SEC) {
+        printf("[COMMAND] Stale command ignored (%ld s old)\n", (long)time(NULL) - (long)sent_at);
+        return;
+    }
+
+    // Payload vide ou sans "action" = capture
+    if (json_string_is(msg, "action", "capture") || json_value(msg, "action") == NULL) {
+        printf("[COMMAND] Triggering immediate capture for sensor %u\n", g_sensor_id);
+        g_capture_now = 1;
+        scheduler_wake(&g_sched);
+    } else {
+        printf("[COMMAND] Unknown action ignored\n");
+    }
+}
+
+/* Ancien topic diffusé weather/command : filtrage par sensor_id côté client */
+static void on_mqtt_command_legacy(const char* topic, const void* payload, size_t len, void* user) {
+    char msg[256];
+    if (len >= sizeof(msg)) len = sizeof(msg) - 1;
+    memcpy(msg, payload, len);
+    msg[len] = '\0';
+
+    // Vérifier si c'est pour notre capteur
+    const char* target = json_value(msg, "sensor_id");
+    if (target && (json_string_is(msg, "sensor_id", "all") ||
+                   (isdigit((unsigned char)*target) && strtoul(target, NULL, 10) == g_sensor_id))) {
+        on_mqtt_command(topic, payload, len, user);
+    }
+}
+
+/* Publie avec retries; MQTT_SEND_OK ou le dernier statut en échec */
+static MqttSendStatus publish_with_retries(const char* payload, int n) {
+    MqttSendStatus s = MQTT_SEND_RETRY_LATER;
+    for (int attempt = 0; attempt < 5 && !g_stop && mqtt_is_connected(); ++attempt) {
+        s = mqtt_publish(TOPIC_DATA, payload, (size_t)n, QOS, 0, 5000);
+        if (s == MQTT_SEND_OK) return s;
+        if (s == MQTT_SEND_ERROR) {
+            fprintf(stderr, "publish error, attempt=%d\n", attempt);
+            break;
         }
+        sleep_ms(200);
+    }
+    return s;
+}
+
+/* Publie la mesure, ou la met en attente si le broker est injoignable.
+   L'ordre est conservé : pas d'envoi direct tant que des mesures plus anciennes attendent. */
+static void send_or_queue(const char* payload, int n, time_t captured_at, uint32_t seq,
+                          float temperature, float humidity, const char* reason) {
+    int sent = offline_buffer_count(&g_backlog) == 0 && publish_with_retries(payload, n) == MQTT_SEND_OK;
+
+    OfflineReading r = { .captured_at = (int64_t)captured_at,
+                         .temperature = temperature,
+                         .humidity = humidity,
+                         .boot = g_boot,
+                         .seq = seq };
+    snprintf(r.trigger, sizeof r.trigger, "%s", reason);
+    reading_history_push(&g_history, &r);
+    if (sent) {
+        printf("[SENT] %s\n", payload);
+        return;
+    }
+    if (offline_buffer_push(&g_backlog, &r) != 0) {
+        fprintf(stderr, "[BACKLOG] reading lost (no offline buffer)\n");
+    } else {
+        printf("[BACKLOG] queued %s reading (%u pending, %u dropped)\n",
+               reason, offline_buffer_count(&g_backlog), g_backlog.dropped);
     }
 }
 
-/* Fonction pour effectuer une capture et l'envoyer */
+/* Fonction pour effectuer une capture et l'envoyer.
+   reason NULL : échantillon programmé, publié seulement si la politique le demande
+   (ou agrégé dans le résumé de la période si SUMMARY_INTERVAL_SEC est actif).
+   -1 uniquement si le capteur échoue : une panne réseau met la mesure en attente. */
 static int perform_capture_and_send(const char* reason) {
     float temperature = 0.0f;
     uint8_t humidity = 0;
@@ -86,44 +251,212 @@ static int perform_capture_and_send(const char* reason) {
         return -1;
     }
 
-    time_t now = time(NULL);
+    if (!reason && g_opts.summary_interval_sec > 0) {
+        sample_summary_add(&g_summary, temperature, (float)humidity, (int64_t)time(NULL));
+        aht20_interface_debug_print("[sample] temp: %.1f C | hum: %u%% (%d in summary)\n",
+                                    temperature, humidity, g_summary.count);
+        return 0;
+    }
+
+    int64_t mono = monotonic_sec();
+    if (!reason) {
+        reason = report_policy_check(&g_policy, temperature, (float)humidity, mono);
+        if (!reason) {
+            aht20_interface_debug_print("[sample] temp: %.1f C | hum: %u%% (within deadband)\n",
+                                        temperature, humidity);
+            return 0;
+        }
+    }
+    report_policy_commit(&g_policy, temperature, (float)humidity, mono);
+
+    int64_t capture_ms = scheduler_now_ms();
+    time_t now = (time_t)(capture_ms / 1000);
     char dt[32];
     strftime(dt, sizeof(dt), "%Y-%m-%d %H:%M:%S", localtime(&now));
     aht20_interface_debug_print("[%s] time: %s | temp: %.1f C | hum: %u%%\n",
                                 reason, dt, temperature, humidity);
 
-    char payload[200];
+    uint32_t seq = ++g_seq;
+    char payload[256];
     int n = snprintf(payload, sizeof(payload),
                      "{\"sensor_id\":%u,\"room_id\":%u,"
-                     "\"temperature\":%.2f,\"humidity\":%u,\"trigger\":\"%s\"}",
-                     g_sensor_id, g_room_id, temperature, humidity, reason);
+                     "\"temperature\":%.2f,\"humidity\":%u,\"trigger\":\"%s\","
+                     "\"ts\":%" PRId64 ",\"ts_ms\":%" PRId64 ",\"boot\":%" PRIu32 ",\"seq\":%" PRIu32 "}",
+                     g_sensor_id, g_room_id, temperature, humidity, reason,
+                     (int64_t)now, capture_ms, g_boot, seq);
                      
     if (n < 0 || n >= (int)sizeof(payload)) {
         fprintf(stderr, "payload truncated\n");
         return -1;
     }
 
-    /* Publier avec retries */
-    for (int attempt = 0; attempt < 5 && !g_stop; ++attempt) {
-        MqttSendStatus s = mqtt_publish(TOPIC_DATA,
-                                        payload, (size_t)n,
-                                        QOS, 0, 5000);
-        if (s == MQTT_SEND_OK) {
-            printf("[SENT] %s\n", payload);
-            return 0;
+    send_or_queue(payload, n, now, seq, temperature, (float)humidity, reason);
+    return 0;
+}
+
+/* Publie le résumé de la période puis le remet à zéro.
+   Format : {"sensor_id":..,"room_id":..,"trigger":"summary","boot":..,"seq":..,"period_start":..,
+             "period_end":..,"count":..,"temperature":{"min","max","mean","last"},"humidity":{...}}
+   Hors-ligne, seule la moyenne est mise en attente (format du tampon). */
+static void publish_summary(void) {
+    const SampleSummary* sm = &g_summary;
+    if (sm->count == 0) return;
+
+    float t_mean = sample_summary_mean(&sm->temperature, sm->count);
+    float h_mean = sample_summary_mean(&sm->humidity, sm->count);
+    uint32_t seq = ++g_seq;
+    char payload[448];
+    int n = snprintf(payload, sizeof payload,
+                     "{\"sensor_id\":%u,\"room_id\":%u,\"trigger\":\"summary\","
+                     "\"boot\":%" PRIu32 ",\"seq\":%" PRIu32 ","
+                     "\"period_start\":%" PRId64 ",\"period_end\":%" PRId64 ",\"count\":%d,"
+                     "\"temperature\":{\"min\":%.2f,\"max\":%.2f,\"mean\":%.2f,\"last\":%.2f},"
+                     "\"humidity\":{\"min\":%.0f,\"max\":%.0f,\"mean\":%.1f,\"last\":%.0f}}",
+                     g_sensor_id, g_room_id, g_boot, seq, sm->first_at, sm->last_at, sm->count,
+                     sm->temperature.min, sm->temperature.max, t_mean, sm->temperature.last,
+                     sm->humidity.min, sm->humidity.max, h_mean, sm->humidity.last);
+    if (n < 0 || n >= (int)sizeof payload) {
+        fprintf(stderr, "summary payload truncated\n");
+    } else {
+        send_or_queue(payload, n, (time_t)sm->last_at, seq, t_mean, h_mean, "summary");
+    }
+    sample_summary_reset(&g_summary);
+}
+
+/* snprintf à la suite de buf (n octets déjà écrits) ; -1 sans avancer n si buf est plein */
+static int payload_append(char* buf, size_t size, int* n, const char* fmt, ...) {
+    if (*n < 0 || (size_t)*n >= size) return -1;
+    va_list ap;
+    va_start(ap, fmt);
+    int w = vsnprintf(buf + *n, size - (size_t)*n, fmt, ap);
+    va_end(ap);
+    if (w < 0 || (size_t)w >= size - (size_t)*n) return -1;
+    *n += w;
+    return 0;
+}
+
+/* Publie un lot de mesures horodatées.
+   Format : {"sensor_id":..,"room_id":..,"trigger":"<trigger>","readings":[{"ts":..,...},...]} */
+static MqttSendStatus publish_batch(const char* trigger, const OfflineReading* batch, int count) {
+    char payload[128 + BACKLOG_MAX_BATCH * 128];
+    int n = 0;
+    int rc = payload_append(payload, sizeof payload, &n,
+                            "{\"sensor_id\":%u,\"room_id\":%u,\"trigger\":\"%s\",\"readings\":[",
+                            g_sensor_id, g_room_id, trigger);
+    for (int i = 0; rc == 0 && i < count; ++i) {
+        rc = payload_append(payload, sizeof payload, &n,
+                            "%s{\"ts\":%" PRId64 ",\"temperature\":%.2f,\"humidity\":%.0f,\"trigger\":\"%s\"",
+                            i ? "," : "", batch[i].captured_at, batch[i].temperature,
+                            batch[i].humidity, batch[i].trigger);
+        if (rc == 0 && batch[i].seq != 0) {
+            rc = payload_append(payload, sizeof payload, &n,
+                                ",\"boot\":%" PRIu32 ",\"seq\":%" PRIu32, batch[i].boot, batch[i].seq);
         }
-        if (s == MQTT_SEND_ERROR) {
-            fprintf(stderr, "publish error, attempt=%d\n", attempt);
-            break;
+        if (rc == 0) rc = payload_append(payload, sizeof payload, &n, "}");
+    }
+    if (rc == 0) rc = payload_append(payload, sizeof payload, &n, "]}");
+    if (rc != 0) {
+        fprintf(stderr, "%s payload truncated\n", trigger);
+        return MQTT_SEND_ERROR;
+    }
+    return publish_with_retries(payload, n);
+}
+
+/* Envoie un lot de mesures en attente, plus anciennes d'abord */
+static void drain_backlog(void) {
+    OfflineReading batch[BACKLOG_MAX_BATCH];
+    int count = offline_buffer_peek(&g_backlog, batch, g_opts.backlog_batch);
+    if (count <= 0) return;
+
+    if (publish_batch("backlog", batch, count) == MQTT_SEND_OK) {
+        offline_buffer_pop(&g_backlog, count);
+        printf("[BACKLOG] sent %d readings (%u pending)\n", count, offline_buffer_count(&g_backlog));
+    }
+}
+
+/* Republie depuis l'historique les séquences demandées par le serveur */
+static void serve_backfill(void) {
+    unsigned from = g_backfill_from, to = g_backfill_to;
+    g_backfill_pending = 0;
+
+    OfflineReading batch[BACKLOG_MAX_BATCH];
+    int sent = 0, count;
+    while ((count = reading_history_range(&g_history, g_boot, from, to, sent,
+                                          batch, g_opts.backlog_batch)) > 0) {
+        if (publish_batch("backfill", batch, count) != MQTT_SEND_OK) break;
+        sent += count;
+    }
+    printf("[BACKFILL] seq %u..%u: %d readings resent\n", from, to, sent);
+}
+
+/* Ajoute un objet {"count","errors","nak","avg_us","max_us","hist":[...]} */
+static int format_op_stats(char* buf, size_t size, const char* name, const iic_op_stats_t* o) {
+    int n = snprintf(buf, size,
+                     "\"%s\":{\"count\":%" PRIu32 ",\"errors\":%" PRIu32 ",\"nak\":%" PRIu32
+                     ",\"avg_us\":%" PRIu64 ",\"max_us\":%" PRIu32 ",\"hist\":[",
+                     name, o->count, o->errors, o->nak,
+                     o->count ? o->total_us / o->count : 0, o->max_us);
+    for (int b = 0; b < IIC_STATS_BUCKETS && n > 0 && (size_t)n < size; ++b) {
+        n += snprintf(buf + n, size - (size_t)n, "%s%" PRIu32, b ? "," : "", o->hist[b]);
+    }
+    if (n > 0 && (size_t)n < size) n += snprintf(buf + n, size - (size_t)n, "]}");
+    return n;
+}
+
+/* Compteurs cumulés depuis le démarrage (QoS 0, pas de mise en tampon) */
+static void publish_telemetry(void) {
+    static const uint32_t bounds[IIC_STATS_BUCKETS] = IIC_STATS_BUCKET_BOUNDS_US;
+    static const char* const names[IIC_OP_MAX] = { "write", "read", "combined" };
+    iic_stats_t bus;
+    aht20_stats_t chip;
+    char payload[1024];
+
+    if (aht20_basic_get_stats(&bus, &chip) != 0) return;
+
+    int n = snprintf(payload, sizeof payload,
+                     "{\"sensor_id\":%u,\"room_id\":%u,\"uptime_sec\":%" PRId64 ","
+                     "\"aht20\":{\"measurements\":%" PRIu32 ",\"iic_errors\":%" PRIu32
+                     ",\"crc_errors\":%" PRIu32 ",\"busy_timeouts\":%" PRIu32
+                     ",\"busy_at_fetch\":%" PRIu32 "},"
+                     "\"i2c\":{\"bounds_us\":[",
+                     g_sensor_id, g_room_id, monotonic_sec(),
+                     chip.measurements, chip.iic_errors, chip.crc_errors, chip.busy_timeouts, chip.busy_at_fetch);
+    for (int b = 0; b < IIC_STATS_BUCKETS && n > 0 && (size_t)n < sizeof payload; ++b) {
+        n += snprintf(payload + n, sizeof payload - (size_t)n, "%s%" PRIu32, b ? "," : "", bounds[b]);
+    }
+    if (n > 0 && (size_t)n < sizeof payload) n += snprintf(payload + n, sizeof payload - (size_t)n, "]");
+    for (int op = 0; op < IIC_OP_MAX && n > 0 && (size_t)n < sizeof payload; ++op) {
+        n += snprintf(payload + n, sizeof payload - (size_t)n, ",");
+        if ((size_t)n < sizeof payload) {
+            n += format_op_stats(payload + n, sizeof payload - (size_t)n, names[op], &bus.op[op]);
         }
-        sleep_ms(200);
     }
-    return -1;
+    if (n > 0 && (size_t)n < sizeof payload) n += snprintf(payload + n, sizeof payload - (size_t)n, "}}");
+    if (n <= 0 || (size_t)n >= sizeof payload) {
+        fprintf(stderr, "⚠️ Telemetry payload truncated\n");
+        return;
+    }
+    if (mqtt_publish(TOPIC_TELEMETRY, payload, (size_t)n, 0, 0, 2000) == MQTT_SEND_OK) {
+        printf("📈 Telemetry: %" PRIu32 " measurements, %" PRIu32 " I2C errors, %" PRIu32 " CRC errors, %" PRIu32 " busy timeouts\n",
+               chip.measurements, chip.iic_errors, chip.crc_errors, chip.busy_timeouts);
+    }
+}
+
+/* Copie la valeur après "KEY=" en retirant espaces et guillemets */
+static void copy_value(char *dst, size_t dst_size, const char *value) {
+    snprintf(dst, dst_size, "%s", value);
+    trim_ascii_inplace(dst);
+    size_t L = strlen(dst);
+    if (L >= 2 && ((dst[0] == '"' && dst[L-1] == '"') || (dst[0] == '\'' && dst[L-1] == '\''))) {
+        memmove(dst, dst + 1, L - 2);
+        dst[L - 2] = '\0';
+        trim_ascii_inplace(dst);
+    }
 }
 
 static int load_config(uint8_t *sensor_id, uint8_t *room_id,
-                       char *broker_ip, size_t ip_size) {
-    if (!sensor_id || !room_id || !broker_ip || ip_size == 0) {
+                       char *broker_ip, size_t ip_size, ClientOptions *opts) {
+    if (!sensor_id || !room_id || !broker_ip || ip_size == 0 || !opts) {
         fprintf(stderr, "load_config: invalid args\n");
         return -1;
     }
@@ -192,6 +525,59 @@ static int load_config(uint8_t *sensor_id, uint8_t *room_id,
             }
             have_broker = 1;
             fprintf(stderr, "load_config: parsed BROKER_IP -> '%s'\n", broker_ip);
+        } else if (strncmp(line, "MQTT_PERSIST=", 13) == 0) {
+            char mode[16];
+            copy_value(mode, sizeof mode, line + 13);
+            if (strcasecmp(mode, "file") == 0) {
+                opts->persist = MQTT_PERSIST_FILE;
+            } else if (strcasecmp(mode, "mmap") == 0) {
+                opts->persist = MQTT_PERSIST_MMAP;
+            } else if (strcasecmp(mode, "none") == 0) {
+                opts->persist = MQTT_PERSIST_NONE;
+            } else {
+                fprintf(stderr, "load_config: unknown MQTT_PERSIST '%s' (none|file|mmap)\n", mode);
+            }
+        } else if (strncmp(line, "MQTT_PERSIST_DIR=", 17) == 0) {
+            char dir[sizeof opts->persist_dir];
+            copy_value(dir, sizeof dir, line + 17);
+            if (dir[0] != '\0') memcpy(opts->persist_dir, dir, sizeof dir);
+        } else if (strncmp(line, "BACKLOG_FILE=", 13) == 0) {
+            char path[sizeof opts->backlog_file];
+            copy_value(path, sizeof path, line + 13);
+            if (path[0] != '\0') memcpy(opts->backlog_file, path, sizeof path);
+        } else if (strncmp(line, "BACKLOG_CAPACITY=", 17) == 0) {
+            long v = strtol(line + 17, NULL, 10);
+            if (v > 0 && v <= 1000000) opts->backlog_capacity = (uint32_t)v;
+        } else if (strncmp(line, "BACKLOG_BATCH=", 14) == 0) {
+            long v = strtol(line + 14, NULL, 10);
+            if (v > 0 && v <= BACKLOG_MAX_BATCH) opts->backlog_batch = (int)v;
+        } else if (strncmp(line, "BACKLOG_DRAIN_MS=", 17) == 0) {
+            long v = strtol(line + 17, NULL, 10);
+            if (v >= 0 && v <= 600000) opts->backlog_drain_ms = (int)v;
+        } else if (strncmp(line, "SAMPLE_INTERVAL_SEC=", 20) == 0) {
+            long v = strtol(line + 20, NULL, 10);
+            if (v >= 1 && v <= 86400) opts->sample_interval_sec = (int)v;
+        } else if (strncmp(line, "REPORT_DEADBAND_TEMP=", 21) == 0) {
+            float v = strtof(line + 21, NULL);
+            if (v >= 0.0f) opts->report.deadband_temp = v;
+        } else if (strncmp(line, "REPORT_DEADBAND_HUM=", 20) == 0) {
+            float v = strtof(line + 20, NULL);
+            if (v >= 0.0f) opts->report.deadband_hum = v;
+        } else if (strncmp(line, "REPORT_MAX_SILENCE_SEC=", 23) == 0) {
+            long v = strtol(line + 23, NULL, 10);
+            if (v >= 0 && v <= 7 * 86400) opts->report.max_silence_sec = (int)v;
+        } else if (strncmp(line, "SAMPLE_PHASE_SEC=", 17) == 0) {
+            long v = strtol(line + 17, NULL, 10);
+            if (v >= -1 && v <= 86400) opts->sample_phase_sec = (int)v;
+        } else if (strncmp(line, "HISTORY_CAPACITY=", 17) == 0) {
+            long v = strtol(line + 17, NULL, 10);
+            if (v >= 0 && v <= 100000) opts->history_capacity = (uint32_t)v;
+        } else if (strncmp(line, "SUMMARY_INTERVAL_SEC=", 21) == 0) {
+            long v = strtol(line + 21, NULL, 10);
+            if (v >= 0 && v <= 86400) opts->summary_interval_sec = (int)v;
+        } else if (strncmp(line, "TELEMETRY_INTERVAL_SEC=", 23) == 0) {
+            long v = strtol(line + 23, NULL, 10);
+            if (v >= 0 && v <= 86400) opts->telemetry_interval_sec = (int)v;
         }
     }
 
@@ -202,6 +588,7 @@ static int load_config(uint8_t *sensor_id, uint8_t *room_id,
 static void on_conn_lost(const char* cause, void* user) {
     (void)user;
     fprintf(stderr, "[mqtt] connection lost: %s\n", cause ? cause : "(unknown)");
+    scheduler_wake(&g_sched);  /* passe au tick de reconnexion */
 }
 
 static void on_delivered(int token, void* user) {
@@ -230,57 +617,97 @@ int main(void) {
 
     /* 1) Charger configuration */
     char broker_ip[MAX_BROKER_IP_LEN];
-    if (load_config(&g_sensor_id, &g_room_id, broker_ip, sizeof(broker_ip)) != 0) {
+    if (load_config(&g_sensor_id, &g_room_id, broker_ip, sizeof(broker_ip), &g_opts) != 0) {
         fprintf(stderr, "Erreur lors du chargement de /etc/surveillance.conf\n");
         return 1;
     }
 
-    /* 2) Init capteur */
+    /* 2) Init capteur (démarrage à chaud : pas d'attente si la carte tourne depuis > 500 ms) */
+    struct timespec init_t0, init_t1;
+    clock_gettime(CLOCK_MONOTONIC, &init_t0);
     if (aht20_basic_init() != 0) {
         fprintf(stderr, "AHT20 init failed\n");
         return 1;
     }
+    clock_gettime(CLOCK_MONOTONIC, &init_t1);
+    long init_ms = (init_t1.tv_sec - init_t0.tv_sec) * 1000L + (init_t1.tv_nsec - init_t0.tv_nsec) / 1000000L;
+    printf("⚡ AHT20 init: %ld ms (%u ms waiting, %s start; cold start waits 500-510 ms)\n",
+           init_ms, aht20_basic_init_wait_ms(), aht20_basic_init_wait_ms() == 0 ? "warm" : "cold");
     
     printf("🌡️ TechTemp Client Enhanced - Sensor %u, Room %u\n", g_sensor_id, g_room_id);
     printf("📡 Connecting to broker: %s\n", broker_ip);
-    printf("⏰ Auto-capture every %d seconds (%.1f min)\n", INTERVAL_SEC, INTERVAL_SEC/60.0f);
-    printf("🎛️ Command topic: %s\n", TOPIC_COMMAND);
+    printf("⏰ Auto-capture every %d seconds (%.1f min)\n",
+           g_opts.sample_interval_sec, g_opts.sample_interval_sec/60.0f);
+    if (g_opts.report.deadband_temp > 0.0f || g_opts.report.deadband_hum > 0.0f) {
+        printf("📉 Report on change: ±%.2f C / ±%.1f %%, heartbeat every %d s\n",
+               g_opts.report.deadband_temp, g_opts.report.deadband_hum, g_opts.report.max_silence_sec);
+    }
+    report_policy_init(&g_policy, &g_opts.report);
+    g_boot = offline_buffer_next_boot(g_opts.backlog_file);
+    printf("🔢 Boot %u\n", g_boot);
+    if (reading_history_init(&g_history, g_opts.history_capacity) != 0) {
+        fprintf(stderr, "⚠️ No memory for the backfill history, backfill disabled\n");
+    }
+    sample_summary_reset(&g_summary);
+    if (g_opts.summary_interval_sec > 0) {
+        printf("📊 Edge aggregation: min/max/mean/last published every %d s\n",
+               g_opts.summary_interval_sec);
+    }
+    char topic_cmd_sensor[48], topic_cmd_room[48];
+    snprintf(topic_cmd_sensor, sizeof topic_cmd_sensor, TOPIC_COMMAND "/%u", g_sensor_id);
+    snprintf(topic_cmd_room, sizeof topic_cmd_room, TOPIC_COMMAND "/room/%u", g_room_id);
+    printf("🎛️ Command topics: %s, %s, %s\n", topic_cmd_sensor, topic_cmd_room, TOPIC_COMMAND_ALL);
+    /* Un topic de statut par capteur : le broker ne retient qu'un message par topic */
+    static char topic_status[48];
+    snprintf(topic_status, sizeof topic_status, TOPIC_STATUS "/%u", g_sensor_id);
+
+    if (offline_buffer_open(&g_backlog, g_opts.backlog_file, g_opts.backlog_capacity) != 0) {
+        fprintf(stderr, "offline buffer unavailable (%s), readings will be lost while offline\n",
+                g_opts.backlog_file);
+    } else if (offline_buffer_count(&g_backlog) > 0) {
+        printf("💾 %u readings pending in %s\n", offline_buffer_count(&g_backlog), g_opts.backlog_file);
+    }
 
     /* 3) Init MQTT */
     char client_id[32];
     snprintf(client_id, sizeof(client_id), "sensor_%u", g_sensor_id);
 
-    static char will_payload[64];
+    static char will_payload[96];
     snprintf(will_payload, sizeof(will_payload),
-             "{\"sensor_id\":%u,\"status\":\"offline\"}", g_sensor_id);
+             "{\"sensor_id\":%u,\"room_id\":%u,\"status\":\"offline\"}", g_sensor_id, g_room_id);
 
     MqttWill will = {
-        .topic = TOPIC_STATUS,
+        .topic = topic_status,
         .payload = will_payload,
         .payload_len = strlen(will_payload),
         .qos = 1,
         .retained = 1
     };
 
-    const char* init_topics[] = { TOPIC_COMMAND, NULL };
-    int init_qos[] = { 1 };
+    /* Commandes : abonnements routés, effectués à la connexion.
+       Le broker ne nous livre que les commandes qui nous concernent. */
+    mqtt_subscribe_handler(topic_cmd_sensor, 1, on_mqtt_command, NULL);
+    mqtt_subscribe_handler(topic_cmd_room, 1, on_mqtt_command, NULL);
+    mqtt_subscribe_handler(TOPIC_COMMAND_ALL, 1, on_mqtt_command, NULL);
+    mqtt_subscribe_handler(TOPIC_COMMAND, 1, on_mqtt_command_legacy, NULL);
 
+    /* Avec persistance, session durable : les QoS1 en vol sont rejoués au redémarrage */
     MqttConfig cfg = {
         .address = broker_ip,
         .client_id = client_id,
         .keepalive_sec = 30,
-        .clean_session = 1,
+        .clean_session = (g_opts.persist == MQTT_PERSIST_NONE) ? 1 : 0,
         .automatic_reconnect = 1,
         .min_retry_sec = 1,
         .max_retry_sec = 30,
         .username = NULL,
         .password = NULL,
         .will = &will,
-        .persist = MQTT_PERSIST_NONE,
-        .persist_dir = NULL,
-        .init_topics = init_topics,
-        .init_qos = init_qos,
-        .on_msg = on_mqtt_command,  /* Callback pour les commandes */
+        .persist = g_opts.persist,
+        .persist_dir = g_opts.persist_dir,
+        .init_topics = NULL,
+        .init_qos = NULL,
+        .on_msg = NULL,
         .on_conn_lost = on_conn_lost,
         .on_delivered = on_delivered,
         .user = NULL,
@@ -288,38 +715,70 @@ int main(void) {
         .loop_interval_ms = 20
     };
 
+    /* Broker injoignable au démarrage : mqtt_init réussit, le thread de fond reconnecte */
     if (mqtt_init(&cfg) != 0) {
         fprintf(stderr, "mqtt_init failed\n");
+        offline_buffer_close(&g_backlog);
         aht20_basic_deinit();
         return 1;
     }
 
-    /* 4) Publier "online" */
-    char online_payload[64];
+    /* 4) Statut "online" : publié à chaque (re)connexion, le LWT l'écrase sinon */
+    char online_payload[96];
     snprintf(online_payload, sizeof(online_payload),
-             "{\"sensor_id\":%u,\"status\":\"online\"}", g_sensor_id);
-    for (int i = 0; i < 5; ++i) {
-        MqttSendStatus s = mqtt_publish(TOPIC_STATUS,
-                                        online_payload,
-                                        strlen(online_payload),
-                                        QOS, 1, 2000);
-        if (s == MQTT_SEND_OK) break;
-        if (s == MQTT_SEND_ERROR) break;
-        sleep_ms(200);
-    }
-
-    /* 5) Boucle principale */
-    int elapsed = INTERVAL_SEC; /* force une première lecture immédiate */
+             "{\"sensor_id\":%u,\"room_id\":%u,\"status\":\"online\"}", g_sensor_id, g_room_id);
+
+    /* 5) Boucle principale : sommeil jusqu'à la prochaine échéance ou un réveil
+          (commande, perte de connexion, signal). Les échantillons tombent sur des
+          créneaux alignés sur l'horloge murale, décalés par capteur. */
+    scheduler_init(&g_sched);
+    const int64_t sample_ms = (int64_t)g_opts.sample_interval_sec * 1000;
+    const int64_t summary_ms = (int64_t)g_opts.summary_interval_sec * 1000;
+    const int64_t telemetry_ms = (int64_t)g_opts.telemetry_interval_sec * 1000;
+    const int64_t phase_ms = (g_opts.sample_phase_sec >= 0)
+                                 ? ((int64_t)g_opts.sample_phase_sec * 1000) % sample_ms
+                                 : scheduler_default_phase(g_sensor_id, sample_ms);
+    printf("⏱️ Sample slots: every %d s at +%.1f s (%s)\n", g_opts.sample_interval_sec,
+           phase_ms / 1000.0, g_sched.timer_fd >= 0 ? "timerfd" : "poll fallback");
+
+    int64_t now = scheduler_now_ms();
+    int64_t next_sample = now;  /* première lecture immédiate */
+    int64_t next_summary = summary_ms > 0 ? scheduler_next_slot(now, summary_ms, phase_ms) : INT64_MAX;
+    int64_t next_telemetry = now + telemetry_ms;
+    int64_t next_drain = now;
     int exit_code = 0;
+    int was_connected = 0;
 
     while (!g_stop) {
-        /* Capture programmée toutes les 5 min */
-        if (elapsed >= INTERVAL_SEC) {
-            if (perform_capture_and_send("scheduled") != 0) {
+        int connected = mqtt_is_connected();
+        if (connected && !was_connected) {
+            for (int i = 0; i < 5; ++i) {
+                MqttSendStatus s = mqtt_publish(topic_status,
+                                                online_payload,
+                                                strlen(online_payload),
+                                                QOS, 1, 2000);
+                if (s == MQTT_SEND_OK) break;
+                if (s == MQTT_SEND_ERROR) break;
+                sleep_ms(200);
+            }
+        }
+        was_connected = connected;
+
+        /* Échantillon programmé; publié selon la politique de report */
+        now = scheduler_now_ms();
+        if (now >= next_sample) {
+            if (perform_capture_and_send(NULL) != 0) {
                 exit_code = 1;
                 break;
             }
-            elapsed = 0;
+            /* Créneau suivant calculé après la capture : ni dérive ni rattrapage en rafale */
+            next_sample = scheduler_next_slot(scheduler_now_ms(), sample_ms, phase_ms);
+        }
+
+        /* Fin de période d'agrégation */
+        if (summary_ms > 0 && now >= next_summary) {
+            publish_summary();
+            next_summary = scheduler_next_slot(scheduler_now_ms(), summary_ms, phase_ms);
         }
 
         /* Capture à la demande */
@@ -328,21 +787,54 @@ int main(void) {
             perform_capture_and_send("on-demand");
         }
 
-        /* Sommeil réactif: 100 ms x10 = 1 s */
-        for (int i = 0; i < 10 && !g_stop; ++i) {
-            sleep_ms(100);
+        /* Vidage du tampon hors-ligne au rythme configuré */
+        if (connected && offline_buffer_count(&g_backlog) > 0 && now >= next_drain) {
+            drain_backlog();
+            next_drain = scheduler_now_ms() + g_opts.backlog_drain_ms;
+        }
+
+        /* Backfill demandé par le serveur */
+        if (connected && g_backfill_pending) {
+            serve_backfill();
+        }
+
+        /* Télémétrie I2C périodique */
+        if (connected && telemetry_ms > 0 && now >= next_telemetry) {
+            publish_telemetry();
+            next_telemetry = scheduler_now_ms() + telemetry_ms;
+        }
+
+        /* Prochaine échéance ; déconnecté, un tick de 1 s détecte la reconnexion */
+        int64_t deadline = next_sample;
+        if (next_summary < deadline) deadline = next_summary;
+        if (connected && telemetry_ms > 0 && next_telemetry < deadline) deadline = next_telemetry;
+        if (connected && offline_buffer_count(&g_backlog) > 0 && next_drain < deadline) deadline = next_drain;
+        if (!connected && now + 1000 < deadline) deadline = now + 1000;
+        if (g_stop || g_capture_now || (connected && g_backfill_pending)) continue;
+
+        if (scheduler_wait_until(&g_sched, deadline) == SCHED_CLOCK_CHANGED) {
+            /* Horloge réglée (NTP au démarrage) : réaligner les créneaux */
+            now = scheduler_now_ms();
+            printf("⏱️ Wall clock changed, realigning slots\n");
+            next_sample = scheduler_next_slot(now, sample_ms, phase_ms);
+            if (summary_ms > 0) next_summary = scheduler_next_slot(now, summary_ms, phase_ms);
+            next_telemetry = now + telemetry_ms;
+            next_drain = now;
         }
-        elapsed += 1;
     }
 
-    /* 6) Publier "offline" */
-    char offline_payload[64];
+    /* 6) Période en cours, puis "offline" */
+    publish_summary();
+    char offline_payload[96];
     snprintf(offline_payload, sizeof(offline_payload),
-             "{\"sensor_id\":%u,\"status\":\"offline\"}", g_sensor_id);
-    mqtt_publish(TOPIC_STATUS, offline_payload, strlen(offline_payload), 1, 1, 2000);
+             "{\"sensor_id\":%u,\"room_id\":%u,\"status\":\"offline\"}", g_sensor_id, g_room_id);
+    mqtt_publish(topic_status, offline_payload, strlen(offline_payload), 1, 1, 2000);
 
     /* 7) Nettoyage */
     mqtt_cleanup();
+    offline_buffer_close(&g_backlog);
+    scheduler_close(&g_sched);
+    reading_history_free(&g_history);
     aht20_basic_deinit();
     printf("🛑 TechTemp Client stopped cleanly\n");
     return exit_code;
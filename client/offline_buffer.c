@@ -0,0 +1,217 @@
+/* offline_buffer.c - store-and-forward des mesures quand le broker est injoignable */
+#include "offline_buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#define OB_MAGIC   0x54544F42u   /* "BOTT" */
+#define OB_VERSION 1u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+    uint32_t dropped;
+} ObHeader;
+
+/* Enregistrement sur disque : la somme détecte une écriture interrompue
+   (coupure entre l'écriture de la mesure et celle de l'en-tête) */
+typedef struct {
+    OfflineReading reading;
+    uint32_t sum;
+    uint32_t reserved;
+} ObRecord;
+
+static uint32_t fnv1a(const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static off_t record_offset(uint32_t idx) {
+    return (off_t)sizeof(ObHeader) + (off_t)idx * (off_t)sizeof(ObRecord);
+}
+
+static int write_header(const OfflineBuffer *b) {
+    ObHeader h = { OB_MAGIC, OB_VERSION, b->capacity, b->head, b->count, b->dropped };
+    if (pwrite(b->fd, &h, sizeof h, 0) != (ssize_t)sizeof h) return -1;
+    return fdatasync(b->fd);
+}
+
+static int write_record(const OfflineBuffer *b, uint32_t idx, const OfflineReading *r) {
+    ObRecord rec = { *r, fnv1a(r, sizeof *r), 0 };
+    return pwrite(b->fd, &rec, sizeof rec, record_offset(idx)) == (ssize_t)sizeof rec ? 0 : -1;
+}
+
+/* 0 si l'enregistrement est complet, -1 s'il est illisible ou déchiré */
+static int read_record(int fd, uint32_t idx, OfflineReading *r) {
+    ObRecord rec;
+    if (pread(fd, &rec, sizeof rec, record_offset(idx)) != (ssize_t)sizeof rec ||
+        rec.sum != fnv1a(&rec.reading, sizeof rec.reading)) {
+        return -1;
+    }
+    *r = rec.reading;
+    return 0;
+}
+
+/* Réécrit le tampon compacté (head = 0) dans <path>.tmp puis rename : une coupure
+   pendant la réécriture laisse l'ancien fichier intact */
+static int rewrite(OfflineBuffer *b, const char *path, const OfflineReading *r) {
+    char tmp_path[264];
+    snprintf(tmp_path, sizeof tmp_path, "%s.tmp", path);
+    int old_fd = b->fd;
+    b->fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    int rc = (b->fd >= 0 && ftruncate(b->fd, record_offset(b->capacity)) == 0) ? 0 : -1;
+    for (uint32_t i = 0; rc == 0 && i < b->count; ++i) {
+        rc = write_record(b, i, &r[i]);
+    }
+    if (rc == 0 && write_header(b) == 0 && rename(tmp_path, path) == 0) {
+        close(old_fd);
+        return 0;
+    }
+    fprintf(stderr, "offline_buffer: cannot rewrite %s: %s\n", path, strerror(errno));
+    if (b->fd >= 0) close(b->fd);
+    unlink(tmp_path);
+    b->fd = old_fd;
+    return -1;
+}
+
+int offline_buffer_open(OfflineBuffer *b, const char *path, uint32_t capacity) {
+    if (!b || !path || capacity == 0) return -1;
+    memset(b, 0, sizeof *b);
+
+    b->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (b->fd < 0) {
+        fprintf(stderr, "offline_buffer: open(%s): %s\n", path, strerror(errno));
+        return -1;
+    }
+    b->capacity = capacity;
+
+    ObHeader h;
+    if (pread(b->fd, &h, sizeof h, 0) != (ssize_t)sizeof h ||
+        h.magic != OB_MAGIC || h.version != OB_VERSION ||
+        h.capacity == 0 || h.head >= h.capacity || h.count > h.capacity) {
+        /* fichier neuf ou illisible : repartir à vide */
+        if (ftruncate(b->fd, record_offset(capacity)) != 0 || write_header(b) != 0) {
+            offline_buffer_close(b);
+            return -1;
+        }
+        return 0;
+    }
+
+    /* Relit les mesures en attente et écarte les enregistrements déchirés */
+    OfflineReading *tmp = malloc((size_t)(h.count ? h.count : 1) * sizeof *tmp);
+    if (!tmp) {
+        offline_buffer_close(b);
+        return -1;
+    }
+    uint32_t valid = 0;
+    for (uint32_t i = 0; i < h.count; ++i) {
+        if (read_record(b->fd, (h.head + i) % h.capacity, &tmp[valid]) == 0) valid++;
+    }
+    uint32_t torn = h.count - valid;
+    if (torn) fprintf(stderr, "offline_buffer: %u torn record(s) dropped from %s\n", torn, path);
+
+    b->dropped = h.dropped + torn;
+    if (h.capacity == capacity && torn == 0) {
+        free(tmp);
+        b->head = h.head;
+        b->count = h.count;
+        return 0;
+    }
+
+    /* Capacité modifiée dans la config ou enregistrements écartés : on réécrit en gardant
+       les mesures les plus récentes */
+    uint32_t keep = (valid < capacity) ? valid : capacity;
+    uint32_t skip = valid - keep;
+    b->dropped += skip;
+    b->count = keep;
+    int rc = rewrite(b, path, tmp + skip);
+    free(tmp);
+    if (rc != 0) {
+        offline_buffer_close(b);
+        return -1;
+    }
+    return 0;
+}
+
+void offline_buffer_close(OfflineBuffer *b) {
+    if (b && b->fd >= 0) {
+        close(b->fd);
+        b->fd = -1;
+    }
+}
+
+int offline_buffer_push(OfflineBuffer *b, const OfflineReading *r) {
+    if (!b || b->fd < 0 || !r) return -1;
+
+    uint32_t idx = (b->head + b->count) % b->capacity;
+    if (b->count == b->capacity) {
+        /* plein : on écrase la plus ancienne */
+        b->head = (b->head + 1) % b->capacity;
+        b->dropped++;
+    } else {
+        b->count++;
+    }
+    if (write_record(b, idx, r) != 0) return -1;
+    return write_header(b);
+}
+
+int offline_buffer_peek(const OfflineBuffer *b, OfflineReading *out, int max) {
+    if (!b || b->fd < 0 || !out || max <= 0) return 0;
+    int n = (b->count < (uint32_t)max) ? (int)b->count : max;
+    for (int i = 0; i < n; ++i) {
+        if (read_record(b->fd, (b->head + (uint32_t)i) % b->capacity, &out[i]) != 0) return i;
+    }
+    return n;
+}
+
+int offline_buffer_pop(OfflineBuffer *b, int n) {
+    if (!b || b->fd < 0 || n < 0) return -1;
+    if ((uint32_t)n > b->count) n = (int)b->count;
+    b->head = (b->head + (uint32_t)n) % b->capacity;
+    b->count -= (uint32_t)n;
+    return write_header(b);
+}
+
+uint32_t offline_buffer_count(const OfflineBuffer *b) {
+    return (b && b->fd >= 0) ? b->count : 0;
+}
+
+uint32_t offline_buffer_next_boot(const char *path) {
+    char boot_path[256], tmp_path[264];
+    snprintf(boot_path, sizeof boot_path, "%s.boot", path);
+    snprintf(tmp_path, sizeof tmp_path, "%s.tmp", boot_path);
+
+    unsigned long last = 0;
+    FILE *f = fopen(boot_path, "r");
+    if (f) {
+        if (fscanf(f, "%lu", &last) != 1) last = 0;
+        fclose(f);
+    }
+    uint32_t boot = (uint32_t)last + 1u;
+    if (boot == 0) boot = 1;
+
+    /* Écriture atomique : fichier temporaire synchronisé puis rename */
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    char buf[16];
+    int len = snprintf(buf, sizeof buf, "%u\n", boot);
+    int ok = fd >= 0 && write(fd, buf, (size_t)len) == len && fsync(fd) == 0;
+    if (fd >= 0) close(fd);
+    if (!ok || rename(tmp_path, boot_path) != 0) {
+        fprintf(stderr, "offline_buffer: cannot save boot id in %s: %s\n", boot_path, strerror(errno));
+        unlink(tmp_path);
+    }
+    return boot;
+}
@@ -0,0 +1,39 @@
+#ifndef OFFLINE_BUFFER_H
+#define OFFLINE_BUFFER_H
+
+#include <stdint.h>
+
+/* Tampon circulaire borné sur fichier (carte SD) pour les mesures non publiées.
+   Plein => la plus ancienne mesure est écrasée. Le fichier survit aux redémarrages ;
+   à l'ouverture, les enregistrements déchirés par une coupure (somme fausse) sont écartés. */
+
+typedef struct {
+    int64_t  captured_at;   /* epoch (s) de la capture */
+    float    temperature;
+    float    humidity;
+    uint32_t boot;          /* identifiant du démarrage du client */
+    uint32_t seq;           /* numéro de séquence dans ce démarrage, 0 = aucun */
+    char     trigger[16];   /* "scheduled", "on-demand"... */
+} OfflineReading;
+
+typedef struct {
+    int      fd;
+    uint32_t capacity;
+    uint32_t head;          /* index de la plus ancienne mesure */
+    uint32_t count;
+    uint32_t dropped;       /* mesures écrasées faute de place (cumul) */
+} OfflineBuffer;
+
+int      offline_buffer_open(OfflineBuffer *b, const char *path, uint32_t capacity); /* 0 = OK */
+void     offline_buffer_close(OfflineBuffer *b);
+
+int      offline_buffer_push(OfflineBuffer *b, const OfflineReading *r);             /* 0 = OK */
+int      offline_buffer_peek(const OfflineBuffer *b, OfflineReading *out, int max);  /* nb lues, plus anciennes d'abord */
+int      offline_buffer_pop(OfflineBuffer *b, int n);                                /* 0 = OK */
+uint32_t offline_buffer_count(const OfflineBuffer *b);
+
+/* Identifiant de démarrage : compteur croissant conservé dans <path>.boot, à côté du tampon.
+   Indépendant de l'horloge (pas de RTC, heure non synchronisée au démarrage). */
+uint32_t offline_buffer_next_boot(const char *path);
+
+#endif /* OFFLINE_BUFFER_H */
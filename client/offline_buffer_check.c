@@ -0,0 +1,156 @@
+/* offline_buffer_check.c - tampon circulaire sur fichier : bouclage, enregistrement déchiré, capacité
+ *
+ * Usage : ./offline_buffer_check   (make check)
+ *
+ * Travaille sur un fichier temporaire de /tmp ; la disposition sur disque
+ * (en-tête de 6 mots, mesure suivie de sa somme et d'un mot réservé) sert à
+ * simuler une coupure au milieu d'une écriture.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "offline_buffer.h"
+#include "check.h"
+
+#define HEADER_SIZE 24
+#define RECORD_SIZE (sizeof(OfflineReading) + 8)
+
+static char path[64];
+
+static OfflineReading reading(uint32_t seq) {
+    OfflineReading r;
+    memset(&r, 0, sizeof r);
+    r.captured_at = 1760000000 + seq;
+    r.temperature = 20.0f + (float)seq / 10.0f;
+    r.humidity = 40.0f;
+    r.boot = 3;
+    r.seq = seq;
+    strcpy(r.trigger, "scheduled");
+    return r;
+}
+
+/* Les count mesures en attente portent les séquences first, first+1, ... */
+static int pending_is(const OfflineBuffer *b, uint32_t first, uint32_t count) {
+    OfflineReading out[16];
+    if (offline_buffer_peek(b, out, 16) != (int)count) return 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        OfflineReading want = reading(first + i);
+        if (memcmp(&out[i], &want, sizeof want) != 0) return 0;
+    }
+    return 1;
+}
+
+/* Écrase une partie de l'emplacement idx, comme une écriture interrompue */
+static void tear(uint32_t idx) {
+    int fd = open(path, O_RDWR);
+    const char junk[8] = "partial";
+    CHECK(fd >= 0 && pwrite(fd, junk, sizeof junk, HEADER_SIZE + idx * RECORD_SIZE + 8) == (ssize_t)sizeof junk);
+    if (fd >= 0) close(fd);
+}
+
+int main(void) {
+    OfflineBuffer b;
+    snprintf(path, sizeof path, "/tmp/offline_buffer_check.%d", (int)getpid());
+    unlink(path);
+
+    // Bouclage : capacité 4, 6 mesures => les 2 plus anciennes écrasées, ordre conservé
+    CHECK(offline_buffer_open(&b, path, 4) == 0 && offline_buffer_count(&b) == 0);
+    for (uint32_t seq = 1; seq <= 6; ++seq) {
+        OfflineReading r = reading(seq);
+        CHECK(offline_buffer_push(&b, &r) == 0);
+    }
+    CHECK(offline_buffer_count(&b) == 4 && b.dropped == 2 && b.head == 2);
+    CHECK(pending_is(&b, 3, 4));
+    CHECK(offline_buffer_pop(&b, 3) == 0 && pending_is(&b, 6, 1));
+    for (uint32_t seq = 7; seq <= 9; ++seq) {
+        OfflineReading r = reading(seq);
+        CHECK(offline_buffer_push(&b, &r) == 0);
+    }
+    CHECK(pending_is(&b, 6, 4) && b.head == 1);
+    offline_buffer_close(&b);
+
+    // Réouverture à l'identique : tête, contenu et cumul conservés
+    CHECK(offline_buffer_open(&b, path, 4) == 0);
+    CHECK(offline_buffer_count(&b) == 4 && b.head == 1 && b.dropped == 2);
+    CHECK(pending_is(&b, 6, 4));
+    offline_buffer_close(&b);
+
+    // Enregistrement déchiré (le plus récent, emplacement 0) : écarté et compté, le reste relu
+    tear(0);
+    CHECK(offline_buffer_open(&b, path, 4) == 0);
+    CHECK(offline_buffer_count(&b) == 3 && b.dropped == 3 && b.head == 0);
+    CHECK(pending_is(&b, 6, 3));
+    {
+        OfflineReading r = reading(10);
+        CHECK(offline_buffer_push(&b, &r) == 0);
+        OfflineReading out[4];
+        CHECK(offline_buffer_peek(&b, out, 4) == 4 && out[3].seq == 10);
+    }
+    offline_buffer_close(&b);
+
+    // Déchirure au milieu des mesures en attente : les voisines restent dans l'ordre
+    tear(1);
+    CHECK(offline_buffer_open(&b, path, 4) == 0 && offline_buffer_count(&b) == 3 && b.dropped == 4);
+    {
+        OfflineReading out[4];
+        CHECK(offline_buffer_peek(&b, out, 4) == 3);
+        CHECK(out[0].seq == 6 && out[1].seq == 8 && out[2].seq == 10);
+    }
+    offline_buffer_close(&b);
+
+    // Capacité réduite : les plus récentes gardées, le surplus compté
+    CHECK(offline_buffer_open(&b, path, 2) == 0);
+    CHECK(offline_buffer_count(&b) == 2 && b.dropped == 5);
+    {
+        OfflineReading out[4];
+        CHECK(offline_buffer_peek(&b, out, 4) == 2 && out[0].seq == 8 && out[1].seq == 10);
+    }
+    offline_buffer_close(&b);
+
+    // Capacité augmentée : rien de perdu, la place libre sert aux mesures suivantes
+    CHECK(offline_buffer_open(&b, path, 8) == 0 && offline_buffer_count(&b) == 2 && b.dropped == 5);
+    for (uint32_t seq = 11; seq <= 16; ++seq) {
+        OfflineReading r = reading(seq);
+        CHECK(offline_buffer_push(&b, &r) == 0);
+    }
+    CHECK(offline_buffer_count(&b) == 8 && b.dropped == 5);
+    CHECK(offline_buffer_pop(&b, 2) == 0 && pending_is(&b, 11, 6));
+    offline_buffer_close(&b);
+    {
+        char tmp_path[80];
+        snprintf(tmp_path, sizeof tmp_path, "%s.tmp", path);
+        CHECK(access(tmp_path, F_OK) != 0);     // réécriture par rename, pas de reste
+    }
+
+    // En-tête illisible : on repart à vide
+    {
+        int fd = open(path, O_WRONLY);
+        CHECK(fd >= 0 && pwrite(fd, "junk", 4, 0) == 4);
+        if (fd >= 0) close(fd);
+    }
+    CHECK(offline_buffer_open(&b, path, 4) == 0 && offline_buffer_count(&b) == 0 && b.dropped == 0);
+    offline_buffer_close(&b);
+
+    // Compteur de démarrages : croissant, conservé, réinitialisé s'il est illisible
+    char boot_path[80];
+    snprintf(boot_path, sizeof boot_path, "%s.boot", path);
+    unlink(boot_path);
+    CHECK(offline_buffer_next_boot(path) == 1);
+    CHECK(offline_buffer_next_boot(path) == 2);
+    CHECK(offline_buffer_next_boot(path) == 3);
+    {
+        FILE *f = fopen(boot_path, "w");
+        CHECK(f != NULL);
+        if (f) {
+            fputs("garbage\n", f);
+            fclose(f);
+        }
+    }
+    CHECK(offline_buffer_next_boot(path) == 1);
+
+    unlink(boot_path);
+    unlink(path);
+    return check_report("offline_buffer");
+}
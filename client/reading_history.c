@@ -0,0 +1,45 @@
+/* reading_history.c - anneau des mesures récentes pour le backfill */
+#include "reading_history.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int reading_history_init(ReadingHistory *h, uint32_t capacity) {
+    memset(h, 0, sizeof *h);
+    if (capacity == 0) return 0;    /* backfill désactivé */
+    h->items = calloc(capacity, sizeof *h->items);
+    if (!h->items) return -1;
+    h->capacity = capacity;
+    return 0;
+}
+
+void reading_history_free(ReadingHistory *h) {
+    free(h->items);
+    memset(h, 0, sizeof *h);
+}
+
+void reading_history_push(ReadingHistory *h, const OfflineReading *r) {
+    if (h->capacity == 0) return;
+    uint32_t idx = (h->head + h->count) % h->capacity;
+    if (h->count == h->capacity) {
+        h->head = (h->head + 1) % h->capacity;
+    } else {
+        h->count++;
+    }
+    h->items[idx] = *r;
+}
+
+int reading_history_range(const ReadingHistory *h, uint32_t boot, uint32_t from, uint32_t to,
+                          int skip, OfflineReading *out, int max) {
+    int n = 0;
+    for (uint32_t i = 0; i < h->count && n < max; ++i) {
+        const OfflineReading *r = &h->items[(h->head + i) % h->capacity];
+        if (r->boot != boot || r->seq < from || r->seq > to) continue;
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        out[n++] = *r;
+    }
+    return n;
+}
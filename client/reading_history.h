@@ -0,0 +1,26 @@
+#ifndef READING_HISTORY_H
+#define READING_HISTORY_H
+
+#include <stdint.h>
+#include "offline_buffer.h"
+
+/* Historique en mémoire des dernières mesures séquencées, pour répondre aux
+   demandes de backfill du serveur. Plein => la plus ancienne est écrasée. */
+
+typedef struct {
+    OfflineReading *items;
+    uint32_t capacity;
+    uint32_t head;          /* index de la plus ancienne */
+    uint32_t count;
+} ReadingHistory;
+
+int  reading_history_init(ReadingHistory *h, uint32_t capacity);    /* 0 = OK */
+void reading_history_free(ReadingHistory *h);
+void reading_history_push(ReadingHistory *h, const OfflineReading *r);
+
+/* Copie dans out les mesures du boot donné avec from <= seq <= to, dans l'ordre
+   de publication, en sautant les skip premières ; renvoie le nombre copié */
+int  reading_history_range(const ReadingHistory *h, uint32_t boot, uint32_t from, uint32_t to,
+                           int skip, OfflineReading *out, int max);
+
+#endif /* READING_HISTORY_H */
@@ -0,0 +1,28 @@
+/* report_policy.c - publication sur bande morte + heartbeat */
+#include "report_policy.h"
+
+#include <string.h>
+
+static float absf(float x) { return x < 0.0f ? -x : x; }
+
+void report_policy_init(ReportPolicy *p, const ReportPolicyConfig *cfg) {
+    memset(p, 0, sizeof *p);
+    p->cfg = *cfg;
+}
+
+const char *report_policy_check(const ReportPolicy *p, float temp, float hum, int64_t now) {
+    if (p->cfg.deadband_temp <= 0.0f && p->cfg.deadband_hum <= 0.0f) return "scheduled";
+    if (!p->has_last) return "change";
+
+    if (p->cfg.deadband_temp > 0.0f && absf(temp - p->last_temp) >= p->cfg.deadband_temp) return "change";
+    if (p->cfg.deadband_hum > 0.0f && absf(hum - p->last_hum) >= p->cfg.deadband_hum) return "change";
+    if (p->cfg.max_silence_sec > 0 && now - p->last_report >= p->cfg.max_silence_sec) return "heartbeat";
+    return NULL;
+}
+
+void report_policy_commit(ReportPolicy *p, float temp, float hum, int64_t now) {
+    p->has_last = 1;
+    p->last_temp = temp;
+    p->last_hum = hum;
+    p->last_report = now;
+}
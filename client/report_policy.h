@@ -0,0 +1,32 @@
+#ifndef REPORT_POLICY_H
+#define REPORT_POLICY_H
+
+#include <stdint.h>
+
+/* Publication sur changement : le client échantillonne souvent mais ne publie
+   que si la mesure sort de la bande morte ou si le silence dure trop longtemps.
+   Bandes mortes à 0 => publication à chaque échantillon (comportement historique). */
+
+typedef struct {
+    float deadband_temp;      /* °C, REPORT_DEADBAND_TEMP */
+    float deadband_hum;       /* %HR, REPORT_DEADBAND_HUM */
+    int   max_silence_sec;    /* heartbeat, REPORT_MAX_SILENCE_SEC */
+} ReportPolicyConfig;
+
+typedef struct {
+    ReportPolicyConfig cfg;
+    int     has_last;
+    float   last_temp;        /* dernière valeur publiée */
+    float   last_hum;
+    int64_t last_report;      /* secondes monotones */
+} ReportPolicy;
+
+void report_policy_init(ReportPolicy *p, const ReportPolicyConfig *cfg);
+
+/* Raison de publier ("scheduled", "change", "heartbeat") ou NULL si rien à publier */
+const char *report_policy_check(const ReportPolicy *p, float temp, float hum, int64_t now);
+
+/* À appeler une fois la mesure publiée (ou mise en attente) */
+void report_policy_commit(ReportPolicy *p, float temp, float hum, int64_t now);
+
+#endif /* REPORT_POLICY_H */
@@ -0,0 +1,28 @@
+/* sample_summary.c - résumé d'une période d'échantillonnage */
+#include "sample_summary.h"
+
+#include <string.h>
+
+static void metric_add(SummaryMetric *m, float v, int first) {
+    if (first || v < m->min) m->min = v;
+    if (first || v > m->max) m->max = v;
+    m->sum += v;
+    m->last = v;
+}
+
+void sample_summary_reset(SampleSummary *s) {
+    memset(s, 0, sizeof *s);
+}
+
+void sample_summary_add(SampleSummary *s, float temp, float hum, int64_t captured_at) {
+    int first = (s->count == 0);
+    if (first) s->first_at = captured_at;
+    s->last_at = captured_at;
+    metric_add(&s->temperature, temp, first);
+    metric_add(&s->humidity, hum, first);
+    s->count++;
+}
+
+float sample_summary_mean(const SummaryMetric *m, int count) {
+    return count > 0 ? m->sum / (float)count : 0.0f;
+}
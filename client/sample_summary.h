@@ -0,0 +1,28 @@
+#ifndef SAMPLE_SUMMARY_H
+#define SAMPLE_SUMMARY_H
+
+#include <stdint.h>
+
+/* Agrégation en bordure : le client échantillonne vite (ex. toutes les 5 s) et
+   ne publie qu'un résumé min/max/moyenne/dernière par période. */
+
+typedef struct {
+    float min;
+    float max;
+    float sum;
+    float last;
+} SummaryMetric;
+
+typedef struct {
+    int           count;          /* échantillons dans la période */
+    int64_t       first_at;       /* epoch (s) du premier échantillon */
+    int64_t       last_at;        /* epoch (s) du dernier échantillon */
+    SummaryMetric temperature;
+    SummaryMetric humidity;
+} SampleSummary;
+
+void  sample_summary_reset(SampleSummary *s);
+void  sample_summary_add(SampleSummary *s, float temp, float hum, int64_t captured_at);
+float sample_summary_mean(const SummaryMetric *m, int count);
+
+#endif /* SAMPLE_SUMMARY_H */
@@ -0,0 +1,108 @@
+/* scheduler.c - attente sur échéance absolue (timerfd) ou réveil (eventfd) */
+#include "scheduler.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#ifndef TFD_TIMER_CANCEL_ON_SET
+#define TFD_TIMER_CANCEL_ON_SET (1 << 1)
+#endif
+
+int scheduler_init(Scheduler *s) {
+    s->timer_fd = timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC | TFD_NONBLOCK);
+    s->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    return 0;
+}
+
+void scheduler_close(Scheduler *s) {
+    if (s->timer_fd >= 0) close(s->timer_fd);
+    if (s->event_fd >= 0) close(s->event_fd);
+    s->timer_fd = s->event_fd = -1;
+}
+
+int64_t scheduler_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int64_t scheduler_next_slot(int64_t now_ms, int64_t period_ms, int64_t phase_ms) {
+    if (period_ms <= 0) return now_ms;
+    phase_ms %= period_ms;
+    int64_t k = (now_ms - phase_ms) / period_ms;
+    int64_t t = k * period_ms + phase_ms;
+    while (t <= now_ms) t += period_ms;
+    return t;
+}
+
+int64_t scheduler_default_phase(unsigned sensor_id, int64_t period_ms) {
+    /* 2^32 / nombre d'or : fraction {id * 0.618...} en virgule fixe 32 bits */
+    uint32_t frac = (uint32_t)(sensor_id * 2654435769u);
+    return period_ms > 0 ? (int64_t)(((uint64_t)frac * (uint64_t)period_ms) >> 32) : 0;
+}
+
+void scheduler_wake(Scheduler *s) {
+    if (s->event_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t r = write(s->event_fd, &one, sizeof one);
+        (void)r;
+    }
+}
+
+SchedulerEvent scheduler_wait_until(Scheduler *s, int64_t deadline_ms) {
+    int64_t now = scheduler_now_ms();
+    if (deadline_ms <= now) return SCHED_DEADLINE;
+
+    struct pollfd fds[2];
+    int nfds = 0;
+    int timeout = -1;
+    int timer_idx = -1, event_idx = -1;
+
+    if (s->timer_fd >= 0) {
+        struct itimerspec its;
+        memset(&its, 0, sizeof its);
+        its.it_value.tv_sec = (time_t)(deadline_ms / 1000);
+        its.it_value.tv_nsec = (long)(deadline_ms % 1000) * 1000000L;
+        if (timerfd_settime(s->timer_fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &its, NULL) == 0) {
+            timer_idx = nfds;
+            fds[nfds].fd = s->timer_fd;
+            fds[nfds].events = POLLIN;
+            nfds++;
+        }
+    }
+    if (timer_idx < 0) {
+        /* Repli : délai relatif, sujet aux réglages d'horloge */
+        int64_t wait = deadline_ms - now;
+        timeout = wait > 60000 ? 60000 : (int)wait;
+    }
+    if (s->event_fd >= 0) {
+        event_idx = nfds;
+        fds[nfds].fd = s->event_fd;
+        fds[nfds].events = POLLIN;
+        nfds++;
+    }
+
+    int r = poll(nfds ? fds : NULL, (nfds_t)nfds, timeout);
+    if (r < 0) return (errno == EINTR) ? SCHED_WAKEUP : SCHED_ERROR;
+    if (r == 0) return (scheduler_now_ms() >= deadline_ms) ? SCHED_DEADLINE : SCHED_WAKEUP;
+
+    if (event_idx >= 0 && (fds[event_idx].revents & POLLIN)) {
+        uint64_t n;
+        ssize_t rd = read(s->event_fd, &n, sizeof n);
+        (void)rd;
+        return SCHED_WAKEUP;
+    }
+    if (timer_idx >= 0 && (fds[timer_idx].revents & POLLIN)) {
+        uint64_t expirations;
+        if (read(s->timer_fd, &expirations, sizeof expirations) < 0 && errno == ECANCELED) {
+            return SCHED_CLOCK_CHANGED;
+        }
+        return SCHED_DEADLINE;
+    }
+    return SCHED_WAKEUP;
+}
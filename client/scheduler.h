@@ -0,0 +1,41 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+/* Ordonnanceur à échéances absolues : le client dort jusqu'à la prochaine
+   échéance (timerfd CLOCK_REALTIME, TFD_TIMER_ABSTIME) ou jusqu'à un réveil
+   explicite (eventfd), par ex. une commande MQTT. Les échéances sont des
+   créneaux alignés sur l'horloge murale : pas de dérive cumulée. */
+
+typedef struct {
+    int timer_fd;   /* -1 : repli sur poll() avec délai relatif */
+    int event_fd;   /* -1 : pas de réveil anticipé (hors signaux) */
+} Scheduler;
+
+typedef enum {
+    SCHED_ERROR = -1,
+    SCHED_DEADLINE = 0,     /* échéance atteinte */
+    SCHED_WAKEUP,           /* scheduler_wake() ou signal */
+    SCHED_CLOCK_CHANGED     /* horloge murale réglée (NTP) : recalculer les créneaux */
+} SchedulerEvent;
+
+int  scheduler_init(Scheduler *s);                          /* 0 = OK (repli possible) */
+void scheduler_close(Scheduler *s);
+
+/* Attend jusqu'à deadline_ms (epoch, ms) ; retour immédiat si déjà passée */
+SchedulerEvent scheduler_wait_until(Scheduler *s, int64_t deadline_ms);
+
+/* Réveille scheduler_wait_until ; utilisable depuis un autre thread ou un handler de signal */
+void scheduler_wake(Scheduler *s);
+
+int64_t scheduler_now_ms(void);                             /* CLOCK_REALTIME en ms */
+
+/* Premier créneau strictement après now_ms : t = k * period_ms + phase_ms */
+int64_t scheduler_next_slot(int64_t now_ms, int64_t period_ms, int64_t phase_ms);
+
+/* Décalage par défaut dans [0, period_ms) : suite de Fibonacci (nombre d'or)
+   sur sensor_id, les capteurs successifs se répartissent uniformément */
+int64_t scheduler_default_phase(unsigned sensor_id, int64_t period_ms);
+
+#endif /* SCHEDULER_H */
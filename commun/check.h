@@ -0,0 +1,27 @@
+/* check.h - assertions des programmes de vérification (make check)
+ *
+ * Chaque *_check.c teste une unité sans broker ni réseau ; CHECK() note l'échec
+ * et continue, check_report() affiche le bilan et donne le code de sortie.
+ */
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+static int check_count;
+static int check_failures;
+
+#define CHECK(cond) do { \
+        check_count++; \
+        if (!(cond)) { \
+            check_failures++; \
+            fprintf(stderr, "%s:%d: échec : %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+static inline int check_report(const char *name) {
+    printf("%-16s %d vérifications, %d échec(s)\n", name, check_count, check_failures);
+    return check_failures ? 1 : 0;
+}
+
+#endif // CHECK_H
@@ -0,0 +1,419 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mqtt_persist_mmap.h"
+
+/* ------- Format du journal -------
+   [en-tête 16 o][rec][rec]...   rec = RecHdr + clé ('\0' inclus) + données, aligné sur 8.
+   Un PUT remplace la valeur d'une clé, un DEL la supprime; au chargement on rejoue
+   le journal et on s'arrête au premier enregistrement invalide (écriture tronquée). */
+#define LOG_MAGIC     0x544D5150u   /* "PQMT" */
+#define LOG_VERSION   1u
+#define REC_MAGIC     0x52454331u
+#define REC_PUT       1
+#define REC_DEL       2
+#define LOG_HDR_SIZE  16
+#define LOG_MIN_SIZE  (64 * 1024)
+
+typedef struct {
+    uint32_t magic;     /* écrit en dernier */
+    uint16_t type;
+    uint16_t keylen;    /* '\0' inclus */
+    uint32_t datalen;
+    uint32_t sum;       /* FNV-1a sur clé + données */
+} RecHdr;
+
+typedef struct {
+    char*    key;
+    size_t   off;       /* offset des données dans le fichier */
+    uint32_t len;
+    size_t   rec_size;
+} Entry;
+
+typedef struct {
+    int      fd;
+    char     path[512];
+    uint8_t* map;
+    size_t   map_size;
+    size_t   tail;
+    Entry*   entries;
+    int      count;
+    int      cap;
+    size_t   live_bytes;
+    size_t   dead_bytes;
+} Store;
+
+/* ------- Utilitaires ------- */
+static size_t rec_size(size_t keylen, size_t datalen) {
+    return (sizeof(RecHdr) + keylen + datalen + 7u) & ~(size_t)7u;
+}
+
+static uint32_t fnv1a(uint32_t h, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void sync_range(Store* s, size_t off, size_t len, int flags) {
+    long pg = sysconf(_SC_PAGESIZE);
+    size_t page = (pg > 0) ? (size_t)pg : 4096u;
+    size_t start = off & ~(page - 1);
+    msync(s->map + start, (off + len) - start, flags);
+}
+
+static int find_entry(const Store* s, const char* key) {
+    for (int i = 0; i < s->count; ++i) {
+        if (strcmp(s->entries[i].key, key) == 0) return i;
+    }
+    return -1;
+}
+
+static void drop_entry(Store* s, int idx) {
+    s->live_bytes -= s->entries[idx].rec_size;
+    s->dead_bytes += s->entries[idx].rec_size;
+    free(s->entries[idx].key);
+    s->entries[idx] = s->entries[--s->count];
+}
+
+static int set_entry(Store* s, const char* key, size_t off, uint32_t len, size_t rsize) {
+    int idx = find_entry(s, key);
+    if (idx >= 0) drop_entry(s, idx);
+    if (s->count == s->cap) {
+        int ncap = s->cap ? s->cap * 2 : 16;
+        Entry* n = realloc(s->entries, (size_t)ncap * sizeof(Entry));
+        if (!n) return -1;
+        s->entries = n;
+        s->cap = ncap;
+    }
+    char* k = strdup(key);
+    if (!k) return -1;
+    s->entries[s->count].key = k;
+    s->entries[s->count].off = off;
+    s->entries[s->count].len = len;
+    s->entries[s->count].rec_size = rsize;
+    s->count++;
+    s->live_bytes += rsize;
+    return 0;
+}
+
+static int map_file(Store* s, int fd, size_t size) {
+    if (ftruncate(fd, (off_t)size) != 0) return -1;
+    void* m = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (m == MAP_FAILED) return -1;
+    s->map = (uint8_t*)m;
+    s->map_size = size;
+    return 0;
+}
+
+static void write_log_header(uint8_t* map) {
+    uint32_t h[4] = { LOG_MAGIC, LOG_VERSION, 0, 0 };
+    memcpy(map, h, sizeof h);
+}
+
+/* Écrit un enregistrement à l'offset off de map (place supposée suffisante) */
+static size_t put_record(uint8_t* map, size_t off, int type, const char* key,
+                         int bufcount, char* const* bufs, const int* lens) {
+    RecHdr h;
+    size_t keylen = strlen(key) + 1;
+    size_t datalen = 0;
+    for (int i = 0; i < bufcount; ++i) datalen += (size_t)lens[i];
+
+    h.magic = 0;
+    h.type = (uint16_t)type;
+    h.keylen = (uint16_t)keylen;
+    h.datalen = (uint32_t)datalen;
+    memcpy(map + off, &h, sizeof h);
+
+    uint8_t* p = map + off + sizeof h;
+    memcpy(p, key, keylen);
+    h.sum = fnv1a(2166136261u, p, keylen);
+    p += keylen;
+    for (int i = 0; i < bufcount; ++i) {
+        memcpy(p, bufs[i], (size_t)lens[i]);
+        p += lens[i];
+    }
+    h.sum = fnv1a(h.sum, map + off + sizeof h + keylen, datalen);
+
+    /* magic en dernier : un enregistrement à moitié écrit reste invalide */
+    h.magic = REC_MAGIC;
+    memcpy(map + off, &h, sizeof h);
+    return rec_size(keylen, datalen);
+}
+
+/* Réécrit les seules entrées vivantes dans un nouveau fichier puis rename() atomique */
+static int compact(Store* s, size_t extra) {
+    char tmp[sizeof s->path + 8];
+    snprintf(tmp, sizeof tmp, "%s.tmp", s->path);
+
+    size_t need = LOG_HDR_SIZE + s->live_bytes + extra;
+    size_t size = LOG_MIN_SIZE;
+    while (size < need * 2) size *= 2;
+
+    int fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) return -1;
+
+    /* Nouveaux offsets à part : l'index ne change qu'une fois le rename() réussi */
+    size_t* offs = malloc((size_t)(s->count ? s->count : 1) * sizeof *offs);
+    Store n = *s;
+    if (!offs || map_file(&n, fd, size) != 0) {
+        free(offs);
+        close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    write_log_header(n.map);
+
+    size_t off = LOG_HDR_SIZE;
+    for (int i = 0; i < s->count; ++i) {
+        const Entry* e = &s->entries[i];
+        char* buf = (char*)(s->map + e->off);
+        int len = (int)e->len;
+        size_t key_off = off + sizeof(RecHdr);
+        size_t rs = put_record(n.map, off, REC_PUT, e->key, 1, &buf, &len);
+        offs[i] = key_off + strlen(e->key) + 1;
+        off += rs;
+    }
+    msync(n.map, off, MS_SYNC);
+    fsync(fd);
+
+    if (rename(tmp, s->path) != 0) {
+        free(offs);
+        munmap(n.map, n.map_size);
+        close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    for (int i = 0; i < s->count; ++i) s->entries[i].off = offs[i];
+    free(offs);
+    munmap(s->map, s->map_size);
+    close(s->fd);
+    s->fd = fd;
+    s->map = n.map;
+    s->map_size = n.map_size;
+    s->tail = off;
+    s->dead_bytes = 0;
+    return 0;
+}
+
+static int ensure_space(Store* s, size_t need) {
+    if (s->tail + need <= s->map_size) return 0;
+
+    if (s->dead_bytes > s->live_bytes && compact(s, need) == 0 &&
+        s->tail + need <= s->map_size) {
+        return 0;
+    }
+
+    size_t size = s->map_size;
+    while (s->tail + need > size) size *= 2;
+    munmap(s->map, s->map_size);
+    s->map = NULL;
+    return map_file(s, s->fd, size);
+}
+
+static int append(Store* s, int type, const char* key, int bufcount, char* const* bufs, const int* lens) {
+    size_t keylen = strlen(key) + 1;
+    size_t datalen = 0;
+    if (!s->map || keylen > UINT16_MAX) return -1;
+    for (int i = 0; i < bufcount; ++i) datalen += (size_t)lens[i];
+
+    if (ensure_space(s, rec_size(keylen, datalen)) != 0) return -1;
+
+    size_t off = s->tail;
+    size_t rs = put_record(s->map, off, type, key, bufcount, bufs, lens);
+    s->tail += rs;
+    sync_range(s, off, rs, MS_ASYNC);
+
+    if (type == REC_PUT) {
+        return set_entry(s, key, off + sizeof(RecHdr) + keylen, (uint32_t)datalen, rs);
+    }
+    s->dead_bytes += rs;
+    return 0;
+}
+
+/* Rejoue le journal pour reconstruire l'index en mémoire */
+static void replay(Store* s) {
+    size_t off = LOG_HDR_SIZE;
+    while (off + sizeof(RecHdr) <= s->map_size) {
+        RecHdr h;
+        memcpy(&h, s->map + off, sizeof h);
+        if (h.magic != REC_MAGIC || h.keylen == 0) break;
+        size_t rs = rec_size(h.keylen, h.datalen);
+        if (off + rs > s->map_size) break;
+
+        const char* key = (const char*)(s->map + off + sizeof h);
+        if (key[h.keylen - 1] != '\0') break;
+        uint32_t sum = fnv1a(2166136261u, key, h.keylen);
+        sum = fnv1a(sum, key + h.keylen, h.datalen);
+        if (sum != h.sum) break;
+
+        if (h.type == REC_PUT) {
+            set_entry(s, key, off + sizeof h + h.keylen, h.datalen, rs);
+        } else {
+            int idx = find_entry(s, key);
+            if (idx >= 0) drop_entry(s, idx);
+            s->dead_bytes += rs;
+        }
+        off += rs;
+    }
+    s->tail = off;
+    /* Efface la queue (écriture tronquée éventuelle) pour ne jamais la rejouer */
+    memset(s->map + off, 0, s->map_size - off);
+}
+
+/* ------- Callbacks Paho ------- */
+static int p_open(void** handle, const char* clientID, const char* serverURI, void* context) {
+    const char* dir = context ? (const char*)context : ".";
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) return MQTTCLIENT_PERSISTENCE_ERROR;
+
+    Store* s = calloc(1, sizeof *s);
+    if (!s) return MQTTCLIENT_PERSISTENCE_ERROR;
+
+    /* Même convention que la persistance fichier Paho : clientID-serveur assaini */
+    char server[128];
+    size_t j = 0;
+    for (const char* p = serverURI ? serverURI : ""; *p && j + 1 < sizeof server; ++p) {
+        server[j++] = (*p == '/' || *p == ':') ? '-' : *p;
+    }
+    server[j] = '\0';
+    int n = snprintf(s->path, sizeof s->path, "%s/%s-%s.mqlog", dir, clientID, server);
+    if (n < 0 || (size_t)n >= sizeof s->path) {
+        free(s);
+        return MQTTCLIENT_PERSISTENCE_ERROR;
+    }
+
+    s->fd = open(s->path, O_RDWR | O_CREAT, 0600);
+    if (s->fd < 0) {
+        free(s);
+        return MQTTCLIENT_PERSISTENCE_ERROR;
+    }
+
+    struct stat st;
+    size_t size = LOG_MIN_SIZE;
+    if (fstat(s->fd, &st) == 0 && (size_t)st.st_size > size) size = (size_t)st.st_size;
+    if (map_file(s, s->fd, size) != 0) {
+        close(s->fd);
+        free(s);
+        return MQTTCLIENT_PERSISTENCE_ERROR;
+    }
+
+    uint32_t magic;
+    memcpy(&magic, s->map, sizeof magic);
+    if (magic != LOG_MAGIC) {
+        memset(s->map, 0, s->map_size);
+        write_log_header(s->map);
+    }
+    replay(s);
+
+    *handle = s;
+    return 0;
+}
+
+static int p_close(void* handle) {
+    Store* s = (Store*)handle;
+    if (!s) return MQTTCLIENT_PERSISTENCE_ERROR;
+    msync(s->map, s->tail, MS_SYNC);
+    munmap(s->map, s->map_size);
+    close(s->fd);
+    for (int i = 0; i < s->count; ++i) free(s->entries[i].key);
+    free(s->entries);
+    free(s);
+    return 0;
+}
+
+static int p_put(void* handle, char* key, int bufcount, char* buffers[], int buflens[]) {
+    Store* s = (Store*)handle;
+    if (!s || !key) return MQTTCLIENT_PERSISTENCE_ERROR;
+    return append(s, REC_PUT, key, bufcount, buffers, buflens) == 0 ? 0 : MQTTCLIENT_PERSISTENCE_ERROR;
+}
+
+static int p_get(void* handle, char* key, char** buffer, int* buflen) {
+    Store* s = (Store*)handle;
+    int idx = (s && s->map && key) ? find_entry(s, key) : -1;
+    if (idx < 0) return MQTTCLIENT_PERSISTENCE_ERROR;
+
+    /* Paho libère le tampon avec free() */
+    char* out = malloc(s->entries[idx].len ? s->entries[idx].len : 1);
+    if (!out) return MQTTCLIENT_PERSISTENCE_ERROR;
+    memcpy(out, s->map + s->entries[idx].off, s->entries[idx].len);
+    *buffer = out;
+    *buflen = (int)s->entries[idx].len;
+    return 0;
+}
+
+static int p_remove(void* handle, char* key) {
+    Store* s = (Store*)handle;
+    int idx = (s && key) ? find_entry(s, key) : -1;
+    if (idx < 0) return MQTTCLIENT_PERSISTENCE_ERROR;
+    drop_entry(s, idx);
+    return append(s, REC_DEL, key, 0, NULL, NULL) == 0 ? 0 : MQTTCLIENT_PERSISTENCE_ERROR;
+}
+
+static int p_keys(void* handle, char*** keys, int* nkeys) {
+    Store* s = (Store*)handle;
+    if (!s) return MQTTCLIENT_PERSISTENCE_ERROR;
+    *keys = NULL;
+    *nkeys = 0;
+    if (s->count == 0) return 0;
+
+    char** out = malloc((size_t)s->count * sizeof(char*));
+    if (!out) return MQTTCLIENT_PERSISTENCE_ERROR;
+    for (int i = 0; i < s->count; ++i) {
+        out[i] = strdup(s->entries[i].key);
+        if (!out[i]) {
+            while (i--) free(out[i]);
+            free(out);
+            return MQTTCLIENT_PERSISTENCE_ERROR;
+        }
+    }
+    *keys = out;
+    *nkeys = s->count;
+    return 0;
+}
+
+static int p_clear(void* handle) {
+    Store* s = (Store*)handle;
+    if (!s) return MQTTCLIENT_PERSISTENCE_ERROR;
+    for (int i = 0; i < s->count; ++i) free(s->entries[i].key);
+    s->count = 0;
+    s->live_bytes = 0;
+    s->dead_bytes = 0;
+
+    munmap(s->map, s->map_size);
+    s->map = NULL;
+    if (ftruncate(s->fd, 0) != 0 || map_file(s, s->fd, LOG_MIN_SIZE) != 0) {
+        return MQTTCLIENT_PERSISTENCE_ERROR;
+    }
+    write_log_header(s->map);
+    s->tail = LOG_HDR_SIZE;
+    sync_range(s, 0, LOG_HDR_SIZE, MS_ASYNC);
+    return 0;
+}
+
+static int p_containskey(void* handle, char* key) {
+    Store* s = (Store*)handle;
+    return (s && key && find_entry(s, key) >= 0) ? 0 : MQTTCLIENT_PERSISTENCE_ERROR;
+}
+
+/* ------- API ------- */
+void mqtt_persist_mmap_init(MQTTClient_persistence* p, const char* dir) {
+    memset(p, 0, sizeof *p);
+    p->context      = (void*)dir;
+    p->popen        = p_open;
+    p->pclose       = p_close;
+    p->pput         = p_put;
+    p->pget         = p_get;
+    p->premove      = p_remove;
+    p->pkeys        = p_keys;
+    p->pclear       = p_clear;
+    p->pcontainskey = p_containskey;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "MQTTClientPersistence.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Persistance Paho "utilisateur" : un seul journal append-only mmapé par client
+   (<dir>/<client_id>-<serveur>.mqlog) au lieu d'un fichier par message.
+   Chaque put/remove ajoute un enregistrement en fin de journal; le fichier est
+   compacté quand les enregistrements morts dépassent les vivants.
+   Beaucoup moins de créations/suppressions d'inodes => moins d'usure carte SD. */
+
+/* Remplit *p avec les callbacks; dir doit rester valide tant que le client vit */
+void mqtt_persist_mmap_init(MQTTClient_persistence* p, const char* dir);
+
+#ifdef __cplusplus
+}
+#endif
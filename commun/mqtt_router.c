@@ -0,0 +1,199 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "mqtt_router.h"
+
+/* ------- Structures ------- */
+typedef struct Handler {
+    MqttOnMsg       fn;
+    void*           user;
+    struct Handler* next;
+} Handler;
+
+typedef struct Node {
+    char*        level;     /* segment littéral (NULL pour la racine, '+' et '#') */
+    size_t       level_len;
+    struct Node* children;  /* enfants littéraux, chaînés par next */
+    struct Node* next;
+    struct Node* plus;      /* enfant '+' */
+    struct Node* hash;      /* enfant '#' (toujours une feuille) */
+    Handler*     handlers;
+} Node;
+
+struct MqttRouter {
+    Node root;
+};
+
+/* ------- Utilitaires ------- */
+static const char* level_end(const char* s) {
+    const char* slash = strchr(s, '/');
+    return slash ? slash : s + strlen(s);
+}
+
+static void free_handlers(Handler* h) {
+    while (h) {
+        Handler* n = h->next;
+        free(h);
+        h = n;
+    }
+}
+
+static void free_children(Node* n) {
+    Node* c = n->children;
+    while (c) {
+        Node* next = c->next;
+        free_children(c);
+        free(c->level);
+        free(c);
+        c = next;
+    }
+    if (n->plus) { free_children(n->plus); free(n->plus); }
+    if (n->hash) { free_children(n->hash); free(n->hash); }
+    free_handlers(n->handlers);
+    n->children = n->plus = n->hash = NULL;
+    n->handlers = NULL;
+}
+
+static Node* new_node(const char* level, size_t len) {
+    Node* n = calloc(1, sizeof *n);
+    if (!n) return NULL;
+    if (level) {
+        n->level = malloc(len + 1);
+        if (!n->level) { free(n); return NULL; }
+        memcpy(n->level, level, len);
+        n->level[len] = '\0';
+        n->level_len = len;
+    }
+    return n;
+}
+
+/* Trouve (ou crée si create) le nœud fils pour le segment [s, e) */
+static Node* child(Node* parent, const char* s, const char* e, int create) {
+    size_t len = (size_t)(e - s);
+    if (len == 1 && s[0] == '+') {
+        if (!parent->plus && create) parent->plus = new_node(NULL, 0);
+        return parent->plus;
+    }
+    if (len == 1 && s[0] == '#') {
+        if (!parent->hash && create) parent->hash = new_node(NULL, 0);
+        return parent->hash;
+    }
+    for (Node* c = parent->children; c; c = c->next) {
+        if (c->level_len == len && memcmp(c->level, s, len) == 0) return c;
+    }
+    if (!create) return NULL;
+    Node* c = new_node(s, len);
+    if (!c) return NULL;
+    c->next = parent->children;
+    parent->children = c;
+    return c;
+}
+
+static int call_all(const Handler* h, const char* topic, const void* payload, size_t len) {
+    int n = 0;
+    for (; h; h = h->next, ++n) h->fn(topic, payload, len, h->user);
+    return n;
+}
+
+/* Parcours : s pointe sur le début du niveau courant du topic (ou NULL si fin) */
+static int match(const Node* n, const char* topic, const char* s, int first,
+                 const void* payload, size_t len) {
+    int calls = 0;
+    /* Les topics '$...' (ex. $SYS) ne sont jamais capturés par un wildcard de tête */
+    int wildcard_ok = !(first && s && s[0] == '$');
+
+    /* '#' couvre aussi le niveau parent ("a/#" reçoit "a") */
+    if (n->hash && wildcard_ok) calls += call_all(n->hash->handlers, topic, payload, len);
+
+    if (!s) return calls + call_all(n->handlers, topic, payload, len);
+
+    const char* e = level_end(s);
+    const char* next = (*e == '/') ? e + 1 : NULL;
+    size_t seg = (size_t)(e - s);
+
+    for (const Node* c = n->children; c; c = c->next) {
+        if (c->level_len == seg && memcmp(c->level, s, seg) == 0) {
+            calls += match(c, topic, next, 0, payload, len);
+            break;
+        }
+    }
+    if (n->plus && wildcard_ok) calls += match(n->plus, topic, next, 0, payload, len);
+    return calls;
+}
+
+/* ------- API ------- */
+MqttRouter* mqtt_router_create(void) {
+    return calloc(1, sizeof(MqttRouter));
+}
+
+void mqtt_router_destroy(MqttRouter* r) {
+    if (!r) return;
+    free_children(&r->root);
+    free(r);
+}
+
+void mqtt_router_clear(MqttRouter* r) {
+    if (r) free_children(&r->root);
+}
+
+int mqtt_topic_filter_valid(const char* filter) {
+    if (!filter || !*filter) return 0;
+    for (const char* s = filter;; ) {
+        const char* e = level_end(s);
+        for (const char* p = s; p < e; ++p) {
+            if ((*p == '+' || *p == '#') && e - s != 1) return 0;
+        }
+        if (e - s == 1 && *s == '#' && *e != '\0') return 0;
+        if (*e == '\0') return 1;
+        s = e + 1;
+    }
+}
+
+int mqtt_router_add(MqttRouter* r, const char* filter, MqttOnMsg fn, void* user) {
+    if (!r || !fn || !mqtt_topic_filter_valid(filter)) return -1;
+
+    Node* n = &r->root;
+    for (const char* s = filter;; ) {
+        const char* e = level_end(s);
+        n = child(n, s, e, 1);
+        if (!n) return -1;
+        if (*e == '\0') break;
+        s = e + 1;
+    }
+
+    Handler* h = malloc(sizeof *h);
+    if (!h) return -1;
+    h->fn = fn;
+    h->user = user;
+    h->next = NULL;
+    /* ajout en fin : ordre d'appel = ordre d'enregistrement */
+    Handler** tail = &n->handlers;
+    while (*tail) tail = &(*tail)->next;
+    *tail = h;
+    return 0;
+}
+
+int mqtt_router_remove(MqttRouter* r, const char* filter) {
+    if (!r || !mqtt_topic_filter_valid(filter)) return 0;
+
+    Node* n = &r->root;
+    for (const char* s = filter; n; ) {
+        const char* e = level_end(s);
+        n = child(n, s, e, 0);
+        if (*e == '\0') break;
+        s = e + 1;
+    }
+    if (!n) return 0;
+
+    int removed = 0;
+    for (Handler* h = n->handlers; h; h = h->next) ++removed;
+    free_handlers(n->handlers);
+    n->handlers = NULL;
+    return removed;
+}
+
+int mqtt_router_dispatch(const MqttRouter* r, const char* topic,
+                         const void* payload, size_t len) {
+    if (!r || !topic) return 0;
+    return match(&r->root, topic, topic, 1, payload, len);
+}
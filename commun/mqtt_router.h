@@ -0,0 +1,31 @@
+#pragma once
+#include <stddef.h>
+#include "mqtt_transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Routeur de topics : trie de filtres MQTT (wildcards '+' et '#').
+   Un message est comparé une seule fois à l'arbre; chaque handler dont le
+   filtre correspond est appelé directement. Non thread-safe : mqtt_transport
+   sérialise l'accès. */
+typedef struct MqttRouter MqttRouter;
+
+MqttRouter* mqtt_router_create(void);
+void        mqtt_router_destroy(MqttRouter* r);
+
+/* 1 si le filtre respecte la spec ('+' et '#' seuls sur leur niveau, '#' en dernier) */
+int mqtt_topic_filter_valid(const char* filter);
+
+int mqtt_router_add(MqttRouter* r, const char* filter, MqttOnMsg fn, void* user); /* 0 = OK */
+int mqtt_router_remove(MqttRouter* r, const char* filter);  /* nb de handlers retirés */
+void mqtt_router_clear(MqttRouter* r);
+
+/* Appelle les handlers correspondant à topic; retourne le nombre d'appels */
+int mqtt_router_dispatch(const MqttRouter* r, const char* topic,
+                         const void* payload, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,12 +7,15 @@
 #include <errno.h>
 
 #include "mqtt_transport.h"
+#include "mqtt_persist_mmap.h"
+#include "mqtt_router.h"
 #include "MQTTClient.h"
 
 /* ------- État interne ------- */
 static MQTTClient g_client = NULL;
 static pthread_mutex_t g_pub_mtx = PTHREAD_MUTEX_INITIALIZER;
 static int g_connected = 0;
+static MQTTClient_persistence g_mmap_persist; /* doit survivre au client */
 
 static MqttOnMsg       g_on_msg = NULL;
 static MqttOnConnLost  g_on_connlost = NULL;
@@ -22,6 +25,38 @@ static void*           g_user = NULL;
 static MqttLogFn       g_log = NULL;
 static void*           g_log_user = NULL;
 
+/* Routage par filtre de topic (mqtt_subscribe_handler) */
+typedef struct {
+    char* filter;
+    int   qos;
+} RoutedSub;
+
+static pthread_rwlock_t g_router_lock = PTHREAD_RWLOCK_INITIALIZER;
+static MqttRouter*      g_router = NULL;
+static RoutedSub*       g_subs = NULL;
+static int              g_nsubs = 0;
+
+/* Options de connexion conservées pour la reconnexion */
+static MQTTClient_connectOptions g_conn_opts;
+static MQTTClient_willOptions    g_will_opts;
+static char*  g_will_topic = NULL;
+static char*  g_will_payload = NULL;
+static char*  g_username = NULL;
+static char*  g_password = NULL;
+static char** g_init_topics = NULL;
+static int*   g_init_qos = NULL;
+static int    g_ninit = 0;
+
+/* Reconnexion automatique (faite par le thread de fond) */
+static int    g_auto_reconnect = 0;
+static int    g_min_retry_sec = 1;
+static int    g_max_retry_sec = 30;
+static int    g_retry_sec = 1;
+static time_t g_next_retry = 0;
+
+/* Réception du message en cours de dispatch (thread du callback Paho) */
+static _Thread_local long long g_arrival_us = 0;
+
 /* Thread de fond optionnel */
 static int g_run_bg = 0;
 static int g_loop_ms = 20;
@@ -53,14 +88,31 @@ static void delivered_cb(void *context, MQTTClient_deliveryToken dt) {
 
 static int msgarrvd_cb(void *context, char *topicName, int topicLen, MQTTClient_message *message) {
     (void)context; (void)topicLen;
-    if (g_on_msg) {
-        g_on_msg(topicName ? topicName : "", message->payload, (size_t)message->payloadlen, g_user);
+    const char* topic = topicName ? topicName : "";
+    int handled = 0;
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    g_arrival_us = (long long)now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+
+    pthread_rwlock_rdlock(&g_router_lock);
+    if (g_router) {
+        handled = mqtt_router_dispatch(g_router, topic, message->payload, (size_t)message->payloadlen);
+    }
+    pthread_rwlock_unlock(&g_router_lock);
+
+    if (!handled && g_on_msg) {
+        g_on_msg(topic, message->payload, (size_t)message->payloadlen, g_user);
     }
+    g_arrival_us = 0;
     MQTTClient_freeMessage(&message);
     MQTTClient_free(topicName);
     return 1;
 }
 
+long long mqtt_message_arrival_us(void) {
+    return g_arrival_us;
+}
+
 static void connlost_cb(void *context, char *cause) {
     (void)context;
     g_connected = 0;
@@ -68,11 +120,123 @@ static void connlost_cb(void *context, char *cause) {
     if (g_on_connlost) g_on_connlost(cause ? cause : "", g_user);
 }
 
+/* Abonne le client à tous les filtres routés */
+static void subscribe_routed(void) {
+    pthread_rwlock_rdlock(&g_router_lock);
+    for (int i = 0; i < g_nsubs; ++i) {
+        int rc = MQTTClient_subscribe(g_client, g_subs[i].filter, g_subs[i].qos);
+        if (rc != MQTTCLIENT_SUCCESS) {
+            log_msg(2, "subscribe('%s') failed rc=%d", g_subs[i].filter, rc);
+        }
+    }
+    pthread_rwlock_unlock(&g_router_lock);
+}
+
+/* Connexion + (ré)abonnements; utilisé par mqtt_init et la reconnexion */
+static int do_connect(void) {
+    pthread_mutex_lock(&g_pub_mtx);
+    int rc = MQTTClient_connect(g_client, &g_conn_opts);
+    pthread_mutex_unlock(&g_pub_mtx);
+    if (rc != MQTTCLIENT_SUCCESS) return rc;
+
+    g_connected = 1;
+    for (int i = 0; i < g_ninit; ++i) {
+        rc = MQTTClient_subscribe(g_client, g_init_topics[i], g_init_qos[i]);
+        if (rc != MQTTCLIENT_SUCCESS) {
+            log_msg(2, "subscribe('%s') failed rc=%d", g_init_topics[i], rc);
+        }
+    }
+    subscribe_routed();
+    return MQTTCLIENT_SUCCESS;
+}
+
+/* Backoff exponentiel entre min_retry_sec et max_retry_sec */
+static void try_reconnect(void) {
+    time_t now = time(NULL);
+    if (now < g_next_retry) return;
+
+    int rc = do_connect();
+    if (rc == MQTTCLIENT_SUCCESS) {
+        log_msg(5, "MQTT reconnected");
+        g_retry_sec = g_min_retry_sec;
+        return;
+    }
+    log_msg(2, "MQTT reconnect failed rc=%d, next attempt in %d s", rc, g_retry_sec);
+    g_next_retry = now + g_retry_sec;
+    g_retry_sec = (g_retry_sec * 2 < g_max_retry_sec) ? g_retry_sec * 2 : g_max_retry_sec;
+}
+
+static void free_conn_state(void) {
+    free(g_will_topic);   g_will_topic = NULL;
+    free(g_will_payload); g_will_payload = NULL;
+    free(g_username);     g_username = NULL;
+    free(g_password);     g_password = NULL;
+    for (int i = 0; i < g_ninit; ++i) free(g_init_topics[i]);
+    free(g_init_topics);  g_init_topics = NULL;
+    free(g_init_qos);     g_init_qos = NULL;
+    g_ninit = 0;
+}
+
+/* Copie la config de connexion : l'appelant n'a pas à garder ses tampons */
+static int save_conn_state(const MqttConfig* cfg) {
+    MQTTClient_connectOptions opts = MQTTClient_connectOptions_initializer;
+    g_conn_opts = opts;
+    g_conn_opts.httpsProxy = NULL;
+    g_conn_opts.keepAliveInterval = (cfg->keepalive_sec > 0) ? cfg->keepalive_sec : 20;
+    g_conn_opts.cleansession = cfg->clean_session ? 1 : 0;
+
+    if (cfg->username && !(g_username = strdup(cfg->username))) return -1;
+    if (cfg->password && !(g_password = strdup(cfg->password))) return -1;
+    g_conn_opts.username = g_username;
+    g_conn_opts.password = g_password;
+
+    /* Last Will */
+    if (cfg->will && cfg->will->topic && cfg->will->payload && cfg->will->payload_len > 0) {
+        MQTTClient_willOptions will = MQTTClient_willOptions_initializer;
+        g_will_opts = will;
+        g_will_topic = strdup(cfg->will->topic);
+        g_will_payload = malloc(cfg->will->payload_len + 1);
+        if (!g_will_topic || !g_will_payload) return -1;
+        memcpy(g_will_payload, cfg->will->payload, cfg->will->payload_len);
+        g_will_payload[cfg->will->payload_len] = '\0';
+        g_will_opts.topicName = g_will_topic;
+        g_will_opts.message   = g_will_payload;
+        g_will_opts.qos       = cfg->will->qos;
+        g_will_opts.retained  = cfg->will->retained ? 1 : 0;
+        g_conn_opts.will      = &g_will_opts;
+    }
+
+    /* Abonnements initiaux */
+    int n = 0;
+    while (cfg->init_topics && cfg->init_topics[n]) ++n;
+    if (n > 0) {
+        g_init_topics = calloc((size_t)n, sizeof(char*));
+        g_init_qos = calloc((size_t)n, sizeof(int));
+        if (!g_init_topics || !g_init_qos) return -1;
+        for (int i = 0; i < n; ++i) {
+            if (!(g_init_topics[i] = strdup(cfg->init_topics[i]))) return -1;
+            g_init_qos[i] = cfg->init_qos ? cfg->init_qos[i] : 0;
+            g_ninit = i + 1;
+        }
+    }
+
+    g_auto_reconnect = cfg->automatic_reconnect ? 1 : 0;
+    g_min_retry_sec = (cfg->min_retry_sec > 0) ? cfg->min_retry_sec : 1;
+    g_max_retry_sec = (cfg->max_retry_sec >= g_min_retry_sec) ? cfg->max_retry_sec : g_min_retry_sec;
+    g_retry_sec = g_min_retry_sec;
+    g_next_retry = 0;
+    return 0;
+}
+
 /* ------- Thread de fond ------- */
 static void* bg_loop(void* arg) {
     (void)arg;
     while (!g_bg_stop) {
-        MQTTClient_yield();
+        if (g_connected) {
+            MQTTClient_yield();
+        } else if (g_auto_reconnect) {
+            try_reconnect();
+        }
         msleep(g_loop_ms);
     }
     return NULL;
@@ -91,74 +255,68 @@ int mqtt_init(const MqttConfig* cfg) {
     if (g_client) return 0; /* déjà init */
 
     int rc;
+    int persist_type = MQTTCLIENT_PERSISTENCE_NONE;
+    void* persist_ctx = NULL;
+
+    switch (cfg->persist) {
+    case MQTT_PERSIST_FILE:
+        if (!cfg->persist_dir) return -2;
+        persist_type = MQTTCLIENT_PERSISTENCE_DEFAULT; /* contexte = répertoire */
+        persist_ctx  = (void*)cfg->persist_dir;
+        break;
+    case MQTT_PERSIST_MMAP:
+        if (!cfg->persist_dir) return -2;
+        mqtt_persist_mmap_init(&g_mmap_persist, cfg->persist_dir);
+        persist_type = MQTTCLIENT_PERSISTENCE_USER;
+        persist_ctx  = &g_mmap_persist;
+        break;
+    default:
+        break;
+    }
 
     rc = MQTTClient_create(&g_client, cfg->address, cfg->client_id,
-                           MQTTCLIENT_PERSISTENCE_NONE , NULL);
+                           persist_type, persist_ctx);
 
     if (rc != MQTTCLIENT_SUCCESS) {
         log_msg(1, "MQTTClient_create failed rc=%d", rc);
         return -3;
     }
 
-    /* ATTENTION: pour utiliser la persistance custom, Paho recommande MQTTClient_createWithOptions
-       mais MQTTClient_create + set persistence globale via build fonctionne.
-       Ici on laisse la persistance par défaut. Si vous voulez absolument filePersistence,
-       vous pouvez utiliser createWithOptions dans votre version de Paho. */
+    /* Callbacks app (avant connect : des messages retenus peuvent arriver aussitôt) */
+    g_on_msg       = cfg->on_msg;
+    g_on_connlost  = cfg->on_conn_lost;
+    g_on_delivered = cfg->on_delivered;
+    g_user         = cfg->user;
 
     MQTTClient_setCallbacks(g_client, NULL, connlost_cb, msgarrvd_cb, delivered_cb);
 
-    MQTTClient_connectOptions conn_opts = MQTTClient_connectOptions_initializer;
-
-    conn_opts.httpsProxy = NULL;
-    conn_opts.keepAliveInterval = (cfg->keepalive_sec > 0) ? cfg->keepalive_sec : 20;
-    conn_opts.cleansession = cfg->clean_session ? 1 : 0;
-
-
-    if (cfg->username) conn_opts.username = (char*)cfg->username;
-    if (cfg->password) conn_opts.password = (char*)cfg->password;
-
-    /* Last Will */
-    MQTTClient_willOptions will_opts = MQTTClient_willOptions_initializer;
-    if (cfg->will && cfg->will->topic && cfg->will->payload && cfg->will->payload_len > 0) {
-        will_opts.topicName = (char*)cfg->will->topic;
-        will_opts.message   = (char*)cfg->will->payload;
-        will_opts.qos       = cfg->will->qos;
-        will_opts.retained  = cfg->will->retained ? 1 : 0;
-        conn_opts.will      = &will_opts;
-    }
+    g_run_bg = cfg->run_background_thread ? 1 : 0;
+    g_loop_ms = (cfg->loop_interval_ms > 0) ? cfg->loop_interval_ms : 20;
 
-    rc = MQTTClient_connect(g_client, &conn_opts);
+    int oom = (save_conn_state(cfg) != 0);
+    rc = oom ? MQTTCLIENT_FAILURE : do_connect();
     if (rc != MQTTCLIENT_SUCCESS) {
         int my_errno = errno;
-    log_msg(1, "MQTTClient_connect rc=%d errno=%d (%s)", rc, my_errno, my_errno ? strerror(my_errno) : "no errno");
-        MQTTClient_destroy(&g_client);
-        g_client = NULL;
-        return -4;
-    }
-    g_connected = 1;
-    log_msg(5, "MQTT connected to %s as %s", cfg->address, cfg->client_id);
-
-    /* Abonnements initiaux */
-    if (cfg->init_topics) {
-        for (int i = 0; cfg->init_topics[i] != NULL; ++i) {
-            int qos = 0;
-            if (cfg->init_qos) qos = cfg->init_qos[i];
-            rc = MQTTClient_subscribe(g_client, cfg->init_topics[i], qos);
-            if (rc != MQTTCLIENT_SUCCESS) {
-                log_msg(2, "subscribe('%s') failed rc=%d", cfg->init_topics[i], rc);
-            }
+        if (oom) {
+            log_msg(1, "mqtt_init: out of memory");
+        } else {
+            log_msg(1, "MQTTClient_connect rc=%d errno=%d (%s)", rc, my_errno, my_errno ? strerror(my_errno) : "no errno");
         }
+        /* Avec reconnexion auto, on démarre hors ligne : le thread de fond réessaiera */
+        if (oom || !(g_auto_reconnect && g_run_bg)) {
+            MQTTClient_destroy(&g_client);
+            g_client = NULL;
+            g_on_msg = NULL; g_on_connlost = NULL; g_on_delivered = NULL; g_user = NULL;
+            free_conn_state();
+            return -4;
+        }
+        g_next_retry = time(NULL) + g_retry_sec;
+        log_msg(2, "MQTT broker %s unreachable, retrying in background", cfg->address);
+    } else {
+        log_msg(5, "MQTT connected to %s as %s", cfg->address, cfg->client_id);
     }
 
-    /* Callbacks app */
-    g_on_msg       = cfg->on_msg;
-    g_on_connlost  = cfg->on_conn_lost;
-    g_on_delivered = cfg->on_delivered;
-    g_user         = cfg->user;
-
     /* Thread de fond optionnel */
-    g_run_bg = cfg->run_background_thread ? 1 : 0;
-    g_loop_ms = (cfg->loop_interval_ms > 0) ? cfg->loop_interval_ms : 20;
     if (g_run_bg) {
         g_bg_stop = 0;
         if (pthread_create(&g_bg_thread, NULL, bg_loop, NULL) != 0) {
@@ -180,11 +338,21 @@ void mqtt_cleanup(void) {
     }
 
     /* Laisser le temps aux ACK en vol */
-    MQTTClient_disconnect(g_client, 2000);
+    if (g_connected) MQTTClient_disconnect(g_client, 2000);
     MQTTClient_destroy(&g_client);
     g_client = NULL;
     g_connected = 0;
     g_on_msg = NULL; g_on_connlost = NULL; g_on_delivered = NULL; g_user = NULL;
+    free_conn_state();
+
+    pthread_rwlock_wrlock(&g_router_lock);
+    for (int i = 0; i < g_nsubs; ++i) free(g_subs[i].filter);
+    free(g_subs);
+    g_subs = NULL;
+    g_nsubs = 0;
+    mqtt_router_destroy(g_router);
+    g_router = NULL;
+    pthread_rwlock_unlock(&g_router_lock);
 }
 
 int mqtt_subscribe(const char* topic, int qos) {
@@ -199,11 +367,65 @@ int mqtt_unsubscribe(const char* topic) {
     return (rc == MQTTCLIENT_SUCCESS) ? 0 : rc;
 }
 
+int mqtt_subscribe_handler(const char* topic_filter, int qos, MqttOnMsg fn, void* user) {
+    if (!fn || !mqtt_topic_filter_valid(topic_filter)) return -1;
+    qos = (qos>=0 && qos<=2) ? qos : 0;
+
+    pthread_rwlock_wrlock(&g_router_lock);
+    if (!g_router) g_router = mqtt_router_create();
+    int known = -1;
+    for (int i = 0; i < g_nsubs; ++i) {
+        if (strcmp(g_subs[i].filter, topic_filter) == 0) { known = i; break; }
+    }
+    int rc = g_router ? mqtt_router_add(g_router, topic_filter, fn, user) : -1;
+    if (rc == 0 && known < 0) {
+        RoutedSub* n = realloc(g_subs, (size_t)(g_nsubs + 1) * sizeof *n);
+        char* f = strdup(topic_filter);
+        if (n) g_subs = n;
+        if (!n || !f) {
+            free(f);
+            mqtt_router_remove(g_router, topic_filter);
+            rc = -1;
+        } else {
+            g_subs[g_nsubs].filter = f;
+            g_subs[g_nsubs].qos = qos;
+            g_nsubs++;
+        }
+    } else if (rc == 0 && qos > g_subs[known].qos) {
+        g_subs[known].qos = qos;
+    }
+    pthread_rwlock_unlock(&g_router_lock);
+    if (rc != 0) return -1;
+
+    /* Pas (encore) connecté : l'abonnement sera fait à la connexion */
+    if (!g_client || !g_connected) return 0;
+    return mqtt_subscribe(topic_filter, qos);
+}
+
+int mqtt_unsubscribe_handler(const char* topic_filter) {
+    if (!topic_filter) return -1;
+
+    pthread_rwlock_wrlock(&g_router_lock);
+    int removed = mqtt_router_remove(g_router, topic_filter);
+    for (int i = 0; i < g_nsubs; ++i) {
+        if (strcmp(g_subs[i].filter, topic_filter) == 0) {
+            free(g_subs[i].filter);
+            g_subs[i] = g_subs[--g_nsubs];
+            break;
+        }
+    }
+    pthread_rwlock_unlock(&g_router_lock);
+
+    if (!removed) return -1;
+    return g_client ? mqtt_unsubscribe(topic_filter) : 0;
+}
+
 MqttSendStatus mqtt_publish(const char* topic,
                             const void* payload, size_t len,
                             int qos, int retained, int timeout_ms)
 {
     if (!g_client || !topic || (!payload && len>0)) return MQTT_SEND_ERROR;
+    if (!g_connected) return MQTT_SEND_RETRY_LATER; /* reconnexion en cours */
 
     MQTTClient_message msg = MQTTClient_message_initializer;
     MQTTClient_deliveryToken token = 0;
@@ -28,10 +28,11 @@ typedef struct {
   int         retained;   /* 0/1 */
 } MqttWill;
 
-/* Persistance (Paho file persistence) */
+/* Persistance des messages QoS1/2 en vol (survit à un redémarrage si clean_session = 0) */
 typedef enum {
   MQTT_PERSIST_NONE = 0,
-  MQTT_PERSIST_FILE
+  MQTT_PERSIST_FILE,       /* persistance fichier Paho : un fichier par message */
+  MQTT_PERSIST_MMAP        /* journal append-only mmapé unique (mqtt_persist_mmap.h) */
 } MqttPersistType;
 
 /* Configuration */
@@ -40,8 +41,9 @@ typedef struct {
   const char* client_id;      /* unique par device */
   int keepalive_sec;          /* ex: 20 */
   int clean_session;          /* 1 conseillé côté edge */
-  int automatic_reconnect;    /* 1 pour auto-reconnect Paho */
-  int min_retry_sec;          /* 1 */
+  int automatic_reconnect;    /* 1 => reconnexion par le thread de fond (requis);
+                                 mqtt_init réussit alors même broker injoignable */
+  int min_retry_sec;          /* 1  (backoff exponentiel entre les deux) */
   int max_retry_sec;          /* 30 */
 
   /* Auth optionnelle */
@@ -53,7 +55,7 @@ typedef struct {
 
   /* Persistance */
   MqttPersistType persist;
-  const char* persist_dir;    /* requis si persist = FILE */
+  const char* persist_dir;    /* requis si persist = FILE ou MMAP */
 
   /* Abonnements initiaux (peuvent être NULL) */
   const char* const* init_topics; /* tableau de C strings, terminé par NULL */
@@ -71,7 +73,7 @@ typedef struct {
 } MqttConfig;
 
 /* API */
-int  mqtt_init(const MqttConfig* cfg);                 /* 0 = OK */
+int  mqtt_init(const MqttConfig* cfg);                 /* 0 = OK, -2 = persist_dir manquant */
 void mqtt_cleanup(void);
 
 int  mqtt_is_connected(void);                          /* 1 si connecté */
@@ -79,6 +81,13 @@ int  mqtt_is_connected(void);                          /* 1 si connecté */
 int  mqtt_subscribe(const char* topic, int qos);       /* 0 = OK */
 int  mqtt_unsubscribe(const char* topic);              /* 0 = OK */
 
+/* Abonnement routé : fn ne reçoit que les messages correspondant à topic_filter
+   ('+' et '#' acceptés). Utilisable avant mqtt_init (abonné à la connexion).
+   Les messages sans handler correspondant vont à cfg->on_msg.
+   Ne pas (dés)enregistrer de handler depuis un handler. */
+int  mqtt_subscribe_handler(const char* topic_filter, int qos, MqttOnMsg fn, void* user); /* 0 = OK */
+int  mqtt_unsubscribe_handler(const char* topic_filter);                                 /* 0 = OK */
+
 /* Publication binaire/texte */
 MqttSendStatus mqtt_publish(const char* topic,
                             const void* payload, size_t len,
@@ -88,6 +97,10 @@ MqttSendStatus mqtt_publish_str(const char* topic,
                                 const char* s,
                                 int qos, int retained, int timeout_ms);
 
+/* Heure de réception (µs epoch, CLOCK_REALTIME) du message en cours de traitement ;
+   valable seulement depuis un callback de message, 0 ailleurs */
+long long mqtt_message_arrival_us(void);
+
 /* Si vous ne lancez pas le thread interne, appelez régulièrement mqtt_loop() */
 void mqtt_loop(void);
 
@@ -53,6 +53,14 @@
  */
 #define AHT20_ADDRESS             0x70        /**< iic device address */
 
+/**
+ * @brief measurement timing definition
+ */
+#define AHT20_CONVERSION_TYP_MS   75          /**< first wait before the conversion time is learned */
+#define AHT20_POLL_INTERVAL_MS    5           /**< busy bit polling period */
+#define AHT20_MEASURE_TIMEOUT_MS  200         /**< max conversion wait */
+#define AHT20_POWER_ON_MS         500         /**< power-on wait before the first access */
+
 /**
  * @brief      read bytes
  * @param[in]  *handle points to an aht20 handle structure
@@ -65,8 +73,15 @@
  */
 static uint8_t a_aht20_iic_read(aht20_handle_t *handle, uint8_t *data, uint16_t len)
 {
+    if ((handle->iic_select != NULL) &&
+        (handle->iic_select(handle->iic_user) != 0))                /* select the device */
+    {
+        return 1;                                                   /* return error */
+    }
     if (handle->iic_read_cmd(AHT20_ADDRESS, data, len) != 0)        /* read the register */
     {
+        handle->stats.iic_errors++;                                 /* count the failure */
+        
         return 1;                                                   /* return error */
     }
     else
@@ -87,8 +102,15 @@ static uint8_t a_aht20_iic_read(aht20_handle_t *handle, uint8_t *data, uint16_t
  */
 static uint8_t a_aht20_iic_write(aht20_handle_t *handle, uint8_t *data, uint16_t len)
 {
+    if ((handle->iic_select != NULL) &&
+        (handle->iic_select(handle->iic_user) != 0))                 /* select the device */
+    {
+        return 1;                                                    /* return error */
+    }
     if (handle->iic_write_cmd(AHT20_ADDRESS, data, len) != 0)        /* write the register */
     {
+        handle->stats.iic_errors++;                                  /* count the failure */
+        
         return 1;                                                    /* return error */
     }
     else
@@ -182,6 +204,7 @@ static uint8_t a_aht20_jh_reset_reg(aht20_handle_t *handle, uint8_t addr)
 uint8_t aht20_init(aht20_handle_t *handle)
 {
     uint8_t status;
+    uint32_t powered;
     
     if (handle == NULL)                                                /* check handle */
     {
@@ -222,13 +245,27 @@ uint8_t aht20_init(aht20_handle_t *handle)
         return 3;                                                      /* return error */
     }
     
+    if (handle->iic_select != NULL)                                    /* several devices share the interface */
+    {
+        (void)handle->iic_select(handle->iic_user);                    /* target this device before opening */
+    }
     if (handle->iic_init() != 0)                                       /* iic init */
     {
         handle->debug_print("aht20: iic init failed.\n");              /* iic init failed */
         
         return 1;                                                      /* return error */
     }
-    handle->delay_ms(500);                                             /* wait for 500 ms */
+    handle->init_wait_ms = AHT20_POWER_ON_MS;                          /* cold start by default */
+    if (handle->powered_ms != NULL)                                    /* time since power-on known */
+    {
+        powered = handle->powered_ms();                                /* get the powered time */
+        handle->init_wait_ms = (powered >= AHT20_POWER_ON_MS) ? 0 :
+                               (uint16_t)(AHT20_POWER_ON_MS - powered);/* wait only the remaining time */
+    }
+    if (handle->init_wait_ms != 0)
+    {
+        handle->delay_ms(handle->init_wait_ms);                        /* wait for power-on */
+    }
     if (a_aht20_iic_read(handle, &status, 1) != 0)                     /* read the status */
     {
         handle->debug_print("aht20: read status failed.\n");           /* read status failed */
@@ -259,8 +296,9 @@ uint8_t aht20_init(aht20_handle_t *handle)
             
             return 5;                                                  /* return error */
         }
+        handle->delay_ms(10);                                          /* delay 10ms */
+        handle->init_wait_ms += 10;                                    /* count the settle time */
     }
-    handle->delay_ms(10);                                              /* delay 10ms */
     handle->inited = 1;                                                /* flag finish initialization */
     
     return 0;                                                          /* success return 0 */
@@ -287,6 +325,10 @@ uint8_t aht20_deinit(aht20_handle_t *handle)
         return 3;                                                  /* return error */
     }
     
+    if (handle->iic_select != NULL)                                /* several devices share the interface */
+    {
+        (void)handle->iic_select(handle->iic_user);                /* target this device before closing */
+    }
     if (handle->iic_deinit() != 0)                                 /* iic deinit */
     {
         handle->debug_print("aht20: iic deinit failed.\n");        /* iic deinit failed */
@@ -299,26 +341,45 @@ uint8_t aht20_deinit(aht20_handle_t *handle)
 }
 
 /**
- * @brief      read the temperature and humidity data
- * @param[in]  *handle points to an aht20 handle structure
+ * @brief      convert a 7 bytes measurement frame
+ * @param[in]  *buf points to a data buffer
  * @param[out] *temperature_raw points to a raw temperature buffer
  * @param[out] *temperature_s points to a converted temperature buffer
  * @param[out] *humidity_raw points to a raw humidity buffer
  * @param[out] *humidity_s points to a converted humidity buffer
- * @return     status code
- *             - 0 success
- *             - 1 read temperature humidity failed
- *             - 2 handle is NULL
- *             - 3 handle is not initialized
- *             - 4 data is not ready
- *             - 5 crc is error
  * @note       none
  */
-uint8_t aht20_read_temperature_humidity(aht20_handle_t *handle, uint32_t *temperature_raw, float *temperature_s,
-                                        uint32_t *humidity_raw, uint8_t *humidity_s)
+static void a_aht20_convert(uint8_t *buf, uint32_t *temperature_raw, float *temperature_s,
+                            uint32_t *humidity_raw, uint8_t *humidity_s)
 {
-    uint8_t status;
-    uint8_t buf[7];
+    *humidity_raw = (((uint32_t)buf[1]) << 16) |
+                    (((uint32_t)buf[2]) << 8) |
+                    (((uint32_t)buf[3]) << 0);                        /* set the humidity */
+    *humidity_raw = (*humidity_raw) >> 4;                             /* right shift 4 */
+    *humidity_s = (uint8_t)((float)(*humidity_raw)
+                            / 1048576.0f * 100.0f + 0.5f);            /* convert the humidity, rounded */
+    *temperature_raw = (((uint32_t)buf[3]) << 16) |
+                       (((uint32_t)buf[4]) << 8) |
+                       (((uint32_t)buf[5]) << 0);                     /* set the temperature */
+    *temperature_raw = (*temperature_raw) & 0xFFFFF;                  /* cut the temperature part */
+    *temperature_s = (float)(*temperature_raw) 
+                             / 1048576.0f * 200.0f
+                             - 50.0f;                                 /* right shift 4 */
+}
+
+/**
+ * @brief     start a measurement
+ * @param[in] *handle points to an aht20 handle structure
+ * @return    status code
+ *            - 0 success
+ *            - 1 sent command failed
+ *            - 2 handle is NULL
+ *            - 3 handle is not initialized
+ * @note      the conversion takes about 80ms, use aht20_poll_ready or aht20_wait_ready
+ */
+uint8_t aht20_start_measurement(aht20_handle_t *handle)
+{
+    uint8_t buf[3];
     
     if (handle == NULL)                                               /* check handle */
     {
@@ -329,6 +390,7 @@ uint8_t aht20_read_temperature_humidity(aht20_handle_t *handle, uint32_t *temper
         return 3;                                                     /* return error */
     }
     
+    handle->frame_valid = 0;                                          /* drop the previous frame */
     buf[0] = 0xAC;                                                    /* set the addr */
     buf[1] = 0x33;                                                    /* set 0x33 */
     buf[2] = 0x00;                                                    /* set 0x00 */
@@ -338,69 +400,137 @@ uint8_t aht20_read_temperature_humidity(aht20_handle_t *handle, uint32_t *temper
         
         return 1;                                                     /* return error */
     }
-    handle->delay_ms(85);                                             /* delay 85ms */
-    if (a_aht20_iic_read(handle, &status, 1) != 0)                    /* read the status */
+    handle->stats.measurements++;                                     /* count the measurement */
+    
+    return 0;                                                         /* success return 0 */
+}
+
+/**
+ * @brief      check if the measurement is finished
+ * @param[in]  *handle points to an aht20 handle structure
+ * @param[out] *ready points to a ready flag buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 read status failed
+ *             - 2 handle is NULL
+ *             - 3 handle is not initialized
+ * @note       ready is 1 when the busy bit is cleared, the status byte is the first byte of
+ *             the result frame so the whole frame is read and kept for aht20_fetch_result
+ */
+uint8_t aht20_poll_ready(aht20_handle_t *handle, uint8_t *ready)
+{
+    if (handle == NULL)                                               /* check handle */
+    {
+        return 2;                                                     /* return error */
+    }
+    if (handle->inited != 1)                                          /* check handle initialization */
+    {
+        return 3;                                                     /* return error */
+    }
+    
+    handle->frame_valid = 0;                                          /* drop the previous frame */
+    if (a_aht20_iic_read(handle, handle->frame, 7) != 0)              /* read the status and the data */
     {
         handle->debug_print("aht20: read status failed.\n");          /* read status failed */
         
         return 1;                                                     /* return error */
     }
-    if ((status & 0x80) == 0)                                         /* check the status */
+    *ready = ((handle->frame[0] & 0x80) == 0) ? 1 : 0;                /* check the busy bit */
+    handle->frame_valid = *ready;                                     /* keep the finished frame */
+    
+    return 0;                                                         /* success return 0 */
+}
+
+/**
+ * @brief     wait for the end of the measurement
+ * @param[in] *handle points to an aht20 handle structure
+ * @param[in] timeout_ms is the max wait time in ms
+ * @return    status code
+ *            - 0 success
+ *            - 1 read status failed
+ *            - 2 handle is NULL
+ *            - 3 handle is not initialized
+ *            - 4 data is not ready
+ * @note      call it right after aht20_start_measurement, the first sleep is the
+ *            conversion time learned from the previous measurements, then the busy
+ *            bit is polled every AHT20_POLL_INTERVAL_MS
+ */
+uint8_t aht20_wait_ready(aht20_handle_t *handle, uint32_t timeout_ms)
+{
+    uint8_t res;
+    uint8_t ready;
+    uint32_t wait;
+    uint32_t elapsed;
+    
+    if (handle == NULL)                                               /* check handle */
+    {
+        return 2;                                                     /* return error */
+    }
+    if (handle->inited != 1)                                          /* check handle initialization */
+    {
+        return 3;                                                     /* return error */
+    }
+    
+    wait = (handle->conversion_ms != 0) ? handle->conversion_ms
+                                        : AHT20_CONVERSION_TYP_MS;    /* learned conversion time */
+    if (wait > timeout_ms)                                            /* check the timeout */
+    {
+        wait = timeout_ms;                                            /* limit to timeout */
+    }
+    handle->delay_ms(wait);                                           /* first delay */
+    elapsed = wait;                                                   /* save elapsed */
+    while (1)
     {
-        if (a_aht20_iic_read(handle, buf, 7) != 0)                    /* read data */
+        res = aht20_poll_ready(handle, &ready);                       /* read the busy bit */
+        if (res != 0)
         {
-            handle->debug_print("aht20: read data failed.\n");        /* read data failed */
+            return res;                                               /* return error */
+        }
+        if (ready != 0)                                               /* conversion finished */
+        {
+            if (elapsed == wait && wait > AHT20_POLL_INTERVAL_MS)     /* ready at first poll */
+            {
+                handle->conversion_ms = (uint16_t)(wait - AHT20_POLL_INTERVAL_MS);   /* try earlier next time */
+            }
+            else
+            {
+                handle->conversion_ms = (uint16_t)elapsed;            /* learn the conversion time */
+            }
             
-            return 1;                                                 /* return error */
+            return 0;                                                 /* success return 0 */
         }
-        if (a_aht20_calc_crc(buf, 6) != buf[6])                       /* check the crc */
+        if (elapsed >= timeout_ms)                                    /* check the timeout */
         {
-            handle->debug_print("aht20: crc is error.\n");            /* crc is error */
+            handle->debug_print("aht20: data is not ready.\n");       /* data is not ready */
+            handle->stats.busy_timeouts++;                            /* count the timeout */
             
-            return 5;                                                 /* return error */
+            return 4;                                                 /* return error */
         }
-        
-        *humidity_raw = (((uint32_t)buf[1]) << 16) |
-                        (((uint32_t)buf[2]) << 8) |
-                        (((uint32_t)buf[3]) << 0);                    /* set the humidity */
-        *humidity_raw = (*humidity_raw) >> 4;                         /* right shift 4 */
-        *humidity_s = (uint8_t)((float)(*humidity_raw)
-                                / 1048576.0f * 100.0f);               /* convert the humidity */
-        *temperature_raw = (((uint32_t)buf[3]) << 16) |
-                           (((uint32_t)buf[4]) << 8) |
-                           (((uint32_t)buf[5]) << 0);                 /* set the temperature */
-        *temperature_raw = (*temperature_raw) & 0xFFFFF;              /* cut the temperature part */
-        *temperature_s = (float)(*temperature_raw) 
-                                 / 1048576.0f * 200.0f
-                                 - 50.0f;                             /* right shift 4 */
-        
-        return 0;                                                     /* success return 0 */
-    }
-    else
-    {
-        handle->debug_print("aht20: data is not ready.\n");           /* data is not ready */
-        
-        return 4;                                                     /* return error */
+        handle->delay_ms(AHT20_POLL_INTERVAL_MS);                     /* poll delay */
+        elapsed += AHT20_POLL_INTERVAL_MS;                            /* update elapsed */
     }
 }
 
 /**
- * @brief      read the temperature
+ * @brief      read the measurement result
  * @param[in]  *handle points to an aht20 handle structure
  * @param[out] *temperature_raw points to a raw temperature buffer
  * @param[out] *temperature_s points to a converted temperature buffer
+ * @param[out] *humidity_raw points to a raw humidity buffer
+ * @param[out] *humidity_s points to a converted humidity buffer
  * @return     status code
  *             - 0 success
- *             - 1 read temperature failed
+ *             - 1 read data failed
  *             - 2 handle is NULL
  *             - 3 handle is not initialized
  *             - 4 data is not ready
  *             - 5 crc is error
- * @note       none
+ * @note       the first byte of the frame is the status, no extra status read is needed,
+ *             the frame read by a successful aht20_poll_ready is used without bus access
  */
-uint8_t aht20_read_temperature(aht20_handle_t *handle, uint32_t *temperature_raw, float *temperature_s)
+uint8_t aht20_fetch_result(aht20_handle_t *handle, uint32_t *temperature_raw, float *temperature_s,
+                           uint32_t *humidity_raw, uint8_t *humidity_s)
 {
-    uint8_t status;
     uint8_t buf[7];
     
     if (handle == NULL)                                               /* check handle */
@@ -412,129 +542,138 @@ uint8_t aht20_read_temperature(aht20_handle_t *handle, uint32_t *temperature_raw
         return 3;                                                     /* return error */
     }
     
-    buf[0] = 0xAC;                                                    /* set the addr */
-    buf[1] = 0x33;                                                    /* set 0x33 */
-    buf[2] = 0x00;                                                    /* set 0x00 */
-    if (a_aht20_iic_write(handle, buf, 3) != 0)                       /* write the command */
+    if (handle->frame_valid != 0)                                     /* frame read by the ready poll */
     {
-        handle->debug_print("aht20: sent command failed.\n");         /* sent command failed */
-        
-        return 1;                                                     /* return error */
+        memcpy(buf, handle->frame, 7);                                /* copy the frame */
+        handle->frame_valid = 0;                                      /* use it once */
     }
-    handle->delay_ms(85);                                             /* delay 85ms */
-    if (a_aht20_iic_read(handle, &status, 1) != 0)                    /* read the status */
+    else if (a_aht20_iic_read(handle, buf, 7) != 0)                   /* read data */
     {
-        handle->debug_print("aht20: read status failed.\n");          /* read status failed */
+        handle->debug_print("aht20: read data failed.\n");            /* read data failed */
         
         return 1;                                                     /* return error */
     }
-    if ((status & 0x80) == 0)                                         /* check the status */
+    if ((buf[0] & 0x80) != 0)                                         /* check the busy bit */
     {
-        if (a_aht20_iic_read(handle, buf, 7) != 0)                    /* read data */
-        {
-            handle->debug_print("aht20: read data failed.\n");        /* read data failed */
-            
-            return 1;                                                 /* return error */
-        }
-        if (a_aht20_calc_crc(buf, 6) != buf[6])                       /* check the crc */
-        {
-            handle->debug_print("aht20: crc is error.\n");            /* crc is error */
-            
-            return 5;                                                 /* return error */
-        }
-        
-        *temperature_raw = (((uint32_t)buf[3]) << 16) |
-                           (((uint32_t)buf[4]) << 8) |
-                           (((uint32_t)buf[5]) << 0);                 /* set the temperature */
-        *temperature_raw = (*temperature_raw) & 0xFFFFF;              /* cut the temperature part */
-        *temperature_s = (float)(*temperature_raw) 
-                                 / 1048576.0f * 200.0f
-                                 - 50.0f;                             /* right shift 4 */
+        handle->debug_print("aht20: data is not ready.\n");           /* data is not ready */
+        handle->stats.busy_at_fetch++;                                /* count the early fetch */
         
-        return 0;                                                     /* success return 0 */
+        return 4;                                                     /* return error */
     }
-    else
+    if (a_aht20_calc_crc(buf, 6) != buf[6])                           /* check the crc */
     {
-        handle->debug_print("aht20: data is not ready.\n");           /* data is not ready */
+        handle->debug_print("aht20: crc is error.\n");                /* crc is error */
+        handle->stats.crc_errors++;                                   /* count the crc error */
         
-        return 4;                                                     /* return error */
+        return 5;                                                     /* return error */
     }
+    a_aht20_convert(buf, temperature_raw, temperature_s,
+                    humidity_raw, humidity_s);                        /* convert the data */
+    
+    return 0;                                                         /* success return 0 */
 }
 
 /**
- * @brief      read the humidity data
+ * @brief      get the error counters
  * @param[in]  *handle points to an aht20 handle structure
+ * @param[out] *stats points to a counters buffer
+ * @return     status code
+ *             - 0 success
+ *             - 2 handle is NULL
+ * @note       none
+ */
+uint8_t aht20_get_stats(aht20_handle_t *handle, aht20_stats_t *stats)
+{
+    if (handle == NULL)                                               /* check handle */
+    {
+        return 2;                                                     /* return error */
+    }
+    
+    *stats = handle->stats;                                           /* copy the counters */
+    
+    return 0;                                                         /* success return 0 */
+}
+
+/**
+ * @brief      read the temperature and humidity data
+ * @param[in]  *handle points to an aht20 handle structure
+ * @param[out] *temperature_raw points to a raw temperature buffer
+ * @param[out] *temperature_s points to a converted temperature buffer
  * @param[out] *humidity_raw points to a raw humidity buffer
  * @param[out] *humidity_s points to a converted humidity buffer
  * @return     status code
  *             - 0 success
- *             - 1 read humidity failed
+ *             - 1 read temperature humidity failed
  *             - 2 handle is NULL
  *             - 3 handle is not initialized
  *             - 4 data is not ready
  *             - 5 crc is error
  * @note       none
  */
-uint8_t aht20_read_humidity(aht20_handle_t *handle, uint32_t *humidity_raw, uint8_t *humidity_s)
+uint8_t aht20_read_temperature_humidity(aht20_handle_t *handle, uint32_t *temperature_raw, float *temperature_s,
+                                        uint32_t *humidity_raw, uint8_t *humidity_s)
 {
-    uint8_t status;
-    uint8_t buf[7];
+    uint8_t res;
     
-    if (handle == NULL)                                               /* check handle */
+    res = aht20_start_measurement(handle);                            /* start the measurement */
+    if (res != 0)
     {
-        return 2;                                                     /* return error */
+        return res;                                                   /* return error */
     }
-    if (handle->inited != 1)                                          /* check handle initialization */
+    res = aht20_wait_ready(handle, AHT20_MEASURE_TIMEOUT_MS);         /* poll the busy bit */
+    if (res != 0)
     {
-        return 3;                                                     /* return error */
+        return res;                                                   /* return error */
     }
     
-    buf[0] = 0xAC;                                                    /* set the addr */
-    buf[1] = 0x33;                                                    /* set 0x33 */
-    buf[2] = 0x00;                                                    /* set 0x00 */
-    if (a_aht20_iic_write(handle, buf, 3) != 0)                       /* write the command */
-    {
-        handle->debug_print("aht20: sent command failed.\n");         /* sent command failed */
-        
-        return 1;                                                     /* return error */
-    }
-    handle->delay_ms(85);                                             /* delay 85ms */
-    if (a_aht20_iic_read(handle, &status, 1) != 0)                    /* read the status */
-    {
-        handle->debug_print("aht20: read status failed.\n");          /* read status failed */
-        
-        return 1;                                                     /* return error */
-    }
-    if ((status & 0x80) == 0)                                         /* check the status */
-    {
-        if (a_aht20_iic_read(handle, buf, 7) != 0)                    /* read data */
-        {
-            handle->debug_print("aht20: read data failed.\n");        /* read data failed */
-            
-            return 1;                                                 /* return error */
-        }
-        if (a_aht20_calc_crc(buf, 6) != buf[6])                       /* check the crc */
-        {
-            handle->debug_print("aht20: crc is error.\n");            /* crc is error */
-            
-            return 5;                                                 /* return error */
-        }
-        
-        *humidity_raw = (((uint32_t)buf[1]) << 16) |
-                        (((uint32_t)buf[2]) << 8) |
-                        (((uint32_t)buf[3]) << 0);                    /* set the humidity */
-        *humidity_raw = (*humidity_raw) >> 4;                         /* right shift 4 */
-        *humidity_s = (uint8_t)((float)(*humidity_raw)
-                                / 1048576.0f * 100.0f);               /* convert the humidity */
-        
-        return 0;                                                     /* success return 0 */
-    }
-    else
-    {
-        handle->debug_print("aht20: data is not ready.\n");           /* data is not ready */
-        
-        return 4;                                                     /* return error */
-    }
+    return aht20_fetch_result(handle, temperature_raw, temperature_s,
+                              humidity_raw, humidity_s);              /* read the result */
+}
+
+/**
+ * @brief      read the temperature
+ * @param[in]  *handle points to an aht20 handle structure
+ * @param[out] *temperature_raw points to a raw temperature buffer
+ * @param[out] *temperature_s points to a converted temperature buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 read temperature failed
+ *             - 2 handle is NULL
+ *             - 3 handle is not initialized
+ *             - 4 data is not ready
+ *             - 5 crc is error
+ * @note       none
+ */
+uint8_t aht20_read_temperature(aht20_handle_t *handle, uint32_t *temperature_raw, float *temperature_s)
+{
+    uint32_t humidity_raw;
+    uint8_t humidity_s;
+    
+    return aht20_read_temperature_humidity(handle, temperature_raw, temperature_s,
+                                           &humidity_raw, &humidity_s);         /* read both, keep temperature */
+}
+
+/**
+ * @brief      read the humidity data
+ * @param[in]  *handle points to an aht20 handle structure
+ * @param[out] *humidity_raw points to a raw humidity buffer
+ * @param[out] *humidity_s points to a converted humidity buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 read humidity failed
+ *             - 2 handle is NULL
+ *             - 3 handle is not initialized
+ *             - 4 data is not ready
+ *             - 5 crc is error
+ * @note       none
+ */
+uint8_t aht20_read_humidity(aht20_handle_t *handle, uint32_t *humidity_raw, uint8_t *humidity_s)
+{
+    uint32_t temperature_raw;
+    float temperature_s;
+    
+    return aht20_read_temperature_humidity(handle, &temperature_raw, &temperature_s,
+                                           humidity_raw, humidity_s);           /* read both, keep humidity */
 }
 
 /**
@@ -56,6 +56,18 @@ extern "C"{
  * @{
  */
 
+/**
+ * @brief aht20 error counters structure definition
+ */
+typedef struct aht20_stats_s
+{
+    uint32_t measurements;             /**< started measurements */
+    uint32_t iic_errors;               /**< failed bus transfers */
+    uint32_t crc_errors;               /**< frames with a bad crc */
+    uint32_t busy_timeouts;            /**< conversions still busy at the deadline */
+    uint32_t busy_at_fetch;            /**< frames fetched with the busy bit set */
+} aht20_stats_t;
+
 /**
  * @brief aht20 handle structure definition
  */
@@ -67,7 +79,15 @@ typedef struct aht20_handle_s
     uint8_t (*iic_write_cmd)(uint8_t addr, uint8_t *buf, uint16_t len);        /**< point to an iic_write_cmd function address */
     void (*delay_ms)(uint32_t ms);                                             /**< point to a delay_ms function address */
     void (*debug_print)(const char *const fmt, ...);                           /**< point to a debug_print function address */
+    uint8_t (*iic_select)(void *user);                                         /**< point to an optional iic_select function address */
+    void *iic_user;                                                            /**< iic_select argument (bus/mux descriptor) */
+    uint32_t (*powered_ms)(void);                                              /**< point to an optional powered_ms function address */
     uint8_t inited;                                                            /**< inited flag */
+    uint16_t conversion_ms;                                                    /**< learned conversion time */
+    uint16_t init_wait_ms;                                                     /**< time slept by the last init */
+    aht20_stats_t stats;                                                       /**< error counters */
+    uint8_t frame[7];                                                          /**< result frame read by the last ready poll */
+    uint8_t frame_valid;                                                       /**< frame holds the current measurement */
 } aht20_handle_t;
 
 /**
@@ -153,6 +173,26 @@ typedef struct aht20_info_s
  */
 #define DRIVER_AHT20_LINK_DEBUG_PRINT(HANDLE, FUC)     (HANDLE)->debug_print = FUC
 
+/**
+ * @brief     link powered_ms function
+ * @param[in] HANDLE points to an aht20 handle structure
+ * @param[in] FUC points to a powered_ms function address
+ * @note      optional, returns the time since the chip power-on in ms,
+ *            aht20_init skips the 500ms power-on wait when it has elapsed
+ */
+#define DRIVER_AHT20_LINK_POWERED_MS(HANDLE, FUC)      (HANDLE)->powered_ms = FUC
+
+/**
+ * @brief     link iic_select function
+ * @param[in] HANDLE points to an aht20 handle structure
+ * @param[in] FUC points to an iic_select function address
+ * @param[in] USER is the argument given to iic_select
+ * @note      optional, called before every bus access so that several handles
+ *            can share the interface functions (bus, mux channel...)
+ */
+#define DRIVER_AHT20_LINK_IIC_SELECT(HANDLE, FUC, USER) do { (HANDLE)->iic_select = FUC; \
+                                                            (HANDLE)->iic_user = USER; } while (0)
+
 /**
  * @}
  */
@@ -184,7 +224,8 @@ uint8_t aht20_info(aht20_info_t *info);
  *            - 3 linked functions is NULL
  *            - 4 read status failed
  *            - 5 reset reg failed
- * @note      none
+ * @note      the power-on wait is skipped when powered_ms is linked and reports
+ *            at least 500ms, the calibration resets run only when bits 0x18 are cleared
  */
 uint8_t aht20_init(aht20_handle_t *handle);
 
@@ -251,6 +292,88 @@ uint8_t aht20_read_temperature(aht20_handle_t *handle, uint32_t *temperature_raw
  */
 uint8_t aht20_read_humidity(aht20_handle_t *handle, uint32_t *humidity_raw, uint8_t *humidity_s);
 
+/**
+ * @}
+ */
+
+/**
+ * @defgroup aht20_split_driver aht20 split-phase driver function
+ * @brief    aht20 split-phase driver modules
+ * @ingroup  aht20_driver
+ * @{
+ */
+
+/**
+ * @brief     start a measurement
+ * @param[in] *handle points to an aht20 handle structure
+ * @return    status code
+ *            - 0 success
+ *            - 1 sent command failed
+ *            - 2 handle is NULL
+ *            - 3 handle is not initialized
+ * @note      the conversion takes about 80ms, use aht20_poll_ready or aht20_wait_ready
+ */
+uint8_t aht20_start_measurement(aht20_handle_t *handle);
+
+/**
+ * @brief      check if the measurement is finished
+ * @param[in]  *handle points to an aht20 handle structure
+ * @param[out] *ready points to a ready flag buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 read status failed
+ *             - 2 handle is NULL
+ *             - 3 handle is not initialized
+ * @note       ready is 1 when the busy bit is cleared, the poll reads the whole frame so
+ *             the next aht20_fetch_result needs no bus access
+ */
+uint8_t aht20_poll_ready(aht20_handle_t *handle, uint8_t *ready);
+
+/**
+ * @brief     wait for the end of the measurement
+ * @param[in] *handle points to an aht20 handle structure
+ * @param[in] timeout_ms is the max wait time in ms
+ * @return    status code
+ *            - 0 success
+ *            - 1 read status failed
+ *            - 2 handle is NULL
+ *            - 3 handle is not initialized
+ *            - 4 data is not ready
+ * @note      call it right after aht20_start_measurement, sleeps the learned
+ *            conversion time then polls the busy bit
+ */
+uint8_t aht20_wait_ready(aht20_handle_t *handle, uint32_t timeout_ms);
+
+/**
+ * @brief      read the measurement result
+ * @param[in]  *handle points to an aht20 handle structure
+ * @param[out] *temperature_raw points to a raw temperature buffer
+ * @param[out] *temperature_s points to a converted temperature buffer
+ * @param[out] *humidity_raw points to a raw humidity buffer
+ * @param[out] *humidity_s points to a converted humidity buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 read data failed
+ *             - 2 handle is NULL
+ *             - 3 handle is not initialized
+ *             - 4 data is not ready
+ *             - 5 crc is error
+ * @note       none
+ */
+uint8_t aht20_fetch_result(aht20_handle_t *handle, uint32_t *temperature_raw, float *temperature_s,
+                           uint32_t *humidity_raw, uint8_t *humidity_s);
+
+/**
+ * @brief      get the error counters
+ * @param[in]  *handle points to an aht20 handle structure
+ * @param[out] *stats points to a counters buffer
+ * @return     status code
+ *             - 0 success
+ *             - 2 handle is NULL
+ * @note       counters are cumulated since DRIVER_AHT20_LINK_INIT
+ */
+uint8_t aht20_get_stats(aht20_handle_t *handle, aht20_stats_t *stats);
+
 /**
  * @}
  */
@@ -57,6 +57,8 @@ uint8_t aht20_basic_init(void)
     DRIVER_AHT20_LINK_IIC_WRITE_CMD(&gs_handle, aht20_interface_iic_write_cmd);
     DRIVER_AHT20_LINK_DELAY_MS(&gs_handle, aht20_interface_delay_ms);
     DRIVER_AHT20_LINK_DEBUG_PRINT(&gs_handle, aht20_interface_debug_print);
+    DRIVER_AHT20_LINK_IIC_SELECT(&gs_handle, aht20_interface_iic_select, NULL);
+    DRIVER_AHT20_LINK_POWERED_MS(&gs_handle, aht20_interface_powered_ms);
     
     /* aht20 init */
     res = aht20_init(&gs_handle);
@@ -96,6 +98,107 @@ uint8_t aht20_basic_read(float *temperature, uint8_t *humidity)
     }
 }
 
+/**
+ * @brief  basic example start a measurement
+ * @return status code
+ *         - 0 success
+ *         - 1 start failed
+ * @note   none
+ */
+uint8_t aht20_basic_start(void)
+{
+    /* send the trigger command, the conversion runs in the chip */
+    if (aht20_start_measurement(&gs_handle) != 0)
+    {
+        return 1;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+/**
+ * @brief      basic example poll the measurement
+ * @param[out] *ready points to a ready flag buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 poll failed
+ * @note       none
+ */
+uint8_t aht20_basic_poll(uint8_t *ready)
+{
+    /* read the busy bit */
+    if (aht20_poll_ready(&gs_handle, ready) != 0)
+    {
+        return 1;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+/**
+ * @brief      basic example fetch the measurement
+ * @param[out] *temperature points to a converted temperature buffer
+ * @param[out] *humidity points to a converted humidity buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 fetch failed
+ * @note       call it once aht20_basic_poll reports ready
+ */
+uint8_t aht20_basic_fetch(float *temperature, uint8_t *humidity)
+{
+    uint32_t temperature_raw;
+    uint32_t humidity_raw;
+    
+    /* read the result frame */
+    if (aht20_fetch_result(&gs_handle, (uint32_t *)&temperature_raw, temperature,
+                           (uint32_t *)&humidity_raw, humidity) != 0)
+    {
+        return 1;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+/**
+ * @brief  basic example get the init wait time
+ * @return time slept by the last init in ms
+ * @note   0 on a warm start with calibrated chip, 500 to 510 on a cold start
+ */
+uint16_t aht20_basic_init_wait_ms(void)
+{
+    return gs_handle.init_wait_ms;
+}
+
+/**
+ * @brief      basic example get the statistics
+ * @param[out] *bus points to a bus statistics buffer
+ * @param[out] *chip points to a chip counters buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 get stats failed
+ * @note       none
+ */
+uint8_t aht20_basic_get_stats(iic_stats_t *bus, aht20_stats_t *chip)
+{
+    /* bus transfers and chip level errors */
+    if (aht20_interface_iic_stats(NULL, bus) != 0)
+    {
+        return 1;
+    }
+    if (aht20_get_stats(&gs_handle, chip) != 0)
+    {
+        return 1;
+    }
+    
+    return 0;
+}
+
 /**
  * @brief  basic example deinit
  * @return status code
@@ -79,6 +79,54 @@ uint8_t aht20_basic_deinit(void);
  */
 uint8_t aht20_basic_read(float *temperature, uint8_t *humidity);
 
+/**
+ * @brief  basic example get the init wait time
+ * @return time slept by the last init in ms
+ * @note   0 on a warm start with calibrated chip, 500 to 510 on a cold start
+ */
+uint16_t aht20_basic_init_wait_ms(void);
+
+/**
+ * @brief  basic example start a measurement
+ * @return status code
+ *         - 0 success
+ *         - 1 start failed
+ * @note   none
+ */
+uint8_t aht20_basic_start(void);
+
+/**
+ * @brief      basic example poll the measurement
+ * @param[out] *ready points to a ready flag buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 poll failed
+ * @note       none
+ */
+uint8_t aht20_basic_poll(uint8_t *ready);
+
+/**
+ * @brief      basic example fetch the measurement
+ * @param[out] *temperature points to a converted temperature buffer
+ * @param[out] *humidity points to a converted humidity buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 fetch failed
+ * @note       call it once aht20_basic_poll reports ready
+ */
+uint8_t aht20_basic_fetch(float *temperature, uint8_t *humidity);
+
+/**
+ * @brief      basic example get the statistics
+ * @param[out] *bus points to a bus statistics buffer
+ * @param[out] *chip points to a chip counters buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 get stats failed
+ * @note       none
+ */
+uint8_t aht20_basic_get_stats(iic_stats_t *bus, aht20_stats_t *chip);
+
 /**
  * @}
  */
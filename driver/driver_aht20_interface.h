@@ -38,6 +38,7 @@
 #define DRIVER_AHT20_INTERFACE_H
 
 #include "aht20.h"
+#include "iic.h"
 
 #ifdef __cplusplus
 extern "C"{
@@ -50,6 +51,27 @@ extern "C"{
  * @{
  */
 
+/**
+ * @brief aht20 interface device structure definition
+ */
+typedef struct aht20_interface_device_s
+{
+    const char *bus;            /**< iic device name, NULL for /dev/i2c-1 */
+    uint8_t addr;               /**< iic device write address, 0 for the chip default */
+    uint8_t mux_addr;           /**< TCA9548A write address (0xE0..0xEE), 0 if no mux */
+    uint8_t mux_channel;        /**< TCA9548A channel 0..7 */
+} aht20_interface_device_t;
+
+/**
+ * @brief     interface select the device of the next accesses
+ * @param[in] *user points to an aht20_interface_device_t, NULL for the default device
+ * @return    status code
+ *            - 0 success
+ *            - 1 mux select failed
+ * @note      link it with DRIVER_AHT20_LINK_IIC_SELECT to share the interface between handles
+ */
+uint8_t aht20_interface_iic_select(void *user);
+
 /**
  * @brief  interface iic bus init
  * @return status code
@@ -99,6 +121,24 @@ uint8_t aht20_interface_iic_write_cmd(uint8_t addr, uint8_t *buf, uint16_t len);
  */
 void aht20_interface_delay_ms(uint32_t ms);
 
+/**
+ * @brief  interface time since the sensor power-on
+ * @return time in ms
+ * @note   the sensor is powered with the board, CLOCK_BOOTTIME is used
+ */
+uint32_t aht20_interface_powered_ms(void);
+
+/**
+ * @brief      interface get the statistics of a device bus
+ * @param[in]  *user points to an aht20_interface_device_t, NULL for the default device
+ * @param[out] *stats points to a statistics buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 bus not opened
+ * @note       the counters are shared by all the devices on the bus, mux writes included
+ */
+uint8_t aht20_interface_iic_stats(void *user, iic_stats_t *stats);
+
 /**
  * @brief     interface print format data
  * @param[in] fmt is the format data
@@ -0,0 +1,223 @@
+/**
+ * Copyright (c) 2015 - present LibDriver All rights reserved
+ * 
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. 
+ *
+ * @file      driver_aht20_multi.c
+ * @brief     driver aht20 multi sensors source file
+ * @version   1.0.0
+ * @author    techtemp
+ * @date      2026-10-18
+ *
+ * <h3>history</h3>
+ * <table>
+ * <tr><th>Date        <th>Version  <th>Author      <th>Description
+ * <tr><td>2026/10/18  <td>1.0      <td>techtemp    <td>first upload
+ * </table>
+ */
+
+#include "driver_aht20_multi.h"
+
+/**
+ * @brief multi read timing definition
+ */
+#define AHT20_MULTI_CONVERSION_MS    80         /**< first wait before the conversion time is learned */
+#define AHT20_MULTI_POLL_MS          5          /**< busy bits polling period */
+#define AHT20_MULTI_TIMEOUT_MS       200        /**< max conversion wait */
+
+/**
+ * @brief         multi example init
+ * @param[in,out] *sensors points to a sensor array with the device descriptors set
+ * @param[in]     count is the number of sensors
+ * @return        status code
+ *                - 0 success
+ *                - 1 init failed
+ * @note          every sensor is initialized, res tells which one failed
+ */
+uint8_t aht20_multi_init(aht20_multi_sensor_t *sensors, uint8_t count)
+{
+    uint8_t i;
+    uint8_t failed = 0;
+    
+    for (i = 0; i < count; i++)
+    {
+        aht20_handle_t *handle = &sensors[i].handle;
+        
+        /* link interface function */
+        DRIVER_AHT20_LINK_INIT(handle, aht20_handle_t);
+        DRIVER_AHT20_LINK_IIC_INIT(handle, aht20_interface_iic_init);
+        DRIVER_AHT20_LINK_IIC_DEINIT(handle, aht20_interface_iic_deinit);
+        DRIVER_AHT20_LINK_IIC_READ_CMD(handle, aht20_interface_iic_read_cmd);
+        DRIVER_AHT20_LINK_IIC_WRITE_CMD(handle, aht20_interface_iic_write_cmd);
+        DRIVER_AHT20_LINK_DELAY_MS(handle, aht20_interface_delay_ms);
+        DRIVER_AHT20_LINK_DEBUG_PRINT(handle, aht20_interface_debug_print);
+        DRIVER_AHT20_LINK_IIC_SELECT(handle, aht20_interface_iic_select, &sensors[i].device);
+        DRIVER_AHT20_LINK_POWERED_MS(handle, aht20_interface_powered_ms);
+        
+        /* aht20 init */
+        sensors[i].res = aht20_init(handle);
+        if (sensors[i].res != 0)
+        {
+            aht20_interface_debug_print("aht20: init failed for sensor %u.\n", i);
+            failed = 1;
+        }
+    }
+    
+    return failed;
+}
+
+/**
+ * @brief         multi example read
+ * @param[in,out] *sensors points to a sensor array
+ * @param[in]     count is the number of sensors
+ * @return        status code
+ *                - 0 success
+ *                - 1 at least one read failed
+ * @note          all the conversions are started first and then collected, a cycle
+ *                costs about one conversion time whatever the number of sensors
+ */
+uint8_t aht20_multi_read(aht20_multi_sensor_t *sensors, uint8_t count)
+{
+    uint8_t i;
+    uint8_t ready;
+    uint8_t pending = 0;
+    uint8_t failed = 0;
+    uint32_t wait = 0;
+    uint32_t elapsed;
+    uint32_t temperature_raw;
+    uint32_t humidity_raw;
+    
+    /* start every conversion */
+    for (i = 0; i < count; i++)
+    {
+        if (sensors[i].handle.inited != 1)
+        {
+            sensors[i].res = 3;
+            failed = 1;
+            
+            continue;
+        }
+        sensors[i].res = aht20_start_measurement(&sensors[i].handle);
+        if (sensors[i].res != 0)
+        {
+            failed = 1;
+            
+            continue;
+        }
+        sensors[i].res = 4;                                            /* not ready yet */
+        pending++;
+        if (sensors[i].handle.conversion_ms > wait)
+        {
+            wait = sensors[i].handle.conversion_ms;                    /* slowest learned conversion */
+        }
+    }
+    if (pending == 0)
+    {
+        return failed;
+    }
+    
+    /* one conversion time for the whole set */
+    if (wait == 0)
+    {
+        wait = AHT20_MULTI_CONVERSION_MS;
+    }
+    aht20_interface_delay_ms(wait);
+    elapsed = wait;
+    
+    /* collect the results in completion order */
+    while (1)
+    {
+        for (i = 0; i < count; i++)
+        {
+            if (sensors[i].res != 4 || sensors[i].handle.inited != 1)
+            {
+                continue;
+            }
+            if (aht20_poll_ready(&sensors[i].handle, &ready) != 0)
+            {
+                sensors[i].res = 1;
+                pending--;
+                
+                continue;
+            }
+            if (ready == 0)
+            {
+                continue;
+            }
+            sensors[i].res = aht20_fetch_result(&sensors[i].handle, &temperature_raw, &sensors[i].temperature,
+                                                &humidity_raw, &sensors[i].humidity);
+            if (elapsed == wait && wait > AHT20_MULTI_POLL_MS)            /* ready at first poll */
+            {
+                sensors[i].handle.conversion_ms = (uint16_t)(wait - AHT20_MULTI_POLL_MS);    /* try earlier next time */
+            }
+            else
+            {
+                sensors[i].handle.conversion_ms = (uint16_t)elapsed;    /* learn the conversion time */
+            }
+            pending--;
+        }
+        if (pending == 0 || elapsed >= AHT20_MULTI_TIMEOUT_MS)
+        {
+            break;
+        }
+        aht20_interface_delay_ms(AHT20_MULTI_POLL_MS);
+        elapsed += AHT20_MULTI_POLL_MS;
+    }
+    
+    for (i = 0; i < count; i++)
+    {
+        if (sensors[i].res != 0)
+        {
+            failed = 1;
+        }
+    }
+    
+    return failed;
+}
+
+/**
+ * @brief     multi example deinit
+ * @param[in] *sensors points to a sensor array
+ * @param[in] count is the number of sensors
+ * @return    status code
+ *            - 0 success
+ *            - 1 deinit failed
+ * @note      none
+ */
+uint8_t aht20_multi_deinit(aht20_multi_sensor_t *sensors, uint8_t count)
+{
+    uint8_t i;
+    uint8_t failed = 0;
+    
+    for (i = 0; i < count; i++)
+    {
+        if (sensors[i].handle.inited != 1)
+        {
+            continue;
+        }
+        if (aht20_deinit(&sensors[i].handle) != 0)
+        {
+            failed = 1;
+        }
+    }
+    
+    return failed;
+}
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2015 - present LibDriver All rights reserved
+ * 
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. 
+ *
+ * @file      driver_aht20_multi.h
+ * @brief     driver aht20 multi sensors header file
+ * @version   1.0.0
+ * @author    techtemp
+ * @date      2026-10-18
+ *
+ * <h3>history</h3>
+ * <table>
+ * <tr><th>Date        <th>Version  <th>Author      <th>Description
+ * <tr><td>2026/10/18  <td>1.0      <td>techtemp    <td>first upload
+ * </table>
+ */
+
+#ifndef DRIVER_AHT20_MULTI_H
+#define DRIVER_AHT20_MULTI_H
+
+#include "driver_aht20_interface.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/**
+ * @defgroup aht20_multi_driver aht20 multi sensors driver function
+ * @brief    aht20 multi sensors driver modules
+ * @ingroup  aht20_driver
+ * @{
+ */
+
+/**
+ * @brief aht20 multi sensor structure definition
+ */
+typedef struct aht20_multi_sensor_s
+{
+    aht20_interface_device_t device;        /**< bus, address and mux channel, set by the caller */
+    aht20_handle_t handle;                  /**< aht20 handle */
+    float temperature;                      /**< last converted temperature */
+    uint8_t humidity;                       /**< last converted humidity */
+    uint8_t res;                            /**< last status code, 0 success */
+} aht20_multi_sensor_t;
+
+/**
+ * @brief         multi example init
+ * @param[in,out] *sensors points to a sensor array with the device descriptors set
+ * @param[in]     count is the number of sensors
+ * @return        status code
+ *                - 0 success
+ *                - 1 init failed
+ * @note          every sensor is initialized, res tells which one failed
+ */
+uint8_t aht20_multi_init(aht20_multi_sensor_t *sensors, uint8_t count);
+
+/**
+ * @brief         multi example read
+ * @param[in,out] *sensors points to a sensor array
+ * @param[in]     count is the number of sensors
+ * @return        status code
+ *                - 0 success
+ *                - 1 at least one read failed
+ * @note          all the conversions are started first and then collected, a cycle
+ *                costs about one conversion time whatever the number of sensors
+ */
+uint8_t aht20_multi_read(aht20_multi_sensor_t *sensors, uint8_t count);
+
+/**
+ * @brief     multi example deinit
+ * @param[in] *sensors points to a sensor array
+ * @param[in] count is the number of sensors
+ * @return    status code
+ *            - 0 success
+ *            - 1 deinit failed
+ * @note      none
+ */
+uint8_t aht20_multi_deinit(aht20_multi_sensor_t *sensors, uint8_t count);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -35,10 +35,168 @@
  */
 
 #include "iic.h"
+#include "iic_sim.h"
 #include <linux/i2c.h>
 #include <linux/i2c-dev.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+
+/**
+ * @brief iic statistics definition
+ */
+#define IIC_STATS_MAX_BUS    4              /**< instrumented buses */
+
+/**
+ * @brief iic statistics slot structure definition
+ */
+typedef struct a_iic_stats_slot_s
+{
+    int fd;                                 /**< iic handle */
+    uint8_t used;                           /**< slot in use */
+    iic_stats_t stats;                      /**< counters */
+} a_iic_stats_slot_t;
+
+static a_iic_stats_slot_t gs_stats[IIC_STATS_MAX_BUS];                      /**< per bus statistics */
+static const uint32_t gs_bucket_us[IIC_STATS_BUCKETS] = IIC_STATS_BUCKET_BOUNDS_US;  /**< histogram bounds */
+
+/**
+ * @brief  get the monotonic time
+ * @return time in us
+ * @note   none
+ */
+static uint64_t a_iic_now_us(void)
+{
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)(ts.tv_nsec / 1000);
+}
+
+/**
+ * @brief     find the statistics of a bus
+ * @param[in] fd is the iic handle
+ * @return    statistics or NULL
+ * @note      none
+ */
+static iic_stats_t *a_iic_stats(int fd)
+{
+    uint8_t i;
+    
+    for (i = 0; i < IIC_STATS_MAX_BUS; i++)
+    {
+        if ((gs_stats[i].used != 0) && (gs_stats[i].fd == fd))
+        {
+            return &gs_stats[i].stats;
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief     attach statistics to a new bus handle
+ * @param[in] fd is the iic handle
+ * @note      buses beyond IIC_STATS_MAX_BUS are not instrumented
+ */
+static void a_iic_stats_attach(int fd)
+{
+    uint8_t i;
+    
+    for (i = 0; i < IIC_STATS_MAX_BUS; i++)
+    {
+        if (gs_stats[i].used == 0)
+        {
+            memset(&gs_stats[i], 0, sizeof(a_iic_stats_slot_t));
+            gs_stats[i].fd = fd;
+            gs_stats[i].used = 1;
+            
+            return;
+        }
+    }
+}
+
+/**
+ * @brief     detach the statistics of a closed bus handle
+ * @param[in] fd is the iic handle
+ * @note      none
+ */
+static void a_iic_stats_detach(int fd)
+{
+    uint8_t i;
+    
+    for (i = 0; i < IIC_STATS_MAX_BUS; i++)
+    {
+        if ((gs_stats[i].used != 0) && (gs_stats[i].fd == fd))
+        {
+            gs_stats[i].used = 0;
+        }
+    }
+}
+
+/**
+ * @brief     account one transfer
+ * @param[in] fd is the iic handle
+ * @param[in] op is the transfer type
+ * @param[in] us is the transfer duration
+ * @param[in] failed is 1 if the transfer failed
+ * @param[in] nak is 1 if the device did not acknowledge
+ * @note      none
+ */
+static void a_iic_account(int fd, iic_op_t op, uint64_t us, uint8_t failed, uint8_t nak)
+{
+    iic_stats_t *stats = a_iic_stats(fd);
+    iic_op_stats_t *o;
+    uint8_t b;
+    
+    if (stats == NULL)
+    {
+        return;
+    }
+    o = &stats->op[op];
+    o->count++;
+    o->errors += failed;
+    o->nak += nak;
+    o->total_us += us;
+    if (us > o->max_us)
+    {
+        o->max_us = (uint32_t)us;
+    }
+    for (b = 0; b < IIC_STATS_BUCKETS - 1 && us >= gs_bucket_us[b]; b++)
+    {
+    }
+    o->hist[b]++;
+}
+
+/**
+ * @brief         run an I2C_RDWR transfer
+ * @param[in]     fd is the iic handle
+ * @param[in,out] *data points to the ioctl data
+ * @return        status code
+ *                - 0 success
+ *                - 1 transfer failed
+ * @note          timed and accounted as write, read or combined
+ */
+static uint8_t a_iic_rdwr(int fd, struct i2c_rdwr_ioctl_data *data)
+{
+    iic_op_t op;
+    uint64_t t0;
+    int res;
+    int err;
+    
+    op = (data->nmsgs > 1) ? IIC_OP_COMBINED :
+         ((data->msgs[0].flags & I2C_M_RD) != 0) ? IIC_OP_READ : IIC_OP_WRITE;
+    t0 = a_iic_now_us();
+    res = ioctl(fd, I2C_RDWR, data);
+    err = errno;
+    a_iic_account(fd, op, a_iic_now_us() - t0, (res < 0) ? 1 : 0,
+                  ((res < 0) && (err == ENXIO || err == EREMOTEIO || err == EIO)) ? 1 : 0);
+    errno = err;
+    
+    return (res < 0) ? 1 : 0;
+}
 
 /**
  * @brief      iic bus init
@@ -47,10 +205,24 @@
  * @return     status code
  *             - 0 success
  *             - 1 init failed
- * @note       none
+ * @note       names starting with "sim" open the in-process simulated bus,
+ *             built with IIC_SIM_ONLY every name is simulated
  */
 uint8_t iic_init(char *name, int *fd)
 {
+#ifndef IIC_SIM_ONLY
+    if (iic_sim_is_name(name) != 0)
+#endif
+    {
+        if (iic_sim_init(name, fd) != 0)
+        {
+            return 1;
+        }
+        a_iic_stats_attach(*fd);
+        
+        return 0;
+    }
+    
     /* open the device */
     *fd = open(name, O_RDWR);
     
@@ -63,6 +235,8 @@ uint8_t iic_init(char *name, int *fd)
     }
     else
     {
+        a_iic_stats_attach(*fd);
+        
         return 0;
     }
 }
@@ -77,6 +251,12 @@ uint8_t iic_init(char *name, int *fd)
  */
 uint8_t iic_deinit(int fd)
 {
+    a_iic_stats_detach(fd);
+    if (iic_sim_is_fd(fd) != 0)
+    {
+        return iic_sim_deinit(fd);
+    }
+    
     /* close the device */
     if (close(fd) < 0)
     {
@@ -106,6 +286,16 @@ uint8_t iic_read_cmd(int fd, uint8_t addr, uint8_t *buf, uint16_t len)
     struct i2c_rdwr_ioctl_data i2c_rdwr_data;
     struct i2c_msg msgs[1];
     
+    if (iic_sim_is_fd(fd) != 0)
+    {
+        uint64_t t0 = a_iic_now_us();
+        uint8_t res = iic_sim_read_cmd(fd, addr, buf, len);
+        
+        a_iic_account(fd, IIC_OP_READ, a_iic_now_us() - t0, res, res);
+        
+        return res;
+    }
+    
     /* clear ioctl data */
     memset(&i2c_rdwr_data, 0, sizeof(struct i2c_rdwr_ioctl_data));
 
@@ -121,7 +311,7 @@ uint8_t iic_read_cmd(int fd, uint8_t addr, uint8_t *buf, uint16_t len)
     i2c_rdwr_data.nmsgs = 1;
     
     /* transmit */
-    if (ioctl(fd, I2C_RDWR, &i2c_rdwr_data) < 0)
+    if (a_iic_rdwr(fd, &i2c_rdwr_data) != 0)
     {
         perror("iic: read failed.\n");
         
@@ -167,7 +357,7 @@ uint8_t iic_read(int fd, uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len)
     i2c_rdwr_data.nmsgs = 2;
     
     /* transmit */
-    if (ioctl(fd, I2C_RDWR, &i2c_rdwr_data) < 0)
+    if (a_iic_rdwr(fd, &i2c_rdwr_data) != 0)
     {
         perror("iic: read failed.\n");
         
@@ -216,7 +406,7 @@ uint8_t iic_read_address16(int fd, uint8_t addr, uint16_t reg, uint8_t *buf, uin
     i2c_rdwr_data.nmsgs = 2;
     
     /* transmit */
-    if (ioctl(fd, I2C_RDWR, &i2c_rdwr_data) < 0)
+    if (a_iic_rdwr(fd, &i2c_rdwr_data) != 0)
     {
         perror("iic: read failed.\n");
         
@@ -242,6 +432,16 @@ uint8_t iic_write_cmd(int fd, uint8_t addr, uint8_t *buf, uint16_t len)
     struct i2c_rdwr_ioctl_data i2c_rdwr_data;
     struct i2c_msg msgs[1];
     
+    if (iic_sim_is_fd(fd) != 0)
+    {
+        uint64_t t0 = a_iic_now_us();
+        uint8_t res = iic_sim_write_cmd(fd, addr, buf, len);
+        
+        a_iic_account(fd, IIC_OP_WRITE, a_iic_now_us() - t0, res, res);
+        
+        return res;
+    }
+    
     /* clear ioctl data */
     memset(&i2c_rdwr_data, 0, sizeof(struct i2c_rdwr_ioctl_data));
     
@@ -257,7 +457,7 @@ uint8_t iic_write_cmd(int fd, uint8_t addr, uint8_t *buf, uint16_t len)
     i2c_rdwr_data.nmsgs = 1;
     
     /* transmit */
-    if (ioctl(fd, I2C_RDWR, &i2c_rdwr_data) < 0)
+    if (a_iic_rdwr(fd, &i2c_rdwr_data) != 0)
     {
         perror("iic: write failed.\n");
         
@@ -305,7 +505,7 @@ uint8_t iic_write(int fd, uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len)
     i2c_rdwr_data.nmsgs = 1;
     
     /* transmit */
-    if (ioctl(fd, I2C_RDWR, &i2c_rdwr_data) < 0)
+    if (a_iic_rdwr(fd, &i2c_rdwr_data) != 0)
     {
         perror("iic: write failed.\n");
         
@@ -354,7 +554,7 @@ uint8_t iic_write_address16(int fd, uint8_t addr, uint16_t reg, uint8_t *buf, ui
     i2c_rdwr_data.nmsgs = 1;
     
     /* transmit */
-    if (ioctl(fd, I2C_RDWR, &i2c_rdwr_data) < 0)
+    if (a_iic_rdwr(fd, &i2c_rdwr_data) != 0)
     {
         perror("iic: write failed.\n");
         
@@ -363,3 +563,112 @@ uint8_t iic_write_address16(int fd, uint8_t addr, uint16_t reg, uint8_t *buf, ui
      
     return 0;
 }
+
+/**
+ * @brief         iic bus transaction
+ * @param[in]     fd is the iic handle
+ * @param[in,out] *msgs points to a message array
+ * @param[in]     n is the number of messages
+ * @return        status code
+ *                - 0 success
+ *                - 1 transfer failed
+ *                - 2 n is invalid
+ * @note          addr = device_address_7bits << 1
+ */
+uint8_t iic_transfer(int fd, iic_msg_t *msgs, uint8_t n)
+{
+    struct i2c_rdwr_ioctl_data i2c_rdwr_data;
+    struct i2c_msg i2c_msgs[IIC_TRANSFER_MAX_MSGS];
+    uint8_t i;
+    
+    if ((n == 0) || (n > IIC_TRANSFER_MAX_MSGS))
+    {
+        return 2;
+    }
+    
+    if (iic_sim_is_fd(fd) != 0)
+    {
+        uint64_t t0 = a_iic_now_us();
+        uint8_t res = 0;
+        
+        for (i = 0; (i < n) && (res == 0); i++)
+        {
+            res = ((msgs[i].flags & IIC_MSG_READ) != 0) ? iic_sim_read_cmd(fd, msgs[i].addr, msgs[i].buf, msgs[i].len)
+                                                         : iic_sim_write_cmd(fd, msgs[i].addr, msgs[i].buf, msgs[i].len);
+        }
+        a_iic_account(fd, (n > 1) ? IIC_OP_COMBINED : ((msgs[0].flags & IIC_MSG_READ) != 0) ? IIC_OP_READ : IIC_OP_WRITE,
+                      a_iic_now_us() - t0, res, res);
+        
+        return res;
+    }
+    
+    /* clear ioctl data */
+    memset(&i2c_rdwr_data, 0, sizeof(struct i2c_rdwr_ioctl_data));
+    
+    /* clear msgs data */
+    memset(i2c_msgs, 0, sizeof(struct i2c_msg) * n);
+    
+    /* set the param */
+    for (i = 0; i < n; i++)
+    {
+        i2c_msgs[i].addr = msgs[i].addr >> 1;
+        i2c_msgs[i].flags = ((msgs[i].flags & IIC_MSG_READ) != 0) ? I2C_M_RD : 0;
+        i2c_msgs[i].buf = msgs[i].buf;
+        i2c_msgs[i].len = msgs[i].len;
+    }
+    i2c_rdwr_data.msgs = i2c_msgs;
+    i2c_rdwr_data.nmsgs = n;
+    
+    /* transmit */
+    if (a_iic_rdwr(fd, &i2c_rdwr_data) != 0)
+    {
+        perror("iic: transfer failed.\n");
+        
+        return 1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief      get the statistics of a bus
+ * @param[in]  fd is the iic handle
+ * @param[out] *stats points to a statistics buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 bus not instrumented
+ * @note       none
+ */
+uint8_t iic_get_stats(int fd, iic_stats_t *stats)
+{
+    iic_stats_t *s = a_iic_stats(fd);
+    
+    if (s == NULL)
+    {
+        return 1;
+    }
+    *stats = *s;
+    
+    return 0;
+}
+
+/**
+ * @brief     reset the statistics of a bus
+ * @param[in] fd is the iic handle
+ * @return    status code
+ *            - 0 success
+ *            - 1 bus not instrumented
+ * @note      none
+ */
+uint8_t iic_reset_stats(int fd)
+{
+    iic_stats_t *s = a_iic_stats(fd);
+    
+    if (s == NULL)
+    {
+        return 1;
+    }
+    memset(s, 0, sizeof(iic_stats_t));
+    
+    return 0;
+}
@@ -53,6 +53,61 @@ extern "C" {
  * @{
  */
 
+/**
+ * @brief iic statistics definition
+ */
+#define IIC_STATS_BUCKETS             8                                              /**< latency histogram buckets */
+#define IIC_STATS_BUCKET_BOUNDS_US    {100, 200, 500, 1000, 2000, 5000, 10000, 0}    /**< bucket upper bounds in us, last is open */
+
+/**
+ * @brief iic transaction definition
+ */
+#define IIC_TRANSFER_MAX_MSGS    8          /**< max messages in one transaction */
+#define IIC_MSG_READ             0x01       /**< read message, write otherwise */
+
+/**
+ * @brief iic message structure definition
+ */
+typedef struct iic_msg_s
+{
+    uint8_t addr;               /**< iic device write address */
+    uint8_t flags;              /**< IIC_MSG_READ or 0 */
+    uint16_t len;               /**< data length */
+    uint8_t *buf;               /**< data buffer */
+} iic_msg_t;
+
+/**
+ * @brief iic transfer type enumeration definition
+ */
+typedef enum
+{
+    IIC_OP_WRITE    = 0,        /**< single write message */
+    IIC_OP_READ     = 1,        /**< single read message */
+    IIC_OP_COMBINED = 2,        /**< write then read with repeated start */
+    IIC_OP_MAX      = 3,        /**< number of transfer types */
+} iic_op_t;
+
+/**
+ * @brief iic transfer statistics structure definition
+ */
+typedef struct iic_op_stats_s
+{
+    uint32_t count;                         /**< transfers */
+    uint32_t errors;                        /**< failed transfers */
+    uint32_t nak;                           /**< failures caused by a missing acknowledge */
+    uint64_t total_us;                      /**< cumulated latency */
+    uint32_t max_us;                        /**< worst latency */
+    uint32_t hist[IIC_STATS_BUCKETS];       /**< latency histogram */
+} iic_op_stats_t;
+
+/**
+ * @brief iic bus statistics structure definition
+ */
+typedef struct iic_stats_s
+{
+    iic_op_stats_t op[IIC_OP_MAX];          /**< statistics per transfer type */
+} iic_stats_t;
+
 /**
  * @brief      iic bus init
  * @param[in]  *name points to an iic device name buffer
@@ -60,7 +115,8 @@ extern "C" {
  * @return     status code
  *             - 0 success
  *             - 1 init failed
- * @note       none
+ * @note       names starting with "sim" open the in-process simulated bus (iic_sim.h),
+ *             built with IIC_SIM_ONLY every name is simulated
  */
 uint8_t iic_init(char *name, int *fd);
 
@@ -156,6 +212,41 @@ uint8_t iic_write(int fd, uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len)
  */
 uint8_t iic_write_address16(int fd, uint8_t addr, uint16_t reg, uint8_t *buf, uint16_t len);
 
+/**
+ * @brief         iic bus transaction
+ * @param[in]     fd is the iic handle
+ * @param[in,out] *msgs points to a message array
+ * @param[in]     n is the number of messages
+ * @return        status code
+ *                - 0 success
+ *                - 1 transfer failed
+ *                - 2 n is invalid
+ * @note          the messages are sent in one I2C_RDWR ioctl, separated by repeated starts
+ *                with a single stop at the end, addr = device_address_7bits << 1
+ */
+uint8_t iic_transfer(int fd, iic_msg_t *msgs, uint8_t n);
+
+/**
+ * @brief      get the statistics of a bus
+ * @param[in]  fd is the iic handle
+ * @param[out] *stats points to a statistics buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 bus not instrumented
+ * @note       every I2C_RDWR transfer is timed, counters live until iic_deinit
+ */
+uint8_t iic_get_stats(int fd, iic_stats_t *stats);
+
+/**
+ * @brief     reset the statistics of a bus
+ * @param[in] fd is the iic handle
+ * @return    status code
+ *            - 0 success
+ *            - 1 bus not instrumented
+ * @note      none
+ */
+uint8_t iic_reset_stats(int fd);
+
 /**
  * @}
  */
@@ -0,0 +1,549 @@
+/**
+ * Copyright (c) 2015 - present LibDriver All rights reserved
+ * 
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. 
+ *
+ * @file      iic_sim.c
+ * @brief     simulated iic bus source file
+ * @version   1.0.0
+ * @author    techtemp
+ * @date      2026-10-18
+ *
+ * <h3>history</h3>
+ * <table>
+ * <tr><th>Date        <th>Version  <th>Author      <th>Description
+ * <tr><td>2026/10/18  <td>1.0      <td>techtemp    <td>first upload
+ * </table>
+ */
+
+#include "iic_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief iic sim definition
+ */
+#define IIC_SIM_FD               (-0x51A0)       /**< first handle, never returned by open() */
+#define IIC_SIM_BUSES            4               /**< simulated buses opened at the same time */
+#define IIC_SIM_AHT20_ADDR       0x70            /**< aht20 write address */
+#define IIC_SIM_NO_CHANNEL       0xFF            /**< mux with no channel enabled */
+
+/**
+ * @brief iic sim aht20 state structure definition
+ */
+typedef struct a_sim_aht20_s
+{
+    iic_sim_aht20_t model;            /**< programmed behaviour */
+    uint64_t start_ms;                /**< last trigger time */
+    uint8_t measuring;                /**< conversion triggered */
+    uint8_t calibrated;               /**< 0x18 bits state */
+    uint8_t reset_done;               /**< reset sequence progress, bit per register */
+    uint8_t frame[7];                 /**< last converted frame */
+} a_sim_aht20_t;
+
+/**
+ * @brief iic sim bus structure definition
+ */
+typedef struct a_sim_bus_s
+{
+    char name[32];                                /**< iic device name */
+    int open;                                     /**< opened handles, 0 if the slot is free */
+    uint8_t channel;                              /**< current mux channel */
+    a_sim_aht20_t aht20[IIC_SIM_CHANNELS];        /**< one aht20 per channel */
+} a_sim_bus_t;
+
+static iic_sim_aht20_t gs_model[IIC_SIM_CHANNELS];  /**< models given to the buses */
+static a_sim_bus_t gs_bus[IIC_SIM_BUSES];           /**< each bus has its own handle and state */
+static uint8_t gs_configured = 0;                    /**< models set */
+static uint64_t gs_origin_ms = 0;                    /**< waveform time origin */
+static uint32_t gs_seed = 0x2545F491;                /**< fault generator */
+
+/**
+ * @brief  get the monotonic time
+ * @return time in ms
+ * @note   none
+ */
+static uint64_t a_sim_now_ms(void)
+{
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)(ts.tv_nsec / 1000000);
+}
+
+/**
+ * @brief     reset an aht20 to its model
+ * @param[in] *s points to an aht20 state
+ * @param[in] *model points to an aht20 model
+ * @note      none
+ */
+static void a_sim_reset(a_sim_aht20_t *s, const iic_sim_aht20_t *model)
+{
+    memset(s, 0, sizeof(a_sim_aht20_t));
+    s->model = *model;
+    s->calibrated = (model->uncalibrated != 0) ? 0 : 1;
+}
+
+/**
+ * @brief     get an opened bus
+ * @param[in] fd is the iic handle
+ * @return    bus or NULL
+ * @note      none
+ */
+static a_sim_bus_t *a_sim_bus(int fd)
+{
+    if (iic_sim_is_fd(fd) == 0 || gs_bus[IIC_SIM_FD - fd].open == 0)
+    {
+        return NULL;
+    }
+    
+    return &gs_bus[IIC_SIM_FD - fd];
+}
+
+/**
+ * @brief     draw a fault
+ * @param[in] permille is the fault probability
+ * @return    1 if the fault happens
+ * @note      xorshift, deterministic for a given TECHTEMP_SIM seed
+ */
+static uint8_t a_sim_fault(uint16_t permille)
+{
+    if (permille == 0)
+    {
+        return 0;
+    }
+    gs_seed ^= gs_seed << 13;
+    gs_seed ^= gs_seed >> 17;
+    gs_seed ^= gs_seed << 5;
+    
+    return ((gs_seed % 1000) < permille) ? 1 : 0;
+}
+
+/**
+ * @brief     calculate the crc
+ * @param[in] *data points to a data buffer
+ * @param[in] len is the data length
+ * @return    crc
+ * @note      same polynomial as the chip, 0x31 with 0xFF init
+ */
+static uint8_t a_sim_crc(const uint8_t *data, uint8_t len)
+{
+    uint8_t i;
+    uint8_t byte;
+    uint8_t crc = 0xFF;
+    
+    for (byte = 0; byte < len; byte++)
+    {
+        crc ^= data[byte];
+        for (i = 8; i > 0; --i)
+        {
+            crc = ((crc & 0x80) != 0) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    
+    return crc;
+}
+
+/**
+ * @brief     evaluate a waveform
+ * @param[in] *w points to a waveform
+ * @param[in] t_ms is the time since the origin
+ * @return    value
+ * @note      none
+ */
+static float a_sim_wave(const iic_sim_waveform_t *w, uint64_t t_ms)
+{
+    float phase;
+    
+    if (w->type == IIC_SIM_WAVE_CONSTANT || w->period_ms == 0)
+    {
+        return w->base;
+    }
+    phase = (float)(t_ms % w->period_ms) / (float)w->period_ms;
+    switch (w->type)
+    {
+        case IIC_SIM_WAVE_RAMP :
+            return w->base + w->amplitude * phase;
+        case IIC_SIM_WAVE_TRIANGLE :
+            return w->base + w->amplitude * ((phase < 0.5f) ? (4.0f * phase - 1.0f) : (3.0f - 4.0f * phase));
+        case IIC_SIM_WAVE_SQUARE :
+            return w->base + ((phase < 0.5f) ? w->amplitude : -w->amplitude);
+        default :
+            return w->base;
+    }
+}
+
+/**
+ * @brief     build the frame of a finished conversion
+ * @param[in] *s points to an aht20 state
+ * @param[in] t_ms is the conversion end time
+ * @note      none
+ */
+static void a_sim_convert(a_sim_aht20_t *s, uint64_t t_ms)
+{
+    float t = a_sim_wave(&s->model.temperature, t_ms - gs_origin_ms);
+    float h = a_sim_wave(&s->model.humidity, t_ms - gs_origin_ms);
+    uint32_t t_raw;
+    uint32_t h_raw;
+    
+    h = (h < 0.0f) ? 0.0f : (h > 100.0f) ? 100.0f : h;
+    t = (t < -50.0f) ? -50.0f : (t > 150.0f) ? 150.0f : t;
+    h_raw = (uint32_t)(h / 100.0f * 1048576.0f + 0.5f);                /* same scale as the driver, rounded */
+    t_raw = (uint32_t)((t + 50.0f) / 200.0f * 1048576.0f + 0.5f);
+    h_raw = (h_raw > 0xFFFFF) ? 0xFFFFF : h_raw;                       /* 100% and 150C fit in 20 bits */
+    t_raw = (t_raw > 0xFFFFF) ? 0xFFFFF : t_raw;
+    s->frame[1] = (uint8_t)(h_raw >> 12);
+    s->frame[2] = (uint8_t)(h_raw >> 4);
+    s->frame[3] = (uint8_t)(((h_raw & 0x0F) << 4) | ((t_raw >> 16) & 0x0F));
+    s->frame[4] = (uint8_t)(t_raw >> 8);
+    s->frame[5] = (uint8_t)t_raw;
+}
+
+/**
+ * @brief  apply the TECHTEMP_SIM environment variable
+ * @note   key=value list separated by commas
+ */
+static void a_sim_configure(void)
+{
+    iic_sim_aht20_t model;
+    char *env;
+    char *copy;
+    char *tok;
+    char *save;
+    uint8_t i;
+    
+    iic_sim_aht20_default(&model);
+    env = getenv("TECHTEMP_SIM");
+    copy = (env != NULL) ? strdup(env) : NULL;
+    for (tok = (copy != NULL) ? strtok_r(copy, ",", &save) : NULL; tok != NULL; tok = strtok_r(NULL, ",", &save))
+    {
+        char *eq = strchr(tok, '=');
+        const char *v;
+        
+        if (eq == NULL)
+        {
+            continue;
+        }
+        *eq = '\0';
+        v = eq + 1;
+        if (strcmp(tok, "temp") == 0)             model.temperature.base = strtof(v, NULL);
+        else if (strcmp(tok, "temp_amp") == 0)    model.temperature.amplitude = strtof(v, NULL);
+        else if (strcmp(tok, "temp_period") == 0) model.temperature.period_ms = (uint32_t)strtoul(v, NULL, 10);
+        else if (strcmp(tok, "hum") == 0)         model.humidity.base = strtof(v, NULL);
+        else if (strcmp(tok, "hum_amp") == 0)     model.humidity.amplitude = strtof(v, NULL);
+        else if (strcmp(tok, "hum_period") == 0)  model.humidity.period_ms = (uint32_t)strtoul(v, NULL, 10);
+        else if (strcmp(tok, "conv_ms") == 0)     model.conversion_ms = (uint32_t)strtoul(v, NULL, 10);
+        else if (strcmp(tok, "nak") == 0)         model.nak_permille = (uint16_t)strtoul(v, NULL, 10);
+        else if (strcmp(tok, "crc") == 0)         model.crc_permille = (uint16_t)strtoul(v, NULL, 10);
+        else if (strcmp(tok, "stuck") == 0)       model.stuck_busy = (uint8_t)strtoul(v, NULL, 10);
+        else if (strcmp(tok, "uncal") == 0)       model.uncalibrated = (uint8_t)strtoul(v, NULL, 10);
+        else if (strcmp(tok, "seed") == 0)        gs_seed = (uint32_t)strtoul(v, NULL, 10) | 1;
+        else if (strcmp(tok, "temp_wave") == 0 || strcmp(tok, "hum_wave") == 0)
+        {
+            iic_sim_wave_t w = (strcmp(v, "ramp") == 0) ? IIC_SIM_WAVE_RAMP :
+                               (strcmp(v, "triangle") == 0) ? IIC_SIM_WAVE_TRIANGLE :
+                               (strcmp(v, "square") == 0) ? IIC_SIM_WAVE_SQUARE : IIC_SIM_WAVE_CONSTANT;
+            
+            if (tok[0] == 't')
+            {
+                model.temperature.type = w;
+            }
+            else
+            {
+                model.humidity.type = w;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "iic_sim: unknown TECHTEMP_SIM key '%s'.\n", tok);
+        }
+    }
+    free(copy);
+    for (i = 0; i < IIC_SIM_CHANNELS; i++)
+    {
+        iic_sim_aht20_set(i, &model);
+    }
+}
+
+/**
+ * @brief      get the default aht20 model
+ * @param[out] *model points to an aht20 model buffer
+ * @note       21.5C / 45% constant, 80ms conversion, no fault
+ */
+void iic_sim_aht20_default(iic_sim_aht20_t *model)
+{
+    memset(model, 0, sizeof(iic_sim_aht20_t));
+    model->temperature.type = IIC_SIM_WAVE_CONSTANT;
+    model->temperature.base = 21.5f;
+    model->humidity.type = IIC_SIM_WAVE_CONSTANT;
+    model->humidity.base = 45.0f;
+    model->conversion_ms = 80;
+}
+
+/**
+ * @brief     set the aht20 model of a mux channel
+ * @param[in] channel is the mux channel, 0 without mux
+ * @param[in] *model points to an aht20 model
+ * @note      none
+ */
+void iic_sim_aht20_set(uint8_t channel, const iic_sim_aht20_t *model)
+{
+    uint8_t i;
+    
+    if (channel >= IIC_SIM_CHANNELS)
+    {
+        return;
+    }
+    gs_model[channel] = *model;
+    for (i = 0; i < IIC_SIM_BUSES; i++)
+    {
+        a_sim_reset(&gs_bus[i].aht20[channel], model);                  /* opened buses follow the model */
+    }
+    gs_configured = 1;
+}
+
+/**
+ * @brief     check a simulated bus name
+ * @param[in] *name points to an iic device name
+ * @return    1 if simulated
+ * @note      none
+ */
+uint8_t iic_sim_is_name(const char *name)
+{
+    return (name != NULL && strncmp(name, IIC_SIM_NAME, strlen(IIC_SIM_NAME)) == 0) ? 1 : 0;
+}
+
+/**
+ * @brief     check a simulated bus handle
+ * @param[in] fd is the iic handle
+ * @return    1 if simulated
+ * @note      none
+ */
+uint8_t iic_sim_is_fd(int fd)
+{
+    return (fd <= IIC_SIM_FD && fd > IIC_SIM_FD - IIC_SIM_BUSES) ? 1 : 0;
+}
+
+/**
+ * @brief      simulated bus init
+ * @param[in]  *name points to an iic device name
+ * @param[out] *fd points to an iic device handle buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 init failed
+ * @note       the same name shares one bus, each other name gets its own handle and aht20s
+ */
+uint8_t iic_sim_init(const char *name, int *fd)
+{
+    a_sim_bus_t *bus = NULL;
+    uint8_t i;
+    
+    if (gs_configured == 0)
+    {
+        a_sim_configure();
+    }
+    if (gs_origin_ms == 0)
+    {
+        gs_origin_ms = a_sim_now_ms();
+    }
+    for (i = 0; i < IIC_SIM_BUSES; i++)                                  /* already opened */
+    {
+        if (gs_bus[i].open != 0 && strncmp(gs_bus[i].name, name, sizeof(gs_bus[i].name) - 1) == 0)
+        {
+            bus = &gs_bus[i];
+            
+            break;
+        }
+    }
+    if (bus == NULL)
+    {
+        for (i = 0; i < IIC_SIM_BUSES && gs_bus[i].open != 0; i++)       /* free slot */
+        {
+        }
+        if (i == IIC_SIM_BUSES)
+        {
+            fprintf(stderr, "iic_sim: too many simulated buses, %s not opened.\n", name);
+            
+            return 1;
+        }
+        bus = &gs_bus[i];
+        memset(bus->name, 0, sizeof(bus->name));
+        strncpy(bus->name, name, sizeof(bus->name) - 1);
+        bus->channel = 0;
+        for (i = 0; i < IIC_SIM_CHANNELS; i++)
+        {
+            a_sim_reset(&bus->aht20[i], &gs_model[i]);
+        }
+    }
+    bus->open++;
+    *fd = IIC_SIM_FD - (int)(bus - gs_bus);
+    
+    return 0;
+}
+
+/**
+ * @brief     simulated bus deinit
+ * @param[in] fd is the iic handle
+ * @return    status code
+ *            - 0 success
+ *            - 1 deinit failed
+ * @note      none
+ */
+uint8_t iic_sim_deinit(int fd)
+{
+    a_sim_bus_t *bus = a_sim_bus(fd);
+    
+    if (bus == NULL)
+    {
+        return 1;
+    }
+    bus->open--;
+    
+    return 0;
+}
+
+/**
+ * @brief      simulated bus read
+ * @param[in]  fd is the iic handle
+ * @param[in]  addr is the iic device write address
+ * @param[out] *buf points to a data buffer
+ * @param[in]  len is the length of the data buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 read failed (nak)
+ * @note       1 byte returns the status, 7 bytes the status, data and crc
+ */
+uint8_t iic_sim_read_cmd(int fd, uint8_t addr, uint8_t *buf, uint16_t len)
+{
+    a_sim_bus_t *bus = a_sim_bus(fd);
+    a_sim_aht20_t *s;
+    uint64_t now;
+    uint8_t busy;
+    
+    if (bus == NULL || addr != IIC_SIM_AHT20_ADDR || bus->channel >= IIC_SIM_CHANNELS || len == 0)
+    {
+        return 1;
+    }
+    s = &bus->aht20[bus->channel];
+    if (s->model.absent != 0 || a_sim_fault(s->model.nak_permille) != 0)
+    {
+        return 1;
+    }
+    
+    now = a_sim_now_ms();
+    busy = 0;
+    if (s->measuring != 0)
+    {
+        if (s->model.stuck_busy != 0 || now < s->start_ms + s->model.conversion_ms)
+        {
+            busy = 1;
+        }
+        else
+        {
+            a_sim_convert(s, s->start_ms + s->model.conversion_ms);
+            s->measuring = 0;
+        }
+    }
+    s->frame[0] = (uint8_t)((busy != 0 ? 0x80 : 0x00) | (s->calibrated != 0 ? 0x18 : 0x00));
+    s->frame[6] = a_sim_crc(s->frame, 6);
+    if (len >= 7 && a_sim_fault(s->model.crc_permille) != 0)
+    {
+        s->frame[6] ^= 0x5A;
+    }
+    memset(buf, 0, len);
+    memcpy(buf, s->frame, (len < 7) ? len : 7);
+    
+    return 0;
+}
+
+/**
+ * @brief     simulated bus write
+ * @param[in] fd is the iic handle
+ * @param[in] addr is the iic device write address
+ * @param[in] *buf points to a data buffer
+ * @param[in] len is the length of the data buffer
+ * @return    status code
+ *            - 0 success
+ *            - 1 write failed (nak)
+ * @note      0xE0..0xEE is a TCA9548A, 0x70 the aht20 of the current channel
+ */
+uint8_t iic_sim_write_cmd(int fd, uint8_t addr, uint8_t *buf, uint16_t len)
+{
+    a_sim_bus_t *bus = a_sim_bus(fd);
+    a_sim_aht20_t *s;
+    uint8_t i;
+    
+    if (bus == NULL || len == 0)
+    {
+        return 1;
+    }
+    if (addr >= 0xE0 && addr <= 0xEE)                                    /* mux control register */
+    {
+        bus->channel = IIC_SIM_NO_CHANNEL;
+        for (i = 0; i < IIC_SIM_CHANNELS; i++)
+        {
+            if ((buf[0] & (1 << i)) != 0)
+            {
+                bus->channel = i;
+                
+                break;
+            }
+        }
+        
+        return 0;
+    }
+    if (addr != IIC_SIM_AHT20_ADDR || bus->channel >= IIC_SIM_CHANNELS)
+    {
+        return 1;
+    }
+    s = &bus->aht20[bus->channel];
+    if (s->model.absent != 0 || a_sim_fault(s->model.nak_permille) != 0)
+    {
+        return 1;
+    }
+    
+    if (buf[0] == 0xAC)                                                  /* trigger a measurement */
+    {
+        s->start_ms = a_sim_now_ms();
+        s->measuring = 1;
+    }
+    else if (buf[0] == 0x1B || buf[0] == 0x1C || buf[0] == 0x1E)         /* reset sequence, read part */
+    {
+        memset(s->frame, 0, sizeof(s->frame));
+    }
+    else if (buf[0] == (0xB0 | 0x1B) || buf[0] == (0xB0 | 0x1C) || buf[0] == (0xB0 | 0x1E))
+    {
+        s->reset_done |= (uint8_t)(1 << ((buf[0] & 0x0F) - 0x0B));       /* 0x1B, 0x1C, 0x1E */
+        if ((s->reset_done & 0x0B) == 0x0B)
+        {
+            s->calibrated = 1;
+        }
+    }
+    else if (buf[0] == 0xBA)                                             /* soft reset */
+    {
+        s->measuring = 0;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2015 - present LibDriver All rights reserved
+ * 
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. 
+ *
+ * @file      iic_sim.h
+ * @brief     simulated iic bus header file
+ * @version   1.0.0
+ * @author    techtemp
+ * @date      2026-10-18
+ *
+ * <h3>history</h3>
+ * <table>
+ * <tr><th>Date        <th>Version  <th>Author      <th>Description
+ * <tr><td>2026/10/18  <td>1.0      <td>techtemp    <td>first upload
+ * </table>
+ */
+
+#ifndef IIC_SIM_H
+#define IIC_SIM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup iic_sim iic sim function
+ * @brief    in-process iic bus with an aht20 emulator on each mux channel
+ * @{
+ */
+
+/**
+ * @brief iic sim device name definition
+ */
+#define IIC_SIM_NAME             "sim"           /**< bus names starting with "sim" are simulated */
+#define IIC_SIM_CHANNELS         8               /**< one aht20 per TCA9548A channel */
+
+/**
+ * @brief iic sim waveform enumeration definition
+ */
+typedef enum
+{
+    IIC_SIM_WAVE_CONSTANT = 0,        /**< base value */
+    IIC_SIM_WAVE_RAMP     = 1,        /**< sawtooth from base to base + amplitude */
+    IIC_SIM_WAVE_TRIANGLE = 2,        /**< base +/- amplitude */
+    IIC_SIM_WAVE_SQUARE   = 3,        /**< base +/- amplitude, half period each */
+} iic_sim_wave_t;
+
+/**
+ * @brief iic sim waveform structure definition
+ */
+typedef struct iic_sim_waveform_s
+{
+    iic_sim_wave_t type;              /**< waveform type */
+    float base;                       /**< base value */
+    float amplitude;                  /**< amplitude */
+    uint32_t period_ms;               /**< period in ms */
+} iic_sim_waveform_t;
+
+/**
+ * @brief iic sim aht20 structure definition
+ */
+typedef struct iic_sim_aht20_s
+{
+    iic_sim_waveform_t temperature;   /**< temperature in C */
+    iic_sim_waveform_t humidity;      /**< humidity in % */
+    uint32_t conversion_ms;           /**< busy time after the 0xAC trigger */
+    uint16_t nak_permille;            /**< probability of a NAK per transfer */
+    uint16_t crc_permille;            /**< probability of a corrupted crc per frame */
+    uint8_t stuck_busy;               /**< 1 keeps the busy bit set forever */
+    uint8_t uncalibrated;             /**< 1 clears the 0x18 bits until the reset sequence */
+    uint8_t absent;                   /**< 1 naks every transfer */
+} iic_sim_aht20_t;
+
+/**
+ * @brief      get the default aht20 model
+ * @param[out] *model points to an aht20 model buffer
+ * @note       21.5C / 45% constant, 80ms conversion, no fault
+ */
+void iic_sim_aht20_default(iic_sim_aht20_t *model);
+
+/**
+ * @brief     set the aht20 model of a mux channel
+ * @param[in] channel is the mux channel, 0 without mux
+ * @param[in] *model points to an aht20 model
+ * @note      the TECHTEMP_SIM environment variable is applied to every channel at the first open,
+ *            ex. "temp=21,temp_amp=2,temp_wave=triangle,temp_period=60000,hum=45,conv_ms=0,nak=10,crc=10,stuck=0"
+ */
+void iic_sim_aht20_set(uint8_t channel, const iic_sim_aht20_t *model);
+
+/**
+ * @brief     check a simulated bus name
+ * @param[in] *name points to an iic device name
+ * @return    1 if simulated
+ * @note      none
+ */
+uint8_t iic_sim_is_name(const char *name);
+
+/**
+ * @brief     check a simulated bus handle
+ * @param[in] fd is the iic handle
+ * @return    1 if simulated
+ * @note      none
+ */
+uint8_t iic_sim_is_fd(int fd);
+
+/**
+ * @brief      simulated bus init
+ * @param[in]  *name points to an iic device name
+ * @param[out] *fd points to an iic device handle buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 init failed
+ * @note       the same name shares one bus, each other name gets its own handle and aht20s
+ */
+uint8_t iic_sim_init(const char *name, int *fd);
+
+/**
+ * @brief     simulated bus deinit
+ * @param[in] fd is the iic handle
+ * @return    status code
+ *            - 0 success
+ *            - 1 deinit failed
+ * @note      none
+ */
+uint8_t iic_sim_deinit(int fd);
+
+/**
+ * @brief      simulated bus read
+ * @param[in]  fd is the iic handle
+ * @param[in]  addr is the iic device write address
+ * @param[out] *buf points to a data buffer
+ * @param[in]  len is the length of the data buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 read failed (nak)
+ * @note       addr = device_address_7bits << 1
+ */
+uint8_t iic_sim_read_cmd(int fd, uint8_t addr, uint8_t *buf, uint16_t len);
+
+/**
+ * @brief     simulated bus write
+ * @param[in] fd is the iic handle
+ * @param[in] addr is the iic device write address
+ * @param[in] *buf points to a data buffer
+ * @param[in] len is the length of the data buffer
+ * @return    status code
+ *            - 0 success
+ *            - 1 write failed (nak)
+ * @note      addr = device_address_7bits << 1
+ */
+uint8_t iic_sim_write_cmd(int fd, uint8_t addr, uint8_t *buf, uint16_t len);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -39,27 +39,188 @@
 #include "helpers.h"
 #include <stdarg.h>
 #include <unistd.h>
+#include <time.h>
+
+#ifndef CLOCK_BOOTTIME
+#define CLOCK_BOOTTIME 7                    /**< linux clock id */
+#endif
 
 /**
  * @brief iic device name definition
  */
-#define IIC_DEVICE_NAME "/dev/i2c-1"        /**< iic device name */
+#define IIC_DEVICE_NAME "/dev/i2c-1"        /**< default iic device name */
+
+/**
+ * @brief iic bus definition
+ */
+#define IIC_MAX_BUS     4                   /**< max opened iic buses */
+#define IIC_NO_CHANNEL  0xFF                /**< mux channel unknown */
+
+/**
+ * @brief iic bus structure definition
+ */
+typedef struct a_iic_bus_s
+{
+    char name[32];                          /**< iic device name */
+    int fd;                                 /**< iic handle */
+    uint8_t refs;                           /**< devices using the bus */
+    uint8_t mux_addr;                       /**< last selected mux */
+    uint8_t mux_channel;                    /**< last selected mux channel */
+} a_iic_bus_t;
+
+static a_iic_bus_t gs_bus[IIC_MAX_BUS];                                    /**< opened buses */
+static aht20_interface_device_t gs_default = {NULL, 0, 0, 0};              /**< single sensor device */
+static aht20_interface_device_t *gs_current = &gs_default;                 /**< device of the next accesses */
+static a_iic_bus_t *gs_current_bus = NULL;                                 /**< bus of the current device */
 
 /**
- * @brief iic device handle definition
+ * @brief  get the default bus name
+ * @return iic device name
+ * @note   AHT20_IIC_BUS overrides /dev/i2c-1, ex. AHT20_IIC_BUS=sim for the simulated bus
  */
-static int gs_fd;                           /**< iic handle */
+static const char *a_iic_default_bus(void)
+{
+    const char *env = getenv("AHT20_IIC_BUS");
+    
+    return (env != NULL && env[0] != '\0') ? env : IIC_DEVICE_NAME;
+}
+
+/**
+ * @brief     find an opened bus
+ * @param[in] *name points to an iic device name
+ * @return    bus or NULL
+ * @note      none
+ */
+static a_iic_bus_t *a_iic_find_bus(const char *name)
+{
+    uint8_t i;
+    
+    for (i = 0; i < IIC_MAX_BUS; i++)
+    {
+        if ((gs_bus[i].refs != 0) && (strcmp(gs_bus[i].name, name) == 0))
+        {
+            return &gs_bus[i];
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief  route the bus to the current device
+ * @return status code
+ *         - 0 success
+ *         - 1 mux select failed
+ * @note   the mux control register is written only when the channel changes, switching
+ *         between two muxes is one transaction: both control writes latch at the stop
+ */
+static uint8_t a_iic_route(void)
+{
+    iic_msg_t msgs[2];
+    uint8_t ctrl[2];
+    uint8_t n;
+    
+    if ((gs_current_bus == NULL) || (gs_current->mux_addr == 0))
+    {
+        return 0;
+    }
+    if ((gs_current_bus->mux_addr == gs_current->mux_addr) &&
+        (gs_current_bus->mux_channel == gs_current->mux_channel))
+    {
+        return 0;
+    }
+    n = 0;
+    if ((gs_current_bus->mux_addr != 0) && (gs_current_bus->mux_addr != gs_current->mux_addr))
+    {
+        ctrl[n] = 0x00;                                                /* disconnect the other mux */
+        msgs[n].addr = gs_current_bus->mux_addr;
+        msgs[n].flags = 0;
+        msgs[n].len = 1;
+        msgs[n].buf = &ctrl[n];
+        n++;
+    }
+    ctrl[n] = (uint8_t)(1 << (gs_current->mux_channel & 0x07));        /* one channel enabled */
+    msgs[n].addr = gs_current->mux_addr;
+    msgs[n].flags = 0;
+    msgs[n].len = 1;
+    msgs[n].buf = &ctrl[n];
+    n++;
+    if (iic_transfer(gs_current_bus->fd, msgs, n) != 0)
+    {
+        gs_current_bus->mux_channel = IIC_NO_CHANNEL;
+        
+        return 1;
+    }
+    gs_current_bus->mux_addr = gs_current->mux_addr;
+    gs_current_bus->mux_channel = gs_current->mux_channel;
+    
+    return 0;
+}
+
+/**
+ * @brief     interface select the device of the next accesses
+ * @param[in] *user points to an aht20_interface_device_t, NULL for the default device
+ * @return    status code
+ *            - 0 success
+ *            - 1 mux select failed
+ * @note      none
+ */
+uint8_t aht20_interface_iic_select(void *user)
+{
+    gs_current = (user != NULL) ? (aht20_interface_device_t *)user : &gs_default;
+    if (gs_current->bus == NULL)
+    {
+        gs_current->bus = a_iic_default_bus();
+    }
+    gs_current_bus = a_iic_find_bus(gs_current->bus);
+    
+    return a_iic_route();
+}
 
 /**
  * @brief  interface iic bus init
  * @return status code
  *         - 0 success
  *         - 1 iic init failed
- * @note   none
+ * @note   the bus is opened once and shared by all the devices on it
  */
 uint8_t aht20_interface_iic_init(void)
 {
-    return iic_init(IIC_DEVICE_NAME, &gs_fd);
+    uint8_t i;
+    a_iic_bus_t *bus;
+    
+    if (gs_current->bus == NULL)
+    {
+        gs_current->bus = a_iic_default_bus();
+    }
+    bus = a_iic_find_bus(gs_current->bus);
+    if (bus == NULL)
+    {
+        for (i = 0; i < IIC_MAX_BUS; i++)
+        {
+            if (gs_bus[i].refs == 0)
+            {
+                bus = &gs_bus[i];
+                
+                break;
+            }
+        }
+        if (bus == NULL)
+        {
+            return 1;
+        }
+        memset(bus, 0, sizeof(a_iic_bus_t));
+        strncpy(bus->name, gs_current->bus, sizeof(bus->name) - 1);
+        bus->mux_channel = IIC_NO_CHANNEL;
+        if (iic_init(bus->name, &bus->fd) != 0)
+        {
+            return 1;
+        }
+    }
+    bus->refs++;
+    gs_current_bus = bus;
+    
+    return a_iic_route();
 }
 
 /**
@@ -67,11 +228,31 @@ uint8_t aht20_interface_iic_init(void)
  * @return status code
  *         - 0 success
  *         - 1 iic deinit failed
- * @note   none
+ * @note   the bus is closed with its last device
  */
 uint8_t aht20_interface_iic_deinit(void)
 {
-    return iic_deinit(gs_fd);
+    a_iic_bus_t *bus;
+    
+    if (gs_current->bus == NULL)
+    {
+        return 1;
+    }
+    bus = a_iic_find_bus(gs_current->bus);
+    if (bus == NULL)
+    {
+        return 1;
+    }
+    if (--bus->refs != 0)
+    {
+        return 0;
+    }
+    if (gs_current_bus == bus)
+    {
+        gs_current_bus = NULL;
+    }
+    
+    return iic_deinit(bus->fd);
 }
 
 /**
@@ -82,11 +263,16 @@ uint8_t aht20_interface_iic_deinit(void)
  * @return     status code
  *             - 0 success
  *             - 1 read failed
- * @note       none
+ * @note       the device descriptor address overrides addr when set
  */
 uint8_t aht20_interface_iic_read_cmd(uint8_t addr, uint8_t *buf, uint16_t len)
 {
-    return iic_read_cmd(gs_fd, addr, buf, len);
+    if (gs_current_bus == NULL)
+    {
+        return 1;
+    }
+    
+    return iic_read_cmd(gs_current_bus->fd, (gs_current->addr != 0) ? gs_current->addr : addr, buf, len);
 }
 
 /**
@@ -97,11 +283,16 @@ uint8_t aht20_interface_iic_read_cmd(uint8_t addr, uint8_t *buf, uint16_t len)
  * @return    status code
  *            - 0 success
  *            - 1 write failed
- * @note      none
+ * @note      the device descriptor address overrides addr when set
  */
 uint8_t aht20_interface_iic_write_cmd(uint8_t addr, uint8_t *buf, uint16_t len)
 {
-    return iic_write_cmd(gs_fd, addr, buf, len);
+    if (gs_current_bus == NULL)
+    {
+        return 1;
+    }
+    
+    return iic_write_cmd(gs_current_bus->fd, (gs_current->addr != 0) ? gs_current->addr : addr, buf, len);
 }
 
 /**
@@ -114,6 +305,54 @@ void aht20_interface_delay_ms(uint32_t ms)
     sleep_ms(ms);
 }
 
+/**
+ * @brief  interface time since the sensor power-on
+ * @return time in ms
+ * @note   the sensor is powered with the board, CLOCK_BOOTTIME is used
+ */
+uint32_t aht20_interface_powered_ms(void)
+{
+    struct timespec ts;
+    
+    if (clock_gettime(CLOCK_BOOTTIME, &ts) != 0)
+    {
+        return 0;                           /* unknown, cold start */
+    }
+    if (ts.tv_sec > 3600)
+    {
+        return 3600000;                     /* long enough */
+    }
+    
+    return (uint32_t)ts.tv_sec * 1000 + (uint32_t)(ts.tv_nsec / 1000000);
+}
+
+/**
+ * @brief      interface get the statistics of a device bus
+ * @param[in]  *user points to an aht20_interface_device_t, NULL for the default device
+ * @param[out] *stats points to a statistics buffer
+ * @return     status code
+ *             - 0 success
+ *             - 1 bus not opened
+ * @note       the counters are shared by all the devices on the bus, mux writes included
+ */
+uint8_t aht20_interface_iic_stats(void *user, iic_stats_t *stats)
+{
+    aht20_interface_device_t *dev = (user != NULL) ? (aht20_interface_device_t *)user : &gs_default;
+    a_iic_bus_t *bus;
+    
+    if (dev->bus == NULL)
+    {
+        return 1;
+    }
+    bus = a_iic_find_bus(dev->bus);
+    if (bus == NULL)
+    {
+        return 1;
+    }
+    
+    return iic_get_stats(bus->fd, stats);
+}
+
 /**
  * @brief     interface print format data
  * @param[in] fmt is the format data
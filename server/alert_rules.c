@@ -0,0 +1,292 @@
+#include "alert_rules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Une variation est mesurée sur au moins 5 min : 0,1 °C en 10 s ne fait pas 36 °C/h
+#define ALERT_RATE_MIN_WINDOW_SEC 300
+
+// Règles par défaut : mêmes seuils que le calcul fait jusqu'ici dans le dashboard
+static const char *default_rules[] = {
+    "above temperature 26 level=warning hyst=0.5 for=300",
+    "above temperature 35 level=error hyst=0.5",
+    "below temperature 18 level=warning hyst=0.5 for=300",
+    "below temperature 5 level=error hyst=0.5",
+    "above humidity 66 level=warning hyst=2 for=600",
+    "above humidity 85 level=error hyst=2",
+    "below humidity 30 level=warning hyst=2 for=600",
+    "below humidity 15 level=error hyst=2",
+    "rate temperature 5 level=warning hyst=1",
+    "stale - 21600 level=warning",
+    "stale - 86400 level=error",
+    NULL
+};
+
+// Ligne "anomaly z=.. alpha=.. warmup=.. stuck=.." ; 0 = OK
+static int parse_anomaly(AnomalyConfig *cfg, char *save) {
+    for (char *opt = strtok_r(NULL, " \t\r\n", &save); opt; opt = strtok_r(NULL, " \t\r\n", &save)) {
+        if (strncmp(opt, "z=", 2) == 0) cfg->z = strtof(opt + 2, NULL);
+        else if (strncmp(opt, "alpha=", 6) == 0) cfg->alpha = strtof(opt + 6, NULL);
+        else if (strncmp(opt, "warmup=", 7) == 0) cfg->warmup = (uint16_t)atoi(opt + 7);
+        else if (strncmp(opt, "stuck=", 6) == 0) cfg->stuck = (uint16_t)atoi(opt + 6);
+        else return -1;
+    }
+    return (cfg->z > 0 && cfg->alpha > 0 && cfg->alpha < 1 && cfg->warmup >= 1) ? 0 : -1;
+}
+
+// Compile une ligne ; 1 si règle ajoutée, 0 si ligne vide/commentaire/anomaly, -1 si invalide
+static int parse_rule(AlertRuleSet *set, const char *line) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", line);
+    char *hash = strchr(buf, '#');
+    if (hash) *hash = '\0';
+
+    char *save = NULL;
+    char *kind = strtok_r(buf, " \t\r\n", &save);
+    if (!kind) return 0;
+    if (strcmp(kind, "anomaly") == 0) {
+        AnomalyConfig cfg = set->anomaly;
+        if (parse_anomaly(&cfg, save) != 0) return -1;
+        set->anomaly = cfg;
+        return 0;
+    }
+    char *metric = strtok_r(NULL, " \t\r\n", &save);
+    char *threshold = strtok_r(NULL, " \t\r\n", &save);
+    if (!metric || !threshold || set->count >= ALERT_MAX_RULES) return -1;
+
+    AlertRule r;
+    memset(&r, 0, sizeof(r));
+    if (strcmp(kind, "above") == 0) r.kind = ALERT_ABOVE;
+    else if (strcmp(kind, "below") == 0) r.kind = ALERT_BELOW;
+    else if (strcmp(kind, "rate") == 0) r.kind = ALERT_RATE;
+    else if (strcmp(kind, "stale") == 0) r.kind = ALERT_STALE;
+    else return -1;
+
+    if (strcmp(metric, "temperature") == 0) r.metric = ALERT_METRIC_TEMPERATURE;
+    else if (strcmp(metric, "humidity") == 0) r.metric = ALERT_METRIC_HUMIDITY;
+    else if (strcmp(metric, "-") == 0 && r.kind == ALERT_STALE) r.metric = ALERT_METRIC_NONE;
+    else return -1;
+    if (r.kind != ALERT_STALE && r.metric == ALERT_METRIC_NONE) return -1;
+
+    char *end;
+    r.threshold = strtod(threshold, &end);
+    if (*end != '\0') return -1;
+
+    for (char *opt = strtok_r(NULL, " \t\r\n", &save); opt; opt = strtok_r(NULL, " \t\r\n", &save)) {
+        if (strncmp(opt, "level=", 6) == 0) {
+            if (strcmp(opt + 6, "warning") == 0) r.level = ALERT_LEVEL_WARNING;
+            else if (strcmp(opt + 6, "error") == 0) r.level = ALERT_LEVEL_ERROR;
+            else return -1;
+        } else if (strncmp(opt, "hyst=", 5) == 0) {
+            r.hysteresis = strtod(opt + 5, NULL);
+            if (r.hysteresis < 0) return -1;
+        } else if (strncmp(opt, "for=", 4) == 0) {
+            r.for_sec = atoi(opt + 4);
+        } else if (strncmp(opt, "sensor=", 7) == 0) {
+            r.sensor_id = atoi(opt + 7);
+        } else if (strncmp(opt, "room=", 5) == 0) {
+            r.room_id = atoi(opt + 5);
+        } else {
+            return -1;
+        }
+    }
+    set->rules[set->count++] = r;
+    return 1;
+}
+
+int alert_rules_load(AlertRuleSet *set, const char *path) {
+    memset(set, 0, sizeof(*set));
+    anomaly_config_default(&set->anomaly);
+
+    FILE *f = path ? fopen(path, "r") : NULL;
+    if (!f) {
+        for (int i = 0; default_rules[i]; i++) {
+            parse_rule(set, default_rules[i]);
+        }
+        printf("[Alerts] %s not found, %d default rules loaded\n", path ? path : "(none)", set->count);
+        return set->count;
+    }
+
+    char line[256];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        if (parse_rule(set, line) < 0) {
+            fprintf(stderr, "[Alerts] %s:%d: invalid rule ignored\n", path, line_no);
+        }
+    }
+    fclose(f);
+    printf("[Alerts] %d rules loaded from %s\n", set->count, path);
+    return set->count;
+}
+
+static int rule_specificity(const AlertRule *r) {
+    return r->sensor_id ? 2 : (r->room_id ? 1 : 0);
+}
+
+static bool rule_applies(const AlertRule *r, int sensor_id, int room_id) {
+    return (r->sensor_id == 0 || r->sensor_id == sensor_id) &&
+           (r->room_id == 0 || r->room_id == room_id);
+}
+
+void alert_bind(const AlertRuleSet *set, AlertBinding *b, int sensor_id, int room_id) {
+    memset(b, 0, sizeof(*b));
+    for (int i = 0; i < set->count && b->count < ALERT_MAX_PER_DEVICE; i++) {
+        const AlertRule *r = &set->rules[i];
+        if (!rule_applies(r, sensor_id, room_id)) continue;
+
+        // Une règle plus spécifique de même kind/metric/level la remplace
+        bool overridden = false;
+        for (int j = 0; j < set->count && !overridden; j++) {
+            const AlertRule *o = &set->rules[j];
+            overridden = j != i && o->kind == r->kind && o->metric == r->metric && o->level == r->level &&
+                         rule_specificity(o) > rule_specificity(r) && rule_applies(o, sensor_id, room_id);
+        }
+        if (!overridden) b->idx[b->count++] = (uint8_t)i;
+    }
+}
+
+static void push_event(AlertEventLog *log, bool raised, int rule, int sensor_id, double value, time_t now) {
+    if (log->next_id == 0) log->next_id = 1;
+    AlertEvent *e = &log->events[(log->next_id - 1) % ALERT_EVENT_RING];
+    e->id = log->next_id++;
+    e->at = now;
+    e->raised = raised;
+    e->rule = rule;
+    e->sensor_id = sensor_id;
+    e->value = value;
+}
+
+void alert_rebind(const AlertRuleSet *set, AlertBinding *b, AlertEventLog *log, int sensor_id, int room_id,
+                  time_t now) {
+    AlertBinding old = *b;
+    alert_bind(set, b, sensor_id, room_id);
+    for (int i = 0; i < old.count; i++) {
+        int j = 0;
+        while (j < b->count && b->idx[j] != old.idx[i]) j++;
+        if (j < b->count) {
+            b->state[j] = old.state[i];     // règle toujours applicable : état, attente et hystérésis gardés
+        } else if (old.state[i].active) {
+            push_event(log, false, old.idx[i], sensor_id, old.state[i].value, now);
+        }
+    }
+}
+
+// Hystérésis + durée minimale ; les règles rate/stale se comportent comme "above"
+static void eval_rule(const AlertRule *r, AlertState *st, AlertEventLog *log, int rule, int sensor_id,
+                      double value, time_t now) {
+    bool below = r->kind == ALERT_BELOW;
+    st->value = value;
+
+    if (st->active) {
+        bool clear = below ? value > r->threshold + r->hysteresis : value < r->threshold - r->hysteresis;
+        if (clear) {
+            st->active = false;
+            st->pending_since = 0;
+            push_event(log, false, rule, sensor_id, value, now);
+        }
+        return;
+    }
+
+    bool cond = below ? value < r->threshold : value > r->threshold;
+    if (!cond) {
+        st->pending_since = 0;
+        return;
+    }
+    if (st->pending_since == 0) st->pending_since = now;
+    if (difftime(now, st->pending_since) >= r->for_sec) {
+        st->active = true;
+        st->since = now;
+        push_event(log, true, rule, sensor_id, value, now);
+    }
+}
+
+void alert_eval_reading(const AlertRuleSet *set, AlertBinding *b, AlertEventLog *log, int sensor_id,
+                        double temperature, double humidity,
+                        double prev_temperature, double prev_humidity, time_t prev_at, time_t now) {
+    double window = difftime(now, prev_at);
+    if (window < ALERT_RATE_MIN_WINDOW_SEC) window = ALERT_RATE_MIN_WINDOW_SEC;
+
+    for (int i = 0; i < b->count; i++) {
+        const AlertRule *r = &set->rules[b->idx[i]];
+        bool temp = r->metric == ALERT_METRIC_TEMPERATURE;
+        double value;
+
+        switch (r->kind) {
+            case ALERT_ABOVE:
+            case ALERT_BELOW:
+                value = temp ? temperature : humidity;
+                break;
+            case ALERT_RATE:
+                if (prev_at == 0) continue;
+                value = (temp ? temperature - prev_temperature : humidity - prev_humidity) * 3600.0 / window;
+                if (value < 0) value = -value;
+                break;
+            default:
+                continue;   // stale : alert_eval_stale
+        }
+        eval_rule(r, &b->state[i], log, b->idx[i], sensor_id, value, now);
+    }
+}
+
+void alert_eval_stale(const AlertRuleSet *set, AlertBinding *b, AlertEventLog *log, int sensor_id,
+                      time_t last_seen, time_t now) {
+    if (last_seen == 0) return;
+    for (int i = 0; i < b->count; i++) {
+        const AlertRule *r = &set->rules[b->idx[i]];
+        if (r->kind != ALERT_STALE) continue;
+        eval_rule(r, &b->state[i], log, b->idx[i], sensor_id, difftime(now, last_seen), now);
+    }
+}
+
+const char* alert_type_label(const AlertRule *rule) {
+    bool temp = rule->metric == ALERT_METRIC_TEMPERATURE;
+    bool error = rule->level == ALERT_LEVEL_ERROR;
+    switch (rule->kind) {
+        case ALERT_ABOVE:
+            if (error) return temp ? "Température Critique" : "Humidité Critique";
+            return temp ? "Température Élevée" : "Humidité Élevée";
+        case ALERT_BELOW:
+            if (error) return temp ? "Température Critique" : "Humidité Critique";
+            return temp ? "Température Basse" : "Humidité Basse";
+        case ALERT_RATE:
+            return temp ? "Température Instable" : "Humidité Instable";
+        case ALERT_STALE:
+        default:
+            return "Données Obsolètes";
+    }
+}
+
+const char* alert_level_label(AlertLevel level) {
+    return level == ALERT_LEVEL_ERROR ? "error" : "warning";
+}
+
+void alert_format_message(const AlertRule *rule, double value, char *buf, size_t size) {
+    const char *unit = rule->metric == ALERT_METRIC_TEMPERATURE ? "°C" : "%";
+    switch (rule->kind) {
+        case ALERT_ABOVE:
+        case ALERT_BELOW:
+            snprintf(buf, size, "%s: %.1f%s (seuil %.1f%s)", alert_type_label(rule), value, unit,
+                     rule->threshold, unit);
+            break;
+        case ALERT_RATE:
+            snprintf(buf, size, "Variation de %.1f%s/h (seuil %.1f%s/h)", value, unit, rule->threshold, unit);
+            break;
+        case ALERT_STALE:
+        default:
+            snprintf(buf, size, "Aucune donnée reçue depuis %.0f min", value / 60.0);
+            break;
+    }
+}
+
+int alert_events_since(const AlertEventLog *log, unsigned long since, AlertEvent *out, int max) {
+    if (log->next_id <= 1) return 0;
+    unsigned long first = (log->next_id > ALERT_EVENT_RING) ? log->next_id - ALERT_EVENT_RING : 1;
+    if (since + 1 > first) first = since + 1;
+
+    int n = 0;
+    for (unsigned long id = first; id < log->next_id && n < max; id++) {
+        out[n++] = log->events[(id - 1) % ALERT_EVENT_RING];
+    }
+    return n;
+}
@@ -0,0 +1,105 @@
+#ifndef ALERT_RULES_H
+#define ALERT_RULES_H
+
+#include <time.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "anomaly.h"
+
+// Moteur d'alertes à seuils : règles compilées au chargement dans une table plate,
+// chaque device garde la liste des index de ses règles (évaluation en O(règles du device)).
+//
+// Format du fichier (une règle par ligne, '#' = commentaire) :
+//   <kind> <metric> <seuil> [level=warning|error] [hyst=<delta>] [for=<sec>] [sensor=<id>] [room=<id>]
+//   kind   : above, below, rate (variation absolue par heure), stale (secondes sans mesure)
+//   metric : temperature, humidity ("-" pour stale)
+// Une règle sensor= remplace la règle room= de même kind/metric/level, qui remplace la règle globale.
+// Détection d'anomalies (optionnel) : anomaly [z=4] [alpha=0.05] [warmup=20] [stuck=30]
+
+#define ALERT_MAX_RULES 64
+#define ALERT_MAX_PER_DEVICE 16
+#define ALERT_EVENT_RING 128
+#define ALERT_RULES_FILE "alert_rules.conf"
+
+typedef enum { ALERT_ABOVE = 0, ALERT_BELOW, ALERT_RATE, ALERT_STALE } AlertKind;
+typedef enum { ALERT_METRIC_NONE = 0, ALERT_METRIC_TEMPERATURE, ALERT_METRIC_HUMIDITY } AlertMetric;
+typedef enum { ALERT_LEVEL_WARNING = 0, ALERT_LEVEL_ERROR } AlertLevel;
+
+typedef struct {
+    AlertKind kind;
+    AlertMetric metric;
+    AlertLevel level;
+    double threshold;
+    double hysteresis;  // écart sous (au-dessus de) le seuil pour retomber
+    int for_sec;        // durée minimale de la condition avant déclenchement
+    int sensor_id;      // 0 = tous
+    int room_id;        // 0 = toutes
+} AlertRule;
+
+typedef struct {
+    AlertRule rules[ALERT_MAX_RULES];
+    int count;
+    AnomalyConfig anomaly;
+} AlertRuleSet;
+
+// État d'une règle pour un device
+typedef struct {
+    bool active;
+    time_t pending_since;   // condition vraie depuis (0 = non)
+    time_t since;           // déclenchée à
+    double value;           // dernière valeur évaluée
+} AlertState;
+
+// Règles liées à un device (index dans AlertRuleSet.rules)
+typedef struct {
+    uint8_t idx[ALERT_MAX_PER_DEVICE];
+    AlertState state[ALERT_MAX_PER_DEVICE];
+    int count;
+} AlertBinding;
+
+typedef struct {
+    unsigned long id;       // croissant, curseur pour /api/system/events?since=
+    time_t at;
+    bool raised;            // false = retour à la normale
+    int rule;
+    int sensor_id;
+    double value;
+} AlertEvent;
+
+typedef struct {
+    AlertEvent events[ALERT_EVENT_RING];
+    unsigned long next_id;  // id du prochain événement (premier = 1)
+} AlertEventLog;
+
+// Charge path ; fichier absent => règles par défaut (seuils du dashboard).
+// Les lignes invalides sont ignorées avec un message. Renvoie le nombre de règles.
+int alert_rules_load(AlertRuleSet *set, const char *path);
+
+// (Re)lie les règles applicables au device ; remet les états à zéro
+void alert_bind(const AlertRuleSet *set, AlertBinding *b, int sensor_id, int room_id);
+
+// Changement de pièce : les règles toujours applicables gardent leur état, celles qui ne
+// s'appliquent plus et étaient actives sont retombées (événement de fin daté now)
+void alert_rebind(const AlertRuleSet *set, AlertBinding *b, AlertEventLog *log, int sensor_id, int room_id,
+                  time_t now);
+
+// Nouvelle mesure ; prev_at et now sont des horodatages de capture.
+// prev_at = 0 : pas de mesure précédente (pas de règle rate)
+void alert_eval_reading(const AlertRuleSet *set, AlertBinding *b, AlertEventLog *log, int sensor_id,
+                        double temperature, double humidity,
+                        double prev_temperature, double prev_humidity, time_t prev_at, time_t now);
+
+// Règles stale : à appeler périodiquement (last_seen = 0 : jamais de mesure)
+void alert_eval_stale(const AlertRuleSet *set, AlertBinding *b, AlertEventLog *log, int sensor_id,
+                      time_t last_seen, time_t now);
+
+// Libellés compatibles avec le dashboard ("Température Élevée", "warning"...)
+const char* alert_type_label(const AlertRule *rule);
+const char* alert_level_label(AlertLevel level);
+// Message lisible pour une valeur donnée
+void alert_format_message(const AlertRule *rule, double value, char *buf, size_t size);
+
+// Événements d'id > since, plus anciens d'abord ; renvoie le nombre copié
+int alert_events_since(const AlertEventLog *log, unsigned long since, AlertEvent *out, int max);
+
+#endif // ALERT_RULES_H
@@ -0,0 +1,177 @@
+/* alert_rules_check.c - moteur d'alertes : chargement, liaison, hystérésis, durée, rate, stale
+ *
+ * Usage : ./alert_rules_check   (make check)
+ *
+ * Fichier de règles temporaire (lignes invalides comprises), priorité sensor= > room= > globale,
+ * puis séquences de mesures datées, changement de pièce et lecture du journal d'événements par curseur.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "alert_rules.h"
+#include "check.h"
+
+#define T0 1700000000
+
+static const char *rules_text =
+    "# règles de test\n"
+    "above temperature 26 level=warning hyst=0.5 for=300\n"
+    "above temperature 28 level=warning hyst=0.5 room=2\n"
+    "above temperature 30 level=warning sensor=5   # remplace les deux précédentes\n"
+    "above temperature 35 level=error\n"
+    "rate temperature 5 level=warning hyst=1\n"
+    "stale - 600 level=warning\n"
+    "\n"
+    "above pressure 3\n"
+    "below humidity abc\n"
+    "above temperature 20 level=fatal\n"
+    "anomaly z=3 alpha=0.1 warmup=10 stuck=0\n"
+    "anomaly warmup=0\n";
+
+static AlertEventLog events;
+
+// Nombre d'événements ajoutés depuis le curseur *since, qui avance
+static int new_events(unsigned long *since, AlertEvent *last) {
+    AlertEvent out[ALERT_EVENT_RING];
+    int n = alert_events_since(&events, *since, out, ALERT_EVENT_RING);
+    if (n > 0) {
+        *since = out[n - 1].id;
+        if (last) *last = out[n - 1];
+    }
+    return n;
+}
+
+// Évalue une mesure de température seule (humidité neutre, pas de précédente)
+static void reading(const AlertRuleSet *set, AlertBinding *b, int sensor_id, double t, time_t at) {
+    alert_eval_reading(set, b, &events, sensor_id, t, 50.0, 0, 0, 0, at);
+}
+
+int main(void) {
+    AlertRuleSet set;
+    AlertBinding b;
+    AlertEvent e;
+    unsigned long since = 0;
+
+    // Fichier absent : règles par défaut
+    CHECK(alert_rules_load(&set, "/nonexistent/alert_rules.conf") == 11);
+    CHECK(set.anomaly.warmup == 20);
+
+    char path[] = "/tmp/alert_rules_check.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    FILE *f = fdopen(fd, "w");
+    if (!f) return 1;
+    fputs(rules_text, f);
+    fclose(f);
+
+    // Lignes invalides ignorées, warmup=0 refusé (la ligne anomaly précédente reste)
+    CHECK(alert_rules_load(&set, path) == 6);
+    unlink(path);
+    CHECK(set.rules[2].sensor_id == 5 && set.rules[1].room_id == 2);
+    CHECK(set.rules[5].kind == ALERT_STALE && set.rules[5].metric == ALERT_METRIC_NONE);
+    CHECK(set.anomaly.z == 3.0f && set.anomaly.warmup == 10 && set.anomaly.stuck == 0);
+
+    // Liaison : la règle la plus spécifique remplace celle de même kind/metric/level
+    alert_bind(&set, &b, 1, 1);
+    CHECK(b.count == 4 && b.idx[0] == 0);
+    alert_bind(&set, &b, 2, 2);
+    CHECK(b.count == 4 && b.idx[0] == 1);
+    alert_bind(&set, &b, 5, 2);
+    CHECK(b.count == 4 && b.idx[0] == 2 && b.idx[1] == 3);
+
+    // for=300 : la condition doit tenir 5 min, une interruption remet le compteur à zéro
+    alert_bind(&set, &b, 1, 1);
+    reading(&set, &b, 1, 27.0, T0);
+    reading(&set, &b, 1, 27.0, T0 + 200);
+    reading(&set, &b, 1, 25.0, T0 + 250);
+    reading(&set, &b, 1, 27.0, T0 + 300);
+    CHECK(new_events(&since, NULL) == 0);
+    reading(&set, &b, 1, 27.0, T0 + 600);
+    CHECK(new_events(&since, &e) == 1 && e.raised && e.rule == 0 && e.sensor_id == 1 && e.at == T0 + 600);
+    CHECK(b.state[0].active && b.state[0].since == T0 + 600);
+
+    // Hystérésis : retour à la normale seulement sous seuil - 0.5
+    reading(&set, &b, 1, 25.6, T0 + 700);
+    CHECK(new_events(&since, NULL) == 0 && b.state[0].active);
+    reading(&set, &b, 1, 25.4, T0 + 800);
+    CHECK(new_events(&since, &e) == 1 && !e.raised && e.value == 25.4);
+
+    // Sans durée minimale, le niveau error se déclenche et retombe immédiatement
+    reading(&set, &b, 1, 36.0, T0 + 900);
+    CHECK(new_events(&since, &e) == 1 && e.raised && e.rule == 3);
+    reading(&set, &b, 1, 34.9, T0 + 1000);
+    CHECK(new_events(&since, &e) == 1 && !e.raised && e.rule == 3);   // warning (for=300) encore en attente
+
+    // Règle sensor= : 29 °C n'alerte pas le capteur 5, 31 °C oui
+    alert_bind(&set, &b, 5, 2);
+    reading(&set, &b, 5, 29.0, T0);
+    CHECK(new_events(&since, NULL) == 0);
+    reading(&set, &b, 5, 31.0, T0 + 1);
+    CHECK(new_events(&since, &e) == 1 && e.rule == 2 && e.sensor_id == 5);
+
+    // rate : fenêtre d'au moins 5 min, 1 °C en 60 s fait 12 °C/h et non 60 °C/h
+    alert_bind(&set, &b, 1, 1);
+    alert_eval_reading(&set, &b, &events, 1, 21.0, 50.0, 20.0, 50.0, T0 + 1940, T0 + 2000);
+    CHECK(new_events(&since, &e) == 1 && e.raised && e.rule == 4 && e.value == 12.0);
+    alert_eval_reading(&set, &b, &events, 1, 21.0, 50.0, 21.0, 50.0, 0, T0 + 2300);   // pas de précédente
+    CHECK(new_events(&since, NULL) == 0);
+    alert_eval_reading(&set, &b, &events, 1, 20.65, 50.0, 21.0, 50.0, T0 + 2000, T0 + 2300);
+    CHECK(new_events(&since, NULL) == 0);   // 4.2 °C/h : encore au-dessus de 5 - 1
+    alert_eval_reading(&set, &b, &events, 1, 20.65, 50.0, 20.65, 50.0, T0 + 2300, T0 + 2600);
+    CHECK(new_events(&since, &e) == 1 && !e.raised && e.rule == 4);
+
+    // stale : jamais de mesure => rien ; retard mesuré sur la dernière capture
+    alert_eval_stale(&set, &b, &events, 1, 0, T0 + 10000);
+    CHECK(new_events(&since, NULL) == 0);
+    alert_eval_stale(&set, &b, &events, 1, T0, T0 + 500);
+    CHECK(new_events(&since, NULL) == 0);
+    alert_eval_stale(&set, &b, &events, 1, T0, T0 + 700);
+    CHECK(new_events(&since, &e) == 1 && e.raised && e.rule == 5 && e.value == 700.0);
+    alert_eval_stale(&set, &b, &events, 1, T0 + 650, T0 + 700);
+    CHECK(new_events(&since, &e) == 1 && !e.raised);
+
+    // Changement de pièce : la règle remplacée retombe, celle qui s'applique encore reste active
+    alert_bind(&set, &b, 1, 1);
+    reading(&set, &b, 1, 36.0, T0 + 5000);
+    reading(&set, &b, 1, 36.0, T0 + 5300);
+    CHECK(new_events(&since, NULL) == 2 && b.state[0].active);
+    alert_rebind(&set, &b, &events, 1, 2, T0 + 5400);
+    CHECK(new_events(&since, &e) == 1 && !e.raised && e.rule == 0 && e.value == 36.0 && e.at == T0 + 5400);
+    CHECK(b.count == 4 && b.idx[0] == 1 && !b.state[0].active);
+    CHECK(b.idx[1] == 3 && b.state[1].active && b.state[1].since == T0 + 5000);
+    reading(&set, &b, 1, 20.0, T0 + 5500);
+    CHECK(new_events(&since, &e) == 1 && !e.raised && e.rule == 3);
+    alert_rebind(&set, &b, &events, 1, 1, T0 + 5600);   // rien d'actif : pas d'événement
+    CHECK(new_events(&since, NULL) == 0 && b.idx[0] == 0);
+
+    // Libellés et messages
+    char msg[128];
+    CHECK(strcmp(alert_type_label(&set.rules[0]), "Température Élevée") == 0);
+    CHECK(strcmp(alert_type_label(&set.rules[3]), "Température Critique") == 0);
+    CHECK(strcmp(alert_level_label(set.rules[3].level), "error") == 0);
+    alert_format_message(&set.rules[3], 36.04, msg, sizeof(msg));
+    CHECK(strstr(msg, "36.0") && strstr(msg, "seuil 35.0"));
+    alert_format_message(&set.rules[5], 1800.0, msg, sizeof(msg));
+    CHECK(strstr(msg, "30 min") != NULL);
+
+    // Journal plein : seuls les ALERT_EVENT_RING derniers restent, dans l'ordre
+    for (int i = 0; i < ALERT_EVENT_RING; i++) {
+        reading(&set, &b, 1, 36.0, T0 + 3000 + 2 * i);
+        reading(&set, &b, 1, 20.0, T0 + 3001 + 2 * i);
+    }
+    AlertEvent all[ALERT_EVENT_RING + 1];
+    int n = alert_events_since(&events, 0, all, ALERT_EVENT_RING + 1);
+    CHECK(n == ALERT_EVENT_RING && all[n - 1].id == events.next_id - 1);
+    int ordered = 1;
+    for (int i = 1; i < n; i++) ordered &= all[i].id == all[i - 1].id + 1;
+    CHECK(ordered);
+    CHECK(alert_events_since(&events, events.next_id - 1, all, 4) == 0);
+    CHECK(alert_events_since(&events, events.next_id - 3, all, 4) == 2);
+
+    return check_report("alert_rules");
+}
@@ -0,0 +1,71 @@
+#include "anomaly.h"
+#include <math.h>
+#include <string.h>
+
+// Écart-type plancher : résolution du capteur (humidité entière côté client)
+#define TEMPERATURE_MIN_SD 0.05f
+#define HUMIDITY_MIN_SD    0.5f
+#define INTERVAL_MIN_SD    2.0f
+
+void anomaly_config_default(AnomalyConfig *cfg) {
+    cfg->z = 4.0f;
+    cfg->alpha = 0.05f;
+    cfg->warmup = 20;
+    cfg->stuck = 30;
+}
+
+// Renvoie 1 si x est hors de z écarts-types, puis intègre x (comparaison au carré, sans sqrt)
+static int ewma_check(EwmaStat *st, float x, float min_sd, const AnomalyConfig *cfg, int warm) {
+    float diff = x - st->mean;
+    float var = st->var > min_sd * min_sd ? st->var : min_sd * min_sd;
+    int outlier = warm && diff * diff > cfg->z * cfg->z * var;
+
+    float incr = cfg->alpha * diff;
+    st->mean += incr;
+    st->var = (1.0f - cfg->alpha) * (st->var + diff * incr);
+    return outlier;
+}
+
+uint8_t anomaly_update(const AnomalyConfig *cfg, AnomalyState *s,
+                       double temperature, double humidity, time_t captured_at, int periodic, time_t now) {
+    uint8_t flags = 0;
+    float t = (float)temperature;
+    float h = (float)humidity;
+
+    if (s->samples == 0) {
+        // Première mesure : la moyenne part de la valeur, pas de zéro (samples >= 1 ensuite, même si warmup = 0)
+        s->temperature.mean = t;
+        s->humidity.mean = h;
+    } else {
+        int warm = s->samples >= cfg->warmup;
+        if (ewma_check(&s->temperature, t, TEMPERATURE_MIN_SD, cfg, warm)) flags |= ANOMALY_TEMPERATURE_SPIKE;
+        if (ewma_check(&s->humidity, h, HUMIDITY_MIN_SD, cfg, warm)) flags |= ANOMALY_HUMIDITY_SPIKE;
+
+        // Intervalle entre captures périodiques uniquement : bande morte, heartbeat et
+        // on-demand n'ont pas de cadence ; captures rejouées hors ordre ignorées aussi
+        if (periodic && s->last_capture != 0 && captured_at > s->last_capture) {
+            float interval = (float)(captured_at - s->last_capture);
+            if (s->interval.mean == 0.0f) s->interval.mean = interval;
+            else if (ewma_check(&s->interval, interval, INTERVAL_MIN_SD, cfg, warm)) flags |= ANOMALY_INTERVAL_JITTER;
+        }
+
+        if (t != s->last_temperature) s->repeats = 0;
+        else if (s->repeats < UINT16_MAX) s->repeats++;
+        if (cfg->stuck && s->repeats >= cfg->stuck) flags |= ANOMALY_STUCK;
+    }
+
+    if (s->samples < cfg->warmup || s->samples == 0) s->samples++;
+    if (periodic && captured_at > s->last_capture) s->last_capture = captured_at;
+    s->last_temperature = t;
+
+    if (flags) {
+        s->flags = flags;
+        s->flagged_at = now;
+        s->count++;
+    }
+    return flags;
+}
+
+double anomaly_stddev(const EwmaStat *stat) {
+    return stat->var > 0.0f ? sqrt(stat->var) : 0.0;
+}
@@ -0,0 +1,54 @@
+#ifndef ANOMALY_H
+#define ANOMALY_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Détection d'anomalies en flux, mémoire constante par capteur (56 octets) :
+// moyenne/variance à lissage exponentiel (EWMA) de la température, de l'humidité
+// et de l'intervalle entre captures, mises à jour en O(1) par mesure.
+// Une mesure est signalée si |x - moyenne| dépasse z écarts-types.
+
+#define ANOMALY_TEMPERATURE_SPIKE 0x01
+#define ANOMALY_HUMIDITY_SPIKE    0x02
+#define ANOMALY_INTERVAL_JITTER   0x04   // intervalle entre captures inhabituel
+#define ANOMALY_STUCK             0x08   // température strictement identique trop longtemps
+
+#define ANOMALY_HOLD_SEC 3600   // un signalement reste visible 1 h
+
+typedef struct {
+    float z;            // seuil en écarts-types
+    float alpha;        // poids de la nouvelle mesure
+    uint16_t warmup;    // mesures avant de signaler
+    uint16_t stuck;     // répétitions identiques => ANOMALY_STUCK
+} AnomalyConfig;
+
+typedef struct {
+    float mean;
+    float var;
+} EwmaStat;
+
+typedef struct {
+    EwmaStat temperature;
+    EwmaStat humidity;
+    EwmaStat interval;
+    int64_t last_capture;   // dernière capture périodique
+    float last_temperature;
+    uint16_t samples;       // plafonné à warmup (au moins 1 une fois initialisé)
+    uint16_t repeats;
+    uint8_t flags;          // drapeaux du dernier signalement
+    uint32_t count;         // mesures signalées (cumul)
+    time_t flagged_at;
+} AnomalyState;
+
+void anomaly_config_default(AnomalyConfig *cfg);
+
+// Met à jour l'état et renvoie les drapeaux de cette mesure (0 = normale).
+// periodic = 0 (bande morte, heartbeat, on-demand) : pas de contrôle d'intervalle.
+uint8_t anomaly_update(const AnomalyConfig *cfg, AnomalyState *s,
+                       double temperature, double humidity, time_t captured_at, int periodic, time_t now);
+
+// Écart-type courant d'une statistique
+double anomaly_stddev(const EwmaStat *stat);
+
+#endif // ANOMALY_H
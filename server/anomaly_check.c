@@ -0,0 +1,96 @@
+/* anomaly_check.c - détection d'anomalies EWMA : amorçage, pics, intervalle, valeur figée
+ *
+ * Usage : ./anomaly_check   (make check)
+ *
+ * Flux synthétiques : bruit faible puis pic, cadence régulière puis trou,
+ * captures non périodiques (bande morte, on-demand), warmup = 0.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "anomaly.h"
+#include "check.h"
+
+#define T0 1700000000
+#define PERIOD 300
+
+// Bruit déterministe de +/- 0.1 autour de base
+static double noisy(double base, int i) {
+    return base + ((i * 7) % 5 - 2) * 0.05;
+}
+
+int main(void) {
+    AnomalyConfig cfg;
+    AnomalyState s;
+    uint8_t flags = 0;
+    anomaly_config_default(&cfg);
+    cfg.stuck = 0;
+
+    // Première mesure : la moyenne part de la valeur, aucun signalement pendant le warmup
+    memset(&s, 0, sizeof(s));
+    CHECK(anomaly_update(&cfg, &s, 21.0, 45.0, T0, 1, T0) == 0);
+    CHECK(s.samples == 1 && s.temperature.mean == 21.0f && s.humidity.mean == 45.0f);
+    for (int i = 1; i < cfg.warmup; i++) {
+        flags |= anomaly_update(&cfg, &s, i % 2 ? 30.0 : 12.0, 45.0, T0 + i * PERIOD, 1, 0);
+    }
+    CHECK(flags == 0 && s.samples == cfg.warmup);
+
+    // Régime établi puis pic de température
+    memset(&s, 0, sizeof(s));
+    flags = 0;
+    time_t t = T0;
+    for (int i = 0; i < 200; i++, t += PERIOD) {
+        flags |= anomaly_update(&cfg, &s, noisy(21.0, i), noisy(45.0, i), t, 1, t);
+    }
+    CHECK(flags == 0);
+    CHECK(anomaly_update(&cfg, &s, 26.0, 45.0, t, 1, t) == ANOMALY_TEMPERATURE_SPIKE);
+    CHECK(s.count == 1 && s.flagged_at == t && s.flags == ANOMALY_TEMPERATURE_SPIKE);
+    t += PERIOD;
+    CHECK(anomaly_update(&cfg, &s, 21.0, 60.0, t, 1, t) == ANOMALY_HUMIDITY_SPIKE);
+    t += PERIOD;
+
+    // Trou dans la cadence périodique : intervalle inhabituel
+    t += 10 * PERIOD;
+    CHECK(anomaly_update(&cfg, &s, 21.0, 45.0, t, 1, t) & ANOMALY_INTERVAL_JITTER);
+    for (int i = 0; i < 100; i++) {
+        t += PERIOD;
+        anomaly_update(&cfg, &s, noisy(21.0, i), noisy(45.0, i), t, 1, t);
+    }
+
+    // Captures non périodiques intercalées : jamais d'alerte d'intervalle, cadence intacte
+    flags = 0;
+    for (int i = 0; i < 50; i++) {
+        flags |= anomaly_update(&cfg, &s, noisy(21.0, i), noisy(45.0, i), t + 17 + i % 90, 0, t);
+        t += PERIOD;
+        flags |= anomaly_update(&cfg, &s, noisy(21.0, i), noisy(45.0, i), t, 1, t);
+    }
+    CHECK(flags == 0);
+
+    // Capture rejouée hors ordre : pas d'intervalle calculé
+    CHECK(anomaly_update(&cfg, &s, 21.0, 45.0, t - 50 * PERIOD, 1, t) == 0);
+    t += PERIOD;
+    CHECK(anomaly_update(&cfg, &s, 21.0, 45.0, t, 1, t) == 0);
+
+    // Valeur figée
+    cfg.stuck = 5;
+    flags = 0;
+    for (int i = 0; i < 6; i++) {
+        t += PERIOD;
+        flags = anomaly_update(&cfg, &s, 21.0, noisy(45.0, i), t, 1, t);
+    }
+    CHECK(flags & ANOMALY_STUCK);
+    t += PERIOD;
+    CHECK((anomaly_update(&cfg, &s, 21.05, 45.0, t, 1, t) & ANOMALY_STUCK) == 0);
+
+    // warmup = 0 : amorçage une seule fois, signalement dès la deuxième mesure
+    cfg.warmup = 0;
+    cfg.stuck = 0;
+    memset(&s, 0, sizeof(s));
+    anomaly_update(&cfg, &s, 21.0, 45.0, T0, 1, T0);
+    CHECK(s.samples == 1);
+    anomaly_update(&cfg, &s, 21.02, 45.0, T0 + PERIOD, 1, T0);
+    CHECK(s.temperature.mean > 21.0f && s.temperature.mean < 21.01f);
+    CHECK(anomaly_update(&cfg, &s, 30.0, 45.0, T0 + 2 * PERIOD, 1, T0) & ANOMALY_TEMPERATURE_SPIKE);
+
+    return check_report("anomaly");
+}
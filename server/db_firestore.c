@@ -4,6 +4,7 @@
 #include <string.h>
 #include <curl/curl.h>
 #include "cJSON.h"
+#include "metrics.h"
 
 // Buffer pour la réponse HTTP Firestore
 struct curl_string {
@@ -60,13 +61,19 @@ int post_reading_to_firestore(
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_writefunc);
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         
+        metrics_gauge_add(G_FIRESTORE_INFLIGHT, 1);
+        uint64_t start_ns = metrics_now_ns();
         res = curl_easy_perform(curl);
+        metrics_observe_ns(H_FIRESTORE_LATENCY, metrics_now_ns() - start_ns);
+        metrics_gauge_add(G_FIRESTORE_INFLIGHT, -1);
         if (res != CURLE_OK) {
             fprintf(stderr, "curl_easy_perform() failed: %s\n", curl_easy_strerror(res));
+            metrics_inc(M_FIRESTORE_ERROR);
             ret = 1;
         } else {
             long http_code = 0;
             curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+            metrics_inc(http_code >= 500 ? M_FIRESTORE_5XX : http_code >= 400 ? M_FIRESTORE_4XX : M_FIRESTORE_2XX);
             if (http_code == 200) {
                 printf("[Firestore] Data added successfully | room_id=%d | timestamp=%s\n", room_id, timestamp);
             } else {
@@ -0,0 +1,40 @@
+#!/bin/bash
+# Profil de benchmark de l'API HTTP : une ligne JSON par configuration (http_loadgen -j)
+# Usage : ./http_bench_profile.sh [hôte:port] [durée_sec] [fichier_sortie]
+#   ex.  ./http_bench_profile.sh localhost:8080 10 profile_$(git rev-parse --short HEAD).jsonl
+# Comparer deux fichiers (même machine, même nombre de devices) avant de déployer.
+
+HOST="${1:-localhost:8080}"
+DURATION="${2:-10}"
+OUT="${3:-http_profile.jsonl}"
+LOADGEN="$(dirname "$0")/http_loadgen"
+
+if [ ! -x "$LOADGEN" ]; then
+    echo "❌ $LOADGEN not found. Build with: make http_loadgen"
+    exit 1
+fi
+
+: > "$OUT"
+run() {
+    echo "▶ $*"
+    "$LOADGEN" -H "$HOST" -d "$DURATION" -j "$@" | tee -a "$OUT"
+}
+
+# Débit maximal par endpoint, keep-alive off / on, concurrence croissante
+for scenario in health status events recent mix; do
+    for conns in 1 10 50; do
+        run -s "$scenario" -c "$conns"
+        run -s "$scenario" -c "$conns" -k
+    done
+done
+
+# Latence à débit fixe (boucle ouverte), puis avec un client lent qui retient sa requête 2 s
+run -s mix -c 20 -r 100
+run -s mix -c 20 -r 100 -S 1 -W 2000
+
+# trigger publie de vraies commandes MQTT : seulement sur demande
+if [ "$WITH_TRIGGER" = "1" ]; then
+    run -s trigger -c 1 -r 5
+fi
+
+echo "✅ Results in $OUT"
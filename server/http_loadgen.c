@@ -0,0 +1,520 @@
+/* http_loadgen.c - générateur de charge HTTP pour l'API du serveur (epoll, un thread)
+ *
+ * Usage : ./http_loadgen [-H hôte:port] [-s scénario] [-c connexions] [-d secondes] [-r req/s]
+ *                        [-k] [-S lents] [-W ms] [-i sensor_id] [-t ms] [-j]
+ *   ex.  ./http_loadgen -s health -c 20 -d 10
+ *        ./http_loadgen -s mix -c 50 -r 200 -k -S 1 -W 5000 -j
+ *
+ *   -s  health, status, events, recent, latency, metrics, trigger, ou mix (trafic du dashboard :
+ *       health 40 %, status 20 %, events 20 %, recent 10 %, latency 5 %, metrics 5 %) ; défaut mix.
+ *       trigger publie de vraies commandes MQTT aux capteurs : jamais inclus dans mix.
+ *   -c  connexions en parallèle (10)
+ *   -r  débit visé en boucle ouverte ; la latence part alors de l'instant prévu de la requête
+ *       (les requêtes retardées par une file pleine comptent leur attente). 0 = au plus vite.
+ *   -k  keep-alive : la connexion est réutilisée tant que le serveur ne la ferme pas
+ *   -S  connexions lentes : se connectent puis n'envoient leur requête qu'après -W ms (1000),
+ *       pour mesurer l'effet d'un client lent sur les autres
+ *   -i  sensor_id des scénarios recent et trigger (1)
+ *   -t  délai maximal d'une requête en ms (5000)
+ *   -j  résultat sur une ligne JSON (profil de benchmark)
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+#define MAX_CONNECTIONS 4096
+#define RESPONSE_MAX (8 * 1024 * 1024)
+
+typedef struct {
+    const char *name;
+    const char *method;
+    const char *path;       // %d : sensor_id
+    const char *body;       // %d : sensor_id
+    int weight;             // part dans le scénario mix
+} Endpoint;
+
+static const Endpoint endpoints[] = {
+    { "health",  "GET",  "/api/system/health",               NULL, 40 },
+    { "status",  "GET",  "/api/system/status",               NULL, 20 },
+    { "events",  "GET",  "/api/system/events?since=0",       NULL, 20 },
+    { "recent",  "GET",  "/api/devices/%d/recent?window=3600", NULL, 10 },
+    { "latency", "GET",  "/api/system/latency",              NULL, 5 },
+    { "metrics", "GET",  "/metrics",                         NULL, 5 },
+    { "trigger", "POST", "/api/trigger-reading",             "{\"sensor_id\":%d}", 0 },
+};
+#define ENDPOINT_COUNT (int)(sizeof(endpoints) / sizeof(endpoints[0]))
+
+typedef struct {
+    char *text;
+    size_t len;
+    int endpoint;
+} Request;
+
+typedef enum { CONN_IDLE, CONN_CONNECTING, CONN_HOLD, CONN_WRITING, CONN_READING } ConnState;
+
+typedef struct {
+    int fd;
+    bool slow;
+    ConnState state;
+    const Request *req;
+    size_t sent;
+    char *buf;
+    size_t len, cap;
+    size_t header_len;      // 0 tant que l'en-tête n'est pas complet
+    long content_length;    // -1 : jusqu'à la fermeture
+    bool server_close;
+    int status;
+    uint64_t latency_from;  // instant prévu (boucle ouverte) ou d'envoi
+    uint64_t started;       // début réel, pour le délai maximal
+    uint64_t hold_until;
+} Conn;
+
+typedef struct {
+    unsigned long completed, ok, non_2xx, errors, timeouts, connects, slow_completed;
+    unsigned long unfinished;       // requêtes encore en cours à la fin (serveur bloqué ?)
+    unsigned long bytes;
+    unsigned long per_endpoint[ENDPOINT_COUNT];
+    uint32_t *lat_us;
+    size_t lat_count, lat_cap;
+} Stats;
+
+static struct {
+    const char *host;
+    const char *port;
+    const char *scenario;
+    int connections;
+    int duration_sec;
+    double rate;
+    bool keepalive;
+    int slow;
+    int slow_ms;
+    int sensor_id;
+    int timeout_ms;
+    bool json;
+} opts = { "localhost", "8080", "mix", 10, 10, 0, false, 0, 1000, 1, 5000, false };
+
+static struct sockaddr_storage server_addr;
+static socklen_t server_addr_len;
+static int epfd;
+static Request requests[ENDPOINT_COUNT];
+static int mix[100];            // endpoint par centile, tirage pondéré
+static int mix_size;
+static unsigned int rng = 12345;
+static Stats stats;
+static volatile sig_atomic_t stop = 0;
+
+static void on_sig(int s) { (void)s; stop = 1; }
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* ------- Requêtes ------- */
+static int build_requests(void) {
+    for (int e = 0; e < ENDPOINT_COUNT; e++) {
+        char path[256], body[128] = "";
+        snprintf(path, sizeof(path), endpoints[e].path, opts.sensor_id);
+        if (endpoints[e].body) snprintf(body, sizeof(body), endpoints[e].body, opts.sensor_id);
+
+        char text[1024];
+        int n = snprintf(text, sizeof(text),
+                         "%s %s HTTP/1.1\r\nHost: %s:%s\r\nUser-Agent: techtemp-http-loadgen\r\n"
+                         "Connection: %s\r\n", endpoints[e].method, path, opts.host, opts.port,
+                         opts.keepalive ? "keep-alive" : "close");
+        if (endpoints[e].body) {
+            n += snprintf(text + n, sizeof(text) - (size_t)n,
+                          "Content-Type: application/json\r\nContent-Length: %zu\r\n", strlen(body));
+        }
+        n += snprintf(text + n, sizeof(text) - (size_t)n, "\r\n%s", body);
+        requests[e].text = strdup(text);
+        requests[e].len = (size_t)n;
+        requests[e].endpoint = e;
+        if (!requests[e].text) return -1;
+    }
+
+    if (strcmp(opts.scenario, "mix") == 0) {
+        for (int e = 0; e < ENDPOINT_COUNT; e++) {
+            for (int w = 0; w < endpoints[e].weight && mix_size < 100; w++) mix[mix_size++] = e;
+        }
+        return 0;
+    }
+    for (int e = 0; e < ENDPOINT_COUNT; e++) {
+        if (strcmp(opts.scenario, endpoints[e].name) == 0) {
+            mix[mix_size++] = e;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static const Request* next_request(void) {
+    return &requests[mix[mix_size > 1 ? (int)(rand_r(&rng) % (unsigned int)mix_size) : 0]];
+}
+
+/* ------- Connexions ------- */
+static void conn_close(Conn *c) {
+    if (c->fd >= 0) {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+        close(c->fd);
+    }
+    c->fd = -1;
+    c->state = CONN_IDLE;
+}
+
+static void conn_watch(Conn *c, uint32_t events) {
+    struct epoll_event ev = { .events = events, .data.ptr = c };
+    epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+static void conn_write(Conn *c) {
+    while (c->sent < c->req->len) {
+        ssize_t n = send(c->fd, c->req->text + c->sent, c->req->len - c->sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                conn_watch(c, EPOLLOUT);
+                return;
+            }
+            if (!c->slow) stats.errors++;
+            conn_close(c);
+            return;
+        }
+        c->sent += (size_t)n;
+    }
+    c->state = CONN_READING;
+    c->len = 0;
+    c->header_len = 0;
+    conn_watch(c, EPOLLIN);
+}
+
+static void start_request(Conn *c, uint64_t latency_from) {
+    c->req = c->slow ? &requests[0] : next_request();
+    c->sent = 0;
+    c->started = now_ns();
+    c->latency_from = latency_from ? latency_from : c->started;
+
+    if (c->fd >= 0) {
+        c->state = CONN_WRITING;
+        conn_write(c);
+        return;
+    }
+    c->fd = socket(server_addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (c->fd < 0) {
+        stats.errors++;
+        c->state = CONN_IDLE;
+        return;
+    }
+    stats.connects++;
+    struct epoll_event ev = { .events = EPOLLOUT, .data.ptr = c };
+    epoll_ctl(epfd, EPOLL_CTL_ADD, c->fd, &ev);
+    c->state = CONN_CONNECTING;
+    if (connect(c->fd, (struct sockaddr *)&server_addr, server_addr_len) != 0 && errno != EINPROGRESS) {
+        if (!c->slow) stats.errors++;
+        conn_close(c);
+    }
+}
+
+static void on_connected(Conn *c, uint64_t now) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err != 0) {
+        if (!c->slow) stats.errors++;
+        conn_close(c);
+        return;
+    }
+    if (c->slow) {
+        // Connecté mais muet : le serveur attend la requête
+        c->state = CONN_HOLD;
+        c->hold_until = now + (uint64_t)opts.slow_ms * 1000000ull;
+        conn_watch(c, EPOLLIN);
+        return;
+    }
+    c->state = CONN_WRITING;
+    conn_write(c);
+}
+
+static void record_latency(uint64_t ns) {
+    if (stats.lat_count == stats.lat_cap) {
+        size_t cap = stats.lat_cap ? stats.lat_cap * 2 : 65536;
+        uint32_t *bigger = realloc(stats.lat_us, cap * sizeof(uint32_t));
+        if (!bigger) return;
+        stats.lat_us = bigger;
+        stats.lat_cap = cap;
+    }
+    uint64_t us = ns / 1000;
+    stats.lat_us[stats.lat_count++] = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+}
+
+static void on_response(Conn *c, uint64_t now) {
+    if (c->slow) {
+        stats.slow_completed++;
+    } else {
+        stats.completed++;
+        stats.bytes += c->len;
+        stats.per_endpoint[c->req->endpoint]++;
+        if (c->status >= 200 && c->status < 300) stats.ok++;
+        else stats.non_2xx++;
+        record_latency(now - c->latency_from);
+    }
+    if (opts.keepalive && !c->server_close) {
+        c->state = CONN_IDLE;
+        conn_watch(c, EPOLLIN);     // fermeture côté serveur détectée pendant l'attente
+    } else {
+        conn_close(c);
+    }
+}
+
+// Analyse l'en-tête dès qu'il est complet ; true si la réponse est entière
+static bool response_complete(Conn *c) {
+    if (!c->header_len) {
+        char *end = memmem(c->buf, c->len, "\r\n\r\n", 4);
+        if (!end) return false;
+        c->header_len = (size_t)(end - c->buf) + 4;
+        c->status = 0;
+        c->content_length = -1;
+        c->server_close = !opts.keepalive;
+        sscanf(c->buf, "HTTP/%*s %d", &c->status);
+        for (char *line = strstr(c->buf, "\r\n"); line && line < end; line = strstr(line + 2, "\r\n")) {
+            if (strncasecmp(line + 2, "Content-Length:", 15) == 0) {
+                c->content_length = strtol(line + 17, NULL, 10);
+            } else if (strncasecmp(line + 2, "Connection:", 11) == 0) {
+                c->server_close = strstr(line + 13, "close") != NULL || strstr(line + 13, "Close") != NULL;
+            }
+        }
+    }
+    return c->content_length >= 0 && c->len >= c->header_len + (size_t)c->content_length;
+}
+
+static void on_readable(Conn *c, uint64_t now) {
+    for (;;) {
+        if (c->cap - c->len < 4096) {
+            size_t cap = c->cap ? c->cap * 2 : 16384;
+            char *bigger = cap <= RESPONSE_MAX ? realloc(c->buf, cap + 1) : NULL;
+            if (!bigger) {
+                stats.errors++;
+                conn_close(c);
+                return;
+            }
+            c->buf = bigger;
+            c->cap = cap;
+        }
+        ssize_t n = recv(c->fd, c->buf + c->len, c->cap - c->len, 0);
+        if (n > 0) {
+            c->len += (size_t)n;
+            c->buf[c->len] = '\0';
+            if (c->state == CONN_READING && response_complete(c)) {
+                on_response(c, now);
+                return;
+            }
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+
+        // Fermeture : fin de corps sans Content-Length, sinon erreur
+        if (c->state == CONN_READING && c->header_len && c->content_length < 0) {
+            c->server_close = true;
+            on_response(c, now);
+            return;
+        }
+        if (c->state == CONN_READING && !c->slow) stats.errors++;
+        conn_close(c);
+        return;
+    }
+}
+
+static void check_timeouts(Conn *conns, int count, uint64_t now) {
+    const uint64_t limit = (uint64_t)opts.timeout_ms * 1000000ull;
+    for (int i = 0; i < count; i++) {
+        Conn *c = &conns[i];
+        if (c->state == CONN_IDLE || c->state == CONN_HOLD) continue;
+        if (now - c->started > limit) {
+            if (!c->slow) stats.timeouts++;
+            conn_close(c);
+        }
+    }
+}
+
+/* ------- Rapport ------- */
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_ms(double p) {
+    if (stats.lat_count == 0) return 0;
+    size_t idx = (size_t)(p / 100.0 * (double)(stats.lat_count - 1) + 0.5);
+    return stats.lat_us[idx] / 1000.0;
+}
+
+static void report(double elapsed) {
+    qsort(stats.lat_us, stats.lat_count, sizeof(uint32_t), cmp_u32);
+    double rps = stats.completed / elapsed;
+    double mean = 0;
+    for (size_t i = 0; i < stats.lat_count; i++) mean += stats.lat_us[i];
+    mean = stats.lat_count ? mean / stats.lat_count / 1000.0 : 0;
+
+    if (opts.json) {
+        printf("{\"scenario\":\"%s\",\"connections\":%d,\"keepalive\":%s,\"rate\":%.0f,\"slow_clients\":%d,"
+               "\"slow_ms\":%d,\"duration_sec\":%.2f,\"requests\":%lu,\"rps\":%.1f,\"ok\":%lu,\"non_2xx\":%lu,"
+               "\"errors\":%lu,\"timeouts\":%lu,\"unfinished\":%lu,\"connects\":%lu,\"bytes\":%lu,\"latency_ms\":{\"mean\":%.3f,"
+               "\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"p999\":%.3f,\"max\":%.3f}}\n",
+               opts.scenario, opts.connections, opts.keepalive ? "true" : "false", opts.rate, opts.slow,
+               opts.slow_ms, elapsed, stats.completed, rps, stats.ok, stats.non_2xx, stats.errors,
+               stats.timeouts, stats.unfinished, stats.connects, stats.bytes, mean, percentile_ms(50), percentile_ms(90),
+               percentile_ms(99), percentile_ms(99.9), percentile_ms(100));
+        return;
+    }
+    printf("%s, %d connections, keep-alive %s, %d slow clients, %.1f s\n", opts.scenario, opts.connections,
+           opts.keepalive ? "on" : "off", opts.slow, elapsed);
+    printf("  %lu requests, %.1f req/s, %.1f KB/s\n", stats.completed, rps, stats.bytes / elapsed / 1024.0);
+    printf("  %lu 2xx, %lu non-2xx, %lu errors, %lu timeouts, %lu unfinished, %lu connections opened\n",
+           stats.ok, stats.non_2xx, stats.errors, stats.timeouts, stats.unfinished, stats.connects);
+    printf("  latency ms: mean %.2f  p50 %.2f  p90 %.2f  p99 %.2f  p99.9 %.2f  max %.2f\n", mean,
+           percentile_ms(50), percentile_ms(90), percentile_ms(99), percentile_ms(99.9), percentile_ms(100));
+    for (int e = 0; e < ENDPOINT_COUNT; e++) {
+        if (stats.per_endpoint[e]) printf("  %-8s %lu\n", endpoints[e].name, stats.per_endpoint[e]);
+    }
+    if (opts.slow) printf("  slow clients served %lu times\n", stats.slow_completed);
+}
+
+static int parse_args(int argc, char **argv) {
+    static char host[128];
+    int opt;
+    while ((opt = getopt(argc, argv, "H:s:c:d:r:kS:W:i:t:j")) != -1) {
+        switch (opt) {
+            case 'H': {
+                snprintf(host, sizeof(host), "%s", optarg);
+                char *colon = strrchr(host, ':');
+                if (colon) {
+                    *colon = '\0';
+                    opts.port = colon + 1;
+                }
+                opts.host = host;
+                break;
+            }
+            case 's': opts.scenario = optarg; break;
+            case 'c': opts.connections = atoi(optarg); break;
+            case 'd': opts.duration_sec = atoi(optarg); break;
+            case 'r': opts.rate = atof(optarg); break;
+            case 'k': opts.keepalive = true; break;
+            case 'S': opts.slow = atoi(optarg); break;
+            case 'W': opts.slow_ms = atoi(optarg); break;
+            case 'i': opts.sensor_id = atoi(optarg); break;
+            case 't': opts.timeout_ms = atoi(optarg); break;
+            case 'j': opts.json = true; break;
+            default: return -1;
+        }
+    }
+    if (opts.connections <= 0 || opts.slow < 0 || opts.connections + opts.slow > MAX_CONNECTIONS ||
+        opts.duration_sec <= 0 || opts.rate < 0 || opts.slow_ms < 0 || opts.timeout_ms <= 0) return -1;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (parse_args(argc, argv) != 0 || build_requests() != 0) {
+        fprintf(stderr, "usage: %s [-H host:port] [-s health|status|events|recent|latency|metrics|trigger|mix]\n"
+                        "       [-c connections] [-d sec] [-r rps] [-k] [-S slow] [-W slow_ms] [-i sensor_id]\n"
+                        "       [-t timeout_ms] [-j]\n", argv[0]);
+        return 1;
+    }
+    signal(SIGINT, on_sig);
+    signal(SIGTERM, on_sig);
+    signal(SIGPIPE, SIG_IGN);
+
+    struct addrinfo hints = { 0 }, *res = NULL;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(opts.host, opts.port, &hints, &res) != 0 || !res) {
+        fprintf(stderr, "cannot resolve %s:%s\n", opts.host, opts.port);
+        return 1;
+    }
+    memcpy(&server_addr, res->ai_addr, res->ai_addrlen);
+    server_addr_len = res->ai_addrlen;
+    freeaddrinfo(res);
+
+    epfd = epoll_create1(0);
+    int total = opts.connections + opts.slow;
+    Conn *conns = calloc((size_t)total, sizeof(Conn));
+    if (epfd < 0 || !conns) {
+        perror("init");
+        return 1;
+    }
+    for (int i = 0; i < total; i++) {
+        conns[i].fd = -1;
+        conns[i].slow = i >= opts.connections;
+    }
+
+    const uint64_t interval = opts.rate > 0 ? (uint64_t)(1e9 / opts.rate) : 0;
+    const uint64_t start = now_ns();
+    const uint64_t end = start + (uint64_t)opts.duration_sec * 1000000000ull;
+    uint64_t next_send = start;     // boucle ouverte : instant prévu de la prochaine requête
+    struct epoll_event events[256];
+
+    // Les clients lents occupent le serveur dès le début
+    for (int i = opts.connections; i < total; i++) start_request(&conns[i], 0);
+
+    uint64_t now = start;
+    while (!stop && now < end) {
+        for (int i = 0; i < opts.connections; i++) {
+            Conn *c = &conns[i];
+            if (c->state != CONN_IDLE) continue;
+            if (interval) {
+                if (now < next_send) break;
+                start_request(c, next_send);
+                next_send += interval;
+            } else {
+                start_request(c, 0);
+            }
+        }
+        for (int i = opts.connections; i < total; i++) {
+            Conn *c = &conns[i];
+            if (c->state == CONN_IDLE) start_request(c, 0);
+            else if (c->state == CONN_HOLD && now >= c->hold_until) {
+                c->state = CONN_WRITING;
+                c->started = now;
+                conn_write(c);
+            }
+        }
+
+        int wait_ms = 10;
+        if (interval && next_send > now && (next_send - now) / 1000000 < (uint64_t)wait_ms) {
+            wait_ms = (int)((next_send - now) / 1000000);
+        }
+        int n = epoll_wait(epfd, events, 256, wait_ms);
+        now = now_ns();
+        for (int k = 0; k < n; k++) {
+            Conn *c = events[k].data.ptr;
+            if (c->fd < 0) continue;
+            if (c->state == CONN_CONNECTING) on_connected(c, now);
+            else if (c->state == CONN_WRITING) conn_write(c);
+            else on_readable(c, now);
+        }
+        check_timeouts(conns, total, now);
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+
+    for (int i = 0; i < total; i++) {
+        if (!conns[i].slow && conns[i].state != CONN_IDLE) stats.unfinished++;
+        conn_close(&conns[i]);
+        free(conns[i].buf);
+    }
+    report(elapsed);
+    for (int e = 0; e < ENDPOINT_COUNT; e++) free(requests[e].text);
+    free(stats.lat_us);
+    free(conns);
+    close(epfd);
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include "http_server.h"
 #include "system_monitor.h"
 #include "mqtt_transport.h"
+#include "metrics.h"
+#include "latency_trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,15 +12,13 @@
 #include <pthread.h>
 #include <time.h>
 
-static void send_http_response(int client_socket, int status_code, const char* content_type, const char* body) {
-    char header[1024];
-    int content_length = body ? strlen(body) : 0;
-    
+int http_format_header(char *header, size_t size, int status_code, const char* content_type, int content_length) {
     const char* status_text = (status_code == 200) ? "OK" : 
+                             (status_code == 400) ? "Bad Request" :
                              (status_code == 404) ? "Not Found" : 
                              (status_code == 500) ? "Internal Server Error" : "Unknown";
     
-    snprintf(header, sizeof(header),
+    return snprintf(header, size,
         "HTTP/1.1 %d %s\r\n"
         "Content-Type: %s\r\n"
         "Content-Length: %d\r\n"
@@ -28,28 +28,44 @@ static void send_http_response(int client_socket, int status_code, const char* c
         "Connection: close\r\n"
         "\r\n",
         status_code, status_text, content_type, content_length);
+}
+
+static void send_http_response(int client_socket, int status_code, const char* content_type, const char* body) {
+    char header[1024];
+    int content_length = body ? strlen(body) : 0;
     
-    send(client_socket, header, strlen(header), 0);
+    int header_length = http_format_header(header, sizeof(header), status_code, content_type, content_length);
+    if (header_length < 0 || header_length >= (int)sizeof(header)) return;
+    // MSG_NOSIGNAL : un client parti avant la fin ne doit pas tuer le serveur (SIGPIPE)
+    send(client_socket, header, header_length, MSG_NOSIGNAL);
     if (body && content_length > 0) {
-        send(client_socket, body, content_length, 0);
+        send(client_socket, body, content_length, MSG_NOSIGNAL);
     }
 }
 
 // Fonction pour déclencher une lecture à la demande
-static int trigger_sensor_reading(int sensor_id) {
-    char command[128];
+// Topic ciblé : le broker ne livre la commande qu'aux capteurs concernés
+//   weather/command/<sensor_id>, weather/command/room/<room_id>, weather/command/all
+static int trigger_sensor_reading(int sensor_id, int room_id) {
+    char topic[64];
+    char command[64];
+    // "ts" : une commande rejouée par la persistance (redémarrage, session durable) arrive périmée
+    snprintf(command, sizeof(command), "{\"action\":\"capture\",\"ts\":%ld}", (long)time(NULL));
     
-    if (sensor_id <= 0) {
-        // Déclencher tous les capteurs
-        snprintf(command, sizeof(command), "{\"action\":\"capture\",\"sensor_id\":\"all\"}");
-    } else {
+    if (sensor_id > 0) {
         // Déclencher un capteur spécifique
-        snprintf(command, sizeof(command), "{\"action\":\"capture\",\"sensor_id\":%d}", sensor_id);
+        snprintf(topic, sizeof(topic), "weather/command/%d", sensor_id);
+    } else if (room_id > 0) {
+        // Déclencher tous les capteurs d'une pièce
+        snprintf(topic, sizeof(topic), "weather/command/room/%d", room_id);
+    } else {
+        // Déclencher tous les capteurs
+        snprintf(topic, sizeof(topic), "weather/command/all");
     }
     
-    printf("[TRIGGER] Publishing command: %s\n", command);
+    printf("[TRIGGER] Publishing command on %s: %s\n", topic, command);
     
-    MqttSendStatus status = mqtt_publish("weather/command", command, strlen(command), 1, 0, 5000);
+    MqttSendStatus status = mqtt_publish(topic, command, strlen(command), 1, 0, 5000);
     
     if (status == MQTT_SEND_OK) {
         printf("[TRIGGER] Command sent successfully\n");
@@ -60,13 +76,15 @@ static int trigger_sensor_reading(int sensor_id) {
     }
 }
 
-static void handle_client_request(int client_socket) {
+// Renvoie la route servie (label des métriques HTTP)
+static MetricsHttpRoute handle_client_request(int client_socket) {
+    MetricsHttpRoute route = HTTP_ROUTE_OTHER;
     char buffer[2048];
     int bytes_received = recv(client_socket, buffer, sizeof(buffer) - 1, 0);
     
     if (bytes_received <= 0) {
         close(client_socket);
-        return;
+        return route;
     }
     
     buffer[bytes_received] = '\0';
@@ -76,7 +94,7 @@ static void handle_client_request(int client_socket) {
     if (sscanf(buffer, "%15s %255s %15s", method, path, version) != 3) {
         send_http_response(client_socket, 400, "text/plain", "Bad Request");
         close(client_socket);
-        return;
+        return route;
     }
     
     printf("[HTTP] %s %s\n", method, path);
@@ -85,12 +103,13 @@ static void handle_client_request(int client_socket) {
     if (strcmp(method, "OPTIONS") == 0) {
         send_http_response(client_socket, 200, "text/plain", "");
         close(client_socket);
-        return;
+        return route;
     }
     
     // Routes API
     if (strcmp(method, "GET") == 0) {
         if (strcmp(path, "/api/system/health") == 0) {
+            route = HTTP_ROUTE_HEALTH;
             char *json_status = monitor_get_json_status();
             if (json_status) {
                 send_http_response(client_socket, 200, "application/json", json_status);
@@ -98,27 +117,93 @@ static void handle_client_request(int client_socket) {
             } else {
                 send_http_response(client_socket, 500, "application/json", "{\"error\":\"Monitor not initialized\"}");
             }
+        } else if (strncmp(path, "/api/system/events", 18) == 0 && (path[18] == '\0' || path[18] == '?')) {
+            route = HTTP_ROUTE_EVENTS;
+            // Curseur : ?since=<id> renvoie les événements plus récents
+            unsigned long since = 0;
+            const char *since_str = strstr(path, "since=");
+            if (since_str) {
+                since = strtoul(since_str + 6, NULL, 10);
+            }
+            char *json_events = monitor_get_events_json(since);
+            if (json_events) {
+                send_http_response(client_socket, 200, "application/json", json_events);
+                free(json_events);
+            } else {
+                send_http_response(client_socket, 500, "application/json", "{\"error\":\"Monitor not initialized\"}");
+            }
+        } else if (strncmp(path, "/api/devices/", 13) == 0 && strstr(path, "/recent")) {
+            route = HTTP_ROUTE_RECENT;
+            // /api/devices/{id}/recent?window=<sec>&points=0|1 : servi depuis la mémoire (24 h max)
+            char *end;
+            int sensor_id = (int)strtol(path + 13, &end, 10);
+            long window = 3600;
+            bool with_points = true;
+            const char *window_str = strstr(path, "window=");
+            const char *points_str = strstr(path, "points=");
+            if (window_str) {
+                window = strtol(window_str + 7, NULL, 10);
+            }
+            if (points_str) {
+                with_points = points_str[7] != '0';
+            }
+            if (end == path + 13 || strncmp(end, "/recent", 7) != 0 || (end[7] != '\0' && end[7] != '?') ||
+                window <= 0 || window > RECENT_RING_CAPACITY * RECENT_RING_SLOT_SEC) {
+                send_http_response(client_socket, 400, "application/json", "{\"error\":\"Invalid device or window\"}");
+            } else {
+                char *json_recent = monitor_get_recent_json(sensor_id, window, with_points);
+                if (json_recent) {
+                    send_http_response(client_socket, 200, "application/json", json_recent);
+                    free(json_recent);
+                } else {
+                    send_http_response(client_socket, 404, "application/json", "{\"error\":\"Unknown device\"}");
+                }
+            }
+        } else if (strcmp(path, "/metrics") == 0) {
+            // Exposition Prometheus
+            route = HTTP_ROUTE_METRICS;
+            char *metrics = metrics_render();
+            if (metrics) {
+                send_http_response(client_socket, 200, "text/plain; version=0.0.4", metrics);
+                free(metrics);
+            } else {
+                send_http_response(client_socket, 500, "text/plain", "metrics unavailable\n");
+            }
+        } else if (strncmp(path, "/api/system/latency", 19) == 0 && (path[19] == '\0' || path[19] == '?')) {
+            // Latence par étape (capture -> Firestore) + dernières mesures lentes ;
+            // ?buckets=1 ajoute les histogrammes bruts (mqtt_loadgen les différencie)
+            route = HTTP_ROUTE_LATENCY;
+            char *json_latency = trace_get_json(strstr(path, "buckets=1") != NULL);
+            if (json_latency) {
+                send_http_response(client_socket, 200, "application/json", json_latency);
+                free(json_latency);
+            } else {
+                send_http_response(client_socket, 500, "application/json", "{\"error\":\"Out of memory\"}");
+            }
         } else if (strcmp(path, "/api/system/status") == 0) {
+            route = HTTP_ROUTE_STATUS;
             // Version simple pour debug
-            SystemHealth *health = monitor_get_system_health();
-            if (health) {
+            SystemHealth health;
+            if (monitor_get_system_health(&health) == 0) {
                 char simple_status[512];
                 snprintf(simple_status, sizeof(simple_status),
                     "{\"status\":\"%s\",\"devices\":%d,\"online\":%d,\"timestamp\":%ld}",
-                    health->global_status, health->total_devices, health->online_devices, health->last_update);
+                    health.global_status, health.total_devices, health.online_devices, health.last_update);
                 send_http_response(client_socket, 200, "application/json", simple_status);
             } else {
                 send_http_response(client_socket, 500, "application/json", "{\"error\":\"Monitor not available\"}");
             }
         } else if (strcmp(path, "/") == 0 || strcmp(path, "/health") == 0) {
-            send_http_response(client_socket, 200, "text/plain", "TechTemp System Monitor API\n\nEndpoints:\n/api/system/health - Full system status\n/api/system/status - Simple status\n/api/trigger-reading - Trigger sensor reading (POST)");
+            send_http_response(client_socket, 200, "text/plain", "TechTemp System Monitor API\n\nEndpoints:\n/api/system/health - Full system status\n/api/system/status - Simple status\n/api/system/events?since=<id> - Alert events\n/api/devices/<id>/recent?window=<sec> - Recent readings (24 h max)\n/metrics - Prometheus metrics\n/api/system/latency?buckets=0|1 - Reading latency by stage\n/api/trigger-reading - Trigger sensor reading (POST)");
         } else {
             send_http_response(client_socket, 404, "application/json", "{\"error\":\"Endpoint not found\"}");
         }
     } else if (strcmp(method, "POST") == 0) {
         if (strcmp(path, "/api/trigger-reading") == 0) {
-            // Parser le body pour récupérer sensor_id (optionnel)
+            route = HTTP_ROUTE_TRIGGER;
+            // Parser le body pour récupérer sensor_id / room_id (optionnels)
             int sensor_id = 0; // 0 = tous les capteurs
+            int room_id = 0;   // 0 = toutes les pièces
             
             // Rechercher sensor_id dans le body si présent
             char *body_start = strstr(buffer, "\r\n\r\n");
@@ -128,13 +213,17 @@ static void handle_client_request(int client_socket) {
                 if (sensor_id_str) {
                     sscanf(sensor_id_str + 12, "%d", &sensor_id);
                 }
+                char *room_id_str = strstr(body_start, "\"room_id\":");
+                if (room_id_str) {
+                    sscanf(room_id_str + 10, "%d", &room_id);
+                }
             }
             
-            if (trigger_sensor_reading(sensor_id) == 0) {
+            if (trigger_sensor_reading(sensor_id, room_id) == 0) {
                 char response[256];
                 snprintf(response, sizeof(response), 
                     "{\"status\":\"success\",\"message\":\"Reading triggered for sensor %s\",\"timestamp\":%ld}",
-                    sensor_id > 0 ? "specific" : "all",
+                    sensor_id > 0 ? "specific" : room_id > 0 ? "room" : "all",
                     time(NULL));
                 send_http_response(client_socket, 200, "application/json", response);
             } else {
@@ -148,6 +237,7 @@ static void handle_client_request(int client_socket) {
     }
     
     close(client_socket);
+    return route;
 }
 
 static void* server_thread_func(void* arg) {
@@ -209,7 +299,9 @@ static void* server_thread_func(void* arg) {
         if (activity > 0 && FD_ISSET(server_socket, &read_fds)) {
             int client_socket = accept(server_socket, (struct sockaddr*)&client_addr, &client_len);
             if (client_socket >= 0) {
-                handle_client_request(client_socket);
+                uint64_t start_ns = metrics_now_ns();
+                MetricsHttpRoute route = handle_client_request(client_socket);
+                metrics_observe_http(route, metrics_now_ns() - start_ns);
             }
         }
     }
@@ -2,6 +2,7 @@
 #define HTTP_SERVER_H
 
 #include <pthread.h>
+#include <stddef.h>
 
 // Configuration du serveur HTTP
 typedef struct {
@@ -17,4 +18,7 @@ int http_server_start(HttpServer *server);
 void http_server_stop(HttpServer *server);
 void http_server_cleanup(HttpServer *server);
 
+// En-tête de réponse (statut, Content-Type, Content-Length, CORS) ; renvoie la longueur comme snprintf
+int http_format_header(char *header, size_t size, int status_code, const char* content_type, int content_length);
+
 #endif // HTTP_SERVER_H
@@ -0,0 +1,165 @@
+#include "latency_trace.h"
+#include "cJSON.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    uint64_t counts[TRACE_HIST_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+} HdrHist;
+
+static const char *stage_names[TRACE_STAGE_COUNT] = { "transport", "decode", "monitor", "sink", "total" };
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static HdrHist hists[TRACE_STAGE_COUNT];
+static unsigned long clock_skew;    // capture postérieure à la réception (horloge client en avance)
+static ReadingTrace slow[TRACE_SLOW_RING];
+static unsigned long slow_count;
+static time_t slow_logged_at;
+
+// < 16 : un bucket par µs ; au-delà 16 sous-buckets par puissance de 2
+static int bucket_of(uint64_t v) {
+    if (v < 16) return (int)v;
+    int e = 63 - __builtin_clzll(v);
+    int idx = (e - 3) * 16 + (int)((v >> (e - 4)) & 15);
+    return idx < TRACE_HIST_BUCKETS ? idx : TRACE_HIST_BUCKETS - 1;
+}
+
+// Plus grande valeur du bucket
+static uint64_t bucket_high(int idx) {
+    if (idx < 16) return (uint64_t)idx;
+    int e = idx / 16 + 3;
+    uint64_t low = (uint64_t)(16 + idx % 16) << (e - 4);
+    return low + ((uint64_t)1 << (e - 4)) - 1;
+}
+
+static void hist_record(HdrHist *h, uint64_t v) {
+    h->counts[bucket_of(v)]++;
+    h->count++;
+    h->sum += v;
+    if (v > h->max) h->max = v;
+}
+
+static uint64_t hist_percentile(const HdrHist *h, double p) {
+    if (h->count == 0) return 0;
+    uint64_t rank = (uint64_t)(p / 100.0 * (double)h->count + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < TRACE_HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint64_t v = bucket_high(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+int64_t trace_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void record_stage(TraceStage s, int64_t from, int64_t to) {
+    if (from == 0 || to == 0) return;
+    hist_record(&hists[s], to > from ? (uint64_t)(to - from) : 0);
+}
+
+void trace_record(const ReadingTrace *t) {
+    int64_t end = t->sink_done_us ? t->sink_done_us : t->monitored_us;
+
+    pthread_mutex_lock(&trace_lock);
+    if (t->capture_us && t->capture_us > t->arrival_us) clock_skew++;
+    record_stage(TRACE_TRANSPORT, t->capture_us, t->arrival_us);
+    record_stage(TRACE_DECODE, t->arrival_us, t->decoded_us);
+    record_stage(TRACE_MONITOR, t->decoded_us, t->monitored_us);
+    record_stage(TRACE_SINK, t->sink_start_us, t->sink_done_us);
+    record_stage(TRACE_TOTAL, t->capture_us ? t->capture_us : t->arrival_us, end);
+
+    int64_t total = end - (t->capture_us ? t->capture_us : t->arrival_us);
+    bool log_it = false;
+    if (total > TRACE_SLOW_US) {
+        slow[slow_count++ % TRACE_SLOW_RING] = *t;
+        time_t now = time(NULL);
+        if (now - slow_logged_at >= TRACE_SLOW_LOG_SEC) {
+            slow_logged_at = now;
+            log_it = true;
+        }
+    }
+    pthread_mutex_unlock(&trace_lock);
+
+    if (log_it) {
+        printf("[Trace] Slow reading sensor %d seq %u: total %lld ms | transport %lld | decode %lld | "
+               "monitor %lld | sink %lld (us)\n", t->sensor_id, t->seq, (long long)(total / 1000),
+               (long long)(t->capture_us ? t->arrival_us - t->capture_us : 0),
+               (long long)(t->decoded_us - t->arrival_us), (long long)(t->monitored_us - t->decoded_us),
+               (long long)(t->sink_done_us ? t->sink_done_us - t->sink_start_us : 0));
+    }
+}
+
+static cJSON* stage_delta(int64_t from, int64_t to) {
+    return (from && to) ? cJSON_CreateNumber((double)(to - from)) : cJSON_CreateNull();
+}
+
+char* trace_get_json(bool buckets) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON *stages = cJSON_CreateObject();
+    cJSON *slow_list = cJSON_CreateArray();
+
+    pthread_mutex_lock(&trace_lock);
+    for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+        const HdrHist *h = &hists[s];
+        cJSON *st = cJSON_CreateObject();
+        cJSON_AddNumberToObject(st, "count", (double)h->count);
+        cJSON_AddNumberToObject(st, "mean_us", h->count ? (double)h->sum / (double)h->count : 0);
+        cJSON_AddNumberToObject(st, "p50_us", (double)hist_percentile(h, 50));
+        cJSON_AddNumberToObject(st, "p90_us", (double)hist_percentile(h, 90));
+        cJSON_AddNumberToObject(st, "p99_us", (double)hist_percentile(h, 99));
+        cJSON_AddNumberToObject(st, "p999_us", (double)hist_percentile(h, 99.9));
+        cJSON_AddNumberToObject(st, "max_us", (double)h->max);
+        if (buckets) {
+            cJSON *list = cJSON_CreateArray();
+            for (int i = 0; i < TRACE_HIST_BUCKETS; i++) {
+                if (h->counts[i] == 0) continue;
+                cJSON *b = cJSON_CreateArray();
+                cJSON_AddItemToArray(b, cJSON_CreateNumber((double)bucket_high(i)));
+                cJSON_AddItemToArray(b, cJSON_CreateNumber((double)h->counts[i]));
+                cJSON_AddItemToArray(list, b);
+            }
+            cJSON_AddNumberToObject(st, "sum_us", (double)h->sum);
+            cJSON_AddItemToObject(st, "buckets", list);
+        }
+        cJSON_AddItemToObject(stages, stage_names[s], st);
+    }
+    cJSON_AddNumberToObject(root, "clock_skew", clock_skew);
+    cJSON_AddNumberToObject(root, "slow_threshold_us", TRACE_SLOW_US);
+    cJSON_AddNumberToObject(root, "slow_total", slow_count);
+
+    // Mesures lentes, plus récentes d'abord, avec le détail par étape
+    unsigned long n = slow_count < TRACE_SLOW_RING ? slow_count : TRACE_SLOW_RING;
+    for (unsigned long i = 0; i < n; i++) {
+        const ReadingTrace *t = &slow[(slow_count - 1 - i) % TRACE_SLOW_RING];
+        cJSON *e = cJSON_CreateObject();
+        cJSON_AddNumberToObject(e, "sensor_id", t->sensor_id);
+        cJSON_AddNumberToObject(e, "seq", t->seq);
+        cJSON_AddNumberToObject(e, "arrival_us", (double)t->arrival_us);
+        cJSON_AddItemToObject(e, "transport_us", stage_delta(t->capture_us, t->arrival_us));
+        cJSON_AddItemToObject(e, "decode_us", stage_delta(t->arrival_us, t->decoded_us));
+        cJSON_AddItemToObject(e, "monitor_us", stage_delta(t->decoded_us, t->monitored_us));
+        cJSON_AddItemToObject(e, "sink_us", stage_delta(t->sink_start_us, t->sink_done_us));
+        cJSON_AddItemToArray(slow_list, e);
+    }
+    pthread_mutex_unlock(&trace_lock);
+
+    cJSON_AddItemToObject(root, "stages", stages);
+    cJSON_AddItemToObject(root, "slow", slow_list);
+    char *json_string = cJSON_Print(root);
+    cJSON_Delete(root);
+    return json_string;
+}
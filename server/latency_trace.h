@@ -0,0 +1,49 @@
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Traçage de latence de bout en bout d'une mesure :
+//   capture client ("ts_ms") -> réception MQTT (msgarrvd) -> décodage JSON
+//   -> mise à jour du monitor -> envoi Firestore -> réponse Firestore.
+// Un histogramme log-linéaire (style HDR, 16 sous-buckets par puissance de 2,
+// erreur relative <= 6,25 %) par étape, en microsecondes.
+
+#define TRACE_HIST_BUCKETS 608      // valeurs jusqu'à 2^40 µs
+#define TRACE_SLOW_US 2000000       // au-delà : gardée dans le journal des mesures lentes
+#define TRACE_SLOW_RING 32
+#define TRACE_SLOW_LOG_SEC 10       // au plus une ligne de log par intervalle
+
+typedef enum {
+    TRACE_TRANSPORT = 0,    // capture -> réception (réseau, broker, horloges)
+    TRACE_DECODE,           // réception -> JSON décodé
+    TRACE_MONITOR,          // décodé -> monitor à jour
+    TRACE_SINK,             // envoi -> réponse Firestore
+    TRACE_TOTAL,            // capture -> fin d'ingestion
+    TRACE_STAGE_COUNT
+} TraceStage;
+
+// Horodatages d'une mesure (µs epoch, 0 = étape absente)
+typedef struct {
+    int sensor_id;
+    uint32_t seq;
+    int64_t capture_us;
+    int64_t arrival_us;
+    int64_t decoded_us;
+    int64_t monitored_us;
+    int64_t sink_start_us;
+    int64_t sink_done_us;
+} ReadingTrace;
+
+int64_t trace_now_us(void);     // CLOCK_REALTIME, comparable à l'horloge des clients (NTP)
+
+// Enregistre une mesure terminée (thread-safe)
+void trace_record(const ReadingTrace *t);
+
+// {"stages":{"transport":{"count","mean_us","p50_us",..,"max_us"},..},"clock_skew":..,"slow":[..]}
+// buckets : chaque étape ajoute "sum_us" et "buckets":[[haut_us,n],..] (buckets non vides,
+// cumul depuis le démarrage) ; la différence de deux relevés donne l'histogramme d'une fenêtre
+char* trace_get_json(bool buckets);
+
+#endif // LATENCY_TRACE_H
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <unistd.h>
 #include <stdbool.h>
 #include "mqtt_transport.h"
 #include "sqlite3.h"
@@ -12,9 +13,15 @@
 #include "db_firestore.h"
 #include "system_monitor.h"
 #include "http_server.h"
+#include "metrics.h"
+#include "latency_trace.h"
+#include "weather_payload.h"
 
 
 
+// Journal des QoS1 en vol : chemin absolu, indépendant du répertoire de lancement
+#define DEFAULT_PERSIST_DIR "/home/pi/Documents/techtemp/server-mqtt-persist"
+
 volatile sig_atomic_t keepRunning = 1;
 static HttpServer http_server;
 
@@ -24,59 +31,234 @@ void handleSignal(int signal) {
 }
 
 // Callback MQTT: message reçu
+/* Traite une mesure : monitoring temps réel + Firestore (sauf on-demand) */
+static void ingest_reading(AppContext *appContext, int sensor_id, int room_id,
+                           double temperature, double humidity,
+                           const char *trigger_type, time_t captured_at, uint64_t received_ns,
+                           ReadingTrace *trace) {
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&captured_at));
+    
+    // Mettre à jour le monitoring temps réel (toujours)
+    monitor_update_device(sensor_id, room_id, temperature, humidity, captured_at, trigger_type);
+    if (trace) trace->monitored_us = trace_now_us();
+    
+    // Vérifier si c'est une lecture immédiate (on-demand)
+    bool is_immediate = false;
+    if (trigger_type && strcmp(trigger_type, "on-demand") == 0) {
+        is_immediate = true;
+        printf("[MQTT] Immediate reading received from sensor %d - skipping Firestore\n", sensor_id);
+    }
+    
+    // Envoyer à Firestore seulement si ce n'est PAS une lecture immédiate
+    if (appContext->use_firestore && !is_immediate) {
+        extern int post_reading_to_firestore(int sensor_id, int room_id, double temperature, double humidity, const char *timestamp, const char *firestore_url, const char *auth_token);
+        if (trace) trace->sink_start_us = trace_now_us();
+        post_reading_to_firestore(sensor_id, room_id, temperature, humidity, timestamp, appContext->firestore_url, appContext->auth_token);
+        if (trace) trace->sink_done_us = trace_now_us();
+    } else if (is_immediate) {
+        printf("[MQTT] Immediate reading from sensor %d - Firestore storage skipped\n", sensor_id);
+    }
+    metrics_inc(M_READINGS_INGESTED);
+    metrics_observe_ns(H_INGEST_LATENCY, metrics_now_ns() - received_ns);
+    if (trace) trace_record(trace);
+}
+
+/* Dédoublonnage par (boot, seq) du client ; false si déjà reçu.
+   Messages sans séquence (anciens clients) : toujours acceptés. */
+static bool accept_sequence(int sensor_id, int room_id, const WeatherReading *r) {
+    if (!r->has_seq) return true;
+    if (monitor_accept_sequence(sensor_id, room_id, r->boot, r->seq) == SEQ_DUPLICATE) {
+        metrics_inc(M_MQTT_DROPPED_DUPLICATE);
+        printf("[MQTT] Duplicate reading from sensor %d (boot %u, seq %u) dropped\n", sensor_id, r->boot, r->seq);
+        return false;
+    }
+    return true;
+}
+
 void on_mqtt_msg(const char* topic, const void* payload, size_t len, void* user) {
     AppContext *appContext = (AppContext*)user;
+    uint64_t received_ns = metrics_now_ns();
+    ReadingTrace trace = { 0 };
+    trace.arrival_us = mqtt_message_arrival_us();
+    if (trace.arrival_us == 0) trace.arrival_us = trace_now_us();
+    metrics_inc(M_MQTT_RECEIVED_WEATHER);
+    WeatherPayload p;
+    if (weather_payload_decode(&p, payload, len, time(NULL)) != 0) {
+        metrics_inc(M_MQTT_DROPPED_PARSE);
+        weather_payload_free(&p);
+        return;
+    }
+    trace.decoded_us = trace_now_us();
+    metrics_inc(M_MQTT_DECODED);
+    
+    // Firestore + Monitor
+    switch (p.kind) {
+        case WEATHER_READING: {
+            const WeatherReading *r = &p.readings[0];
+            if (accept_sequence(p.sensor_id, p.room_id, r)) {
+                // Mesure en direct : tracée de la capture (ts_ms du client) jusqu'à Firestore
+                trace.sensor_id = p.sensor_id;
+                trace.seq = r->seq;
+                trace.capture_us = r->captured_ms * 1000;
+                ingest_reading(appContext, p.sensor_id, p.room_id, r->temperature, r->humidity,
+                               r->trigger, r->captured_at, received_ns, &trace);
+            }
+            break;
+        }
+        case WEATHER_BATCH: {
+            // Lot de mesures mises en attente hors-ligne par le client : horodatage de capture
+            int count = 0;
+            if (p.invalid > 0) metrics_add(M_MQTT_DROPPED_INVALID, (uint64_t)p.invalid);
+            for (int i = 0; i < p.count; i++) {
+                const WeatherReading *r = &p.readings[i];
+                if (!accept_sequence(p.sensor_id, p.room_id, r)) continue;
+                ingest_reading(appContext, p.sensor_id, p.room_id, r->temperature, r->humidity,
+                               r->trigger, r->captured_at, received_ns, NULL);
+                count++;
+            }
+            printf("[MQTT] Backlog batch from sensor %d: %d readings\n", p.sensor_id, count);
+            break;
+        }
+        case WEATHER_SUMMARY: {
+            // Résumé d'agrégation en bordure : la moyenne alimente l'historique, min/max/last le monitoring
+            const WeatherReading *r = &p.readings[0];
+            if (accept_sequence(p.sensor_id, p.room_id, r)) {
+                ingest_reading(appContext, p.sensor_id, p.room_id, r->temperature, r->humidity,
+                               r->trigger, r->captured_at, received_ns, NULL);
+                monitor_update_summary(p.sensor_id, &p.summary);
+            }
+            break;
+        }
+        default:
+            metrics_inc(M_MQTT_DROPPED_INVALID);
+            break;
+    }
+    weather_payload_free(&p);
+}
+
+// Télémétrie I2C du client (weather/telemetry) : compteurs, latences, erreurs CRC
+static unsigned int json_uint(const cJSON *obj, const char *key) {
+    const cJSON *v = cJSON_GetObjectItemCaseSensitive(obj, key);
+    return (cJSON_IsNumber(v) && v->valuedouble > 0) ? (unsigned int)v->valuedouble : 0;
+}
+
+static void json_uint_array(const cJSON *arr, unsigned int *out, int n) {
+    int i = 0;
+    const cJSON *v;
+    cJSON_ArrayForEach(v, arr) {
+        if (i >= n) break;
+        out[i++] = (cJSON_IsNumber(v) && v->valuedouble > 0) ? (unsigned int)v->valuedouble : 0;
+    }
+}
+
+void on_telemetry_msg(const char* topic, const void* payload, size_t len, void* user) {
+    static const char *op_names[TELEMETRY_OPS] = { "write", "read", "combined" };
+    (void)topic;
+    (void)user;
+    metrics_inc(M_MQTT_RECEIVED_TELEMETRY);
     char* msg = malloc(len+1);
+    if (!msg) return;
     memcpy(msg, payload, len);
     msg[len] = '\0';
     cJSON *json = cJSON_Parse(msg);
     free(msg);
     if (!json) return;
-    const cJSON *sensor_id_json = cJSON_GetObjectItemCaseSensitive(json, "sensor_id");
-    const cJSON *room_id_json = cJSON_GetObjectItemCaseSensitive(json, "room_id");
-    const cJSON *temperature_json = cJSON_GetObjectItemCaseSensitive(json, "temperature");
-    const cJSON *humidity_json = cJSON_GetObjectItemCaseSensitive(json, "humidity");
-    const cJSON *trigger_json = cJSON_GetObjectItemCaseSensitive(json, "trigger");
     
-    // Firestore + Monitor
-    if (cJSON_IsNumber(sensor_id_json) && cJSON_IsNumber(temperature_json) && cJSON_IsNumber(humidity_json)) {
-        int sensor_id = sensor_id_json->valueint;
-        double temperature = temperature_json->valuedouble;
-        double humidity = humidity_json->valuedouble;
-        int room_id = room_id_json->valueint;
-        char timestamp[32];
-        time_t now = time(NULL);
-        strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
-        
-        // Mettre à jour le monitoring temps réel (toujours)
-        monitor_update_device(sensor_id, room_id, temperature, humidity);
-        
-        // Vérifier si c'est une lecture immédiate (on-demand)
-        bool is_immediate = false;
-        if (cJSON_IsString(trigger_json)) {
-            const char* trigger_type = cJSON_GetStringValue(trigger_json);
-            if (trigger_type && strcmp(trigger_type, "on-demand") == 0) {
-                is_immediate = true;
-                printf("[MQTT] Immediate reading received from sensor %d - skipping Firestore\n", sensor_id);
-            }
+    const cJSON *sensor_id_json = cJSON_GetObjectItemCaseSensitive(json, "sensor_id");
+    const cJSON *aht20 = cJSON_GetObjectItemCaseSensitive(json, "aht20");
+    const cJSON *i2c = cJSON_GetObjectItemCaseSensitive(json, "i2c");
+    if (cJSON_IsNumber(sensor_id_json) && cJSON_IsObject(i2c)) {
+        DeviceTelemetry t;
+        memset(&t, 0, sizeof(t));
+        t.uptime_sec = (long)json_uint(json, "uptime_sec");
+        t.measurements = json_uint(aht20, "measurements");
+        t.iic_errors = json_uint(aht20, "iic_errors");
+        t.crc_errors = json_uint(aht20, "crc_errors");
+        t.busy_timeouts = json_uint(aht20, "busy_timeouts");
+        t.busy_at_fetch = json_uint(aht20, "busy_at_fetch");
+        json_uint_array(cJSON_GetObjectItemCaseSensitive(i2c, "bounds_us"), t.bounds_us, TELEMETRY_HIST_BUCKETS);
+        for (int op = 0; op < TELEMETRY_OPS; op++) {
+            const cJSON *o = cJSON_GetObjectItemCaseSensitive(i2c, op_names[op]);
+            t.ops[op].count = json_uint(o, "count");
+            t.ops[op].errors = json_uint(o, "errors");
+            t.ops[op].nak = json_uint(o, "nak");
+            t.ops[op].avg_us = json_uint(o, "avg_us");
+            t.ops[op].max_us = json_uint(o, "max_us");
+            json_uint_array(cJSON_GetObjectItemCaseSensitive(o, "hist"), t.ops[op].hist, TELEMETRY_HIST_BUCKETS);
         }
-        
-        // Envoyer à Firestore seulement si ce n'est PAS une lecture immédiate
-        if (appContext->use_firestore && !is_immediate) {
-            extern int post_reading_to_firestore(int sensor_id, int room_id, double temperature, double humidity, const char *timestamp, const char *firestore_url, const char *auth_token);
-            post_reading_to_firestore(sensor_id, room_id, temperature, humidity, timestamp, appContext->firestore_url, appContext->auth_token);
-        } else if (is_immediate) {
-            printf("[MQTT] Immediate reading from sensor %d - Firestore storage skipped\n", sensor_id);
+        if (monitor_update_telemetry(sensor_id_json->valueint, &t) != 0) {
+            printf("[MQTT] Telemetry from unknown sensor %d ignored\n", sensor_id_json->valueint);
         }
     }
     cJSON_Delete(json);
 }
 
+// Statut du client (weather/status/<sensor_id>, weather/status pour les anciens clients) :
+// {"sensor_id","room_id","status":"online"|"offline"}.
+// Publié retenu et en Last-Will : la déconnexion est connue dès l'expiration du keepalive.
+void on_status_msg(const char* topic, const void* payload, size_t len, void* user) {
+    (void)topic;
+    (void)user;
+    metrics_inc(M_MQTT_RECEIVED_STATUS);
+    char* msg = malloc(len+1);
+    if (!msg) return;
+    memcpy(msg, payload, len);
+    msg[len] = '\0';
+    cJSON *json = cJSON_Parse(msg);
+    free(msg);
+    if (!json) return;
+    
+    const cJSON *sensor_id_json = cJSON_GetObjectItemCaseSensitive(json, "sensor_id");
+    const cJSON *room_id_json = cJSON_GetObjectItemCaseSensitive(json, "room_id");
+    const char *status = cJSON_GetStringValue(cJSON_GetObjectItemCaseSensitive(json, "status"));
+    if (cJSON_IsNumber(sensor_id_json) && status &&
+        (strcmp(status, "online") == 0 || strcmp(status, "offline") == 0)) {
+        int room_id = cJSON_IsNumber(room_id_json) ? room_id_json->valueint : 0;
+        monitor_update_presence(sensor_id_json->valueint, room_id, strcmp(status, "online") == 0);
+        printf("[MQTT] Sensor %d is %s\n", sensor_id_json->valueint, status);
+    }
+    cJSON_Delete(json);
+}
+
+/* Demande au client de republier les séquences manquantes (une par tick au plus) */
+static void dispatch_backfill(void) {
+    int sensor_id;
+    uint32_t boot, from, to;
+    if (!monitor_next_backfill(&sensor_id, &boot, &from, &to)) return;
+    
+    char topic[64];
+    char command[128];
+    snprintf(topic, sizeof(topic), "weather/command/%d", sensor_id);
+    snprintf(command, sizeof(command),
+             "{\"action\":\"backfill\",\"sensor_id\":%d,\"boot\":%u,\"from\":%u,\"to\":%u}",
+             sensor_id, boot, from, to);
+    MqttSendStatus status = mqtt_publish(topic, command, strlen(command), 1, 0, 5000);
+    printf("[BACKFILL] sensor %d seq %u..%u requested (%s)\n", sensor_id, from, to,
+           status == MQTT_SEND_OK ? "sent" : "send failed, will retry");
+}
+
 int main(int argc, char *argv[]) {
     printf("[Main] TechTemp Server with Real-time Monitoring starting...\n");
     
+    // -d N : capacité de la table des devices (MAX_DEVICES par défaut ; tests de charge)
+    // -p dir : répertoire du journal MQTT (DEFAULT_PERSIST_DIR)
+    int max_devices = MAX_DEVICES;
+    const char *persist_dir = DEFAULT_PERSIST_DIR;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:p:")) != -1) {
+        if (opt == 'd' && atoi(optarg) > 0) {
+            max_devices = atoi(optarg);
+        } else if (opt == 'p' && optarg[0] != '\0') {
+            persist_dir = optarg;
+        } else {
+            fprintf(stderr, "usage: %s [-d max_devices] [-p persist_dir]\n", argv[0]);
+            return 1;
+        }
+    }
+    
     // Initialiser le système de monitoring
-    if (monitor_init() != 0) {
+    if (monitor_init_capacity(max_devices) != 0) {
         fprintf(stderr, "Failed to initialize system monitor\n");
         return 1;
     }
@@ -93,24 +275,30 @@ int main(int argc, char *argv[]) {
     db_firestore_init(&(appContext->firestore_url), &(appContext->auth_token));
 
     // Config MQTT
-    const char* topics[] = { "weather", NULL };
-    int qos[] = { 1 };
+    // Session durable + journal mmap : le broker garde les QoS1 pendant un redémarrage.
+    // Les commandes de capture rejouées après coup portent leur "ts" : le client écarte les périmées.
+    mqtt_subscribe_handler("weather", 1, on_mqtt_msg, appContext);
+    mqtt_subscribe_handler("weather/telemetry", 0, on_telemetry_msg, NULL);
+    // Statuts retenus, un topic par capteur : le broker les rejoue tous à l'abonnement,
+    // la présence de chaque device est connue dès le démarrage
+    mqtt_subscribe_handler("weather/status/+", 1, on_status_msg, NULL);
+    mqtt_subscribe_handler("weather/status", 1, on_status_msg, NULL);   // anciens clients
     MqttConfig mqtt_cfg = {
         .address = "tcp://localhost:1883",
         .client_id = "techtemp_server",
         .keepalive_sec = 20,
-        .clean_session = 1,
+        .clean_session = 0,
         .automatic_reconnect = 1,
         .min_retry_sec = 1,
         .max_retry_sec = 30,
         .username = NULL,
         .password = NULL,
         .will = NULL,
-        .persist = MQTT_PERSIST_NONE,
-        .persist_dir = NULL,
-        .init_topics = topics,
-        .init_qos = qos,
-        .on_msg = on_mqtt_msg,
+        .persist = MQTT_PERSIST_MMAP,
+        .persist_dir = persist_dir,
+        .init_topics = NULL,
+        .init_qos = NULL,
+        .on_msg = NULL,
         .on_conn_lost = NULL,
         .on_delivered = NULL,
         .user = appContext,
@@ -142,6 +330,10 @@ int main(int argc, char *argv[]) {
     signal(SIGINT, handleSignal);
     while (keepRunning) {
         sleep_ms(1000); // Check every second
+        // Publié depuis ce thread : attendre le PUBACK dans un callback MQTT bloquerait Paho
+        dispatch_backfill();
+        // Règles "stale" : évaluées même sans mesure ni requête HTTP
+        monitor_check_alerts();
     }
 
     // Nettoyage propre
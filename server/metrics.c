@@ -0,0 +1,177 @@
+#include "metrics.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const uint64_t bucket_bounds_ns[METRICS_BUCKETS] = {
+    100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000, 25000000,
+    50000000, 100000000, 250000000, 500000000, 1000000000, 2500000000ULL, 5000000000ULL, 10000000000ULL
+};
+
+// Un shard par thread (attribué au premier enregistrement), aligné sur une ligne de cache
+typedef struct {
+    _Atomic uint64_t counters[M_COUNTER_COUNT];
+    _Atomic uint64_t http_requests[HTTP_ROUTE_COUNT];
+    _Atomic uint64_t buckets[H_HISTOGRAM_COUNT][METRICS_BUCKETS + 1];
+    _Atomic uint64_t sum_ns[H_HISTOGRAM_COUNT];
+} __attribute__((aligned(64))) MetricsShard;
+
+static MetricsShard shards[METRICS_SHARDS];
+static _Atomic int64_t gauges[G_GAUGE_COUNT];
+static atomic_uint next_shard;
+static _Thread_local MetricsShard *my_shard;
+
+// Nom, label et aide de chaque série ; les séries consécutives de même nom forment une famille
+static const struct {
+    const char *name;
+    const char *labels;
+    const char *help;
+} counter_defs[M_COUNTER_COUNT] = {
+    { "techtemp_mqtt_messages_received_total", "topic=\"weather\"", "MQTT messages received" },
+    { "techtemp_mqtt_messages_received_total", "topic=\"weather/status\"", NULL },
+    { "techtemp_mqtt_messages_received_total", "topic=\"weather/telemetry\"", NULL },
+    { "techtemp_mqtt_messages_decoded_total", NULL, "MQTT messages parsed as JSON" },
+    { "techtemp_mqtt_messages_dropped_total", "reason=\"parse\"", "MQTT messages or readings dropped" },
+    { "techtemp_mqtt_messages_dropped_total", "reason=\"invalid\"", NULL },
+    { "techtemp_mqtt_messages_dropped_total", "reason=\"duplicate\"", NULL },
+    { "techtemp_readings_ingested_total", NULL, "Readings fed to the monitor" },
+    { "techtemp_firestore_requests_total", "code=\"2xx\"", "Firestore requests by status class" },
+    { "techtemp_firestore_requests_total", "code=\"4xx\"", NULL },
+    { "techtemp_firestore_requests_total", "code=\"5xx\"", NULL },
+    { "techtemp_firestore_requests_total", "code=\"error\"", NULL },
+};
+
+static const struct {
+    const char *name;
+    const char *labels;
+    const char *help;
+} gauge_defs[G_GAUGE_COUNT] = {
+    { "techtemp_devices", "state=\"online\"", "Known devices by status" },
+    { "techtemp_devices", "state=\"warning\"", NULL },
+    { "techtemp_devices", "state=\"offline\"", NULL },
+    { "techtemp_firestore_inflight", NULL, "Firestore requests in progress" },
+};
+
+static const char *route_names[HTTP_ROUTE_COUNT] = {
+    "health", "status", "events", "recent", "metrics", "latency", "trigger", "other"
+};
+
+static MetricsShard* shard(void) {
+    if (!my_shard) {
+        my_shard = &shards[atomic_fetch_add_explicit(&next_shard, 1, memory_order_relaxed) % METRICS_SHARDS];
+    }
+    return my_shard;
+}
+
+uint64_t metrics_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void metrics_inc(MetricCounter c) {
+    atomic_fetch_add_explicit(&shard()->counters[c], 1, memory_order_relaxed);
+}
+
+void metrics_add(MetricCounter c, uint64_t n) {
+    atomic_fetch_add_explicit(&shard()->counters[c], n, memory_order_relaxed);
+}
+
+void metrics_gauge_set(MetricGauge g, int64_t v) {
+    atomic_store_explicit(&gauges[g], v, memory_order_relaxed);
+}
+
+void metrics_gauge_add(MetricGauge g, int64_t delta) {
+    atomic_fetch_add_explicit(&gauges[g], delta, memory_order_relaxed);
+}
+
+void metrics_observe_ns(MetricHistogram h, uint64_t ns) {
+    int b = 0;
+    while (b < METRICS_BUCKETS && ns > bucket_bounds_ns[b]) b++;
+    MetricsShard *s = shard();
+    atomic_fetch_add_explicit(&s->buckets[h][b], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->sum_ns[h], ns, memory_order_relaxed);
+}
+
+void metrics_observe_http(MetricsHttpRoute route, uint64_t ns) {
+    atomic_fetch_add_explicit(&shard()->http_requests[route], 1, memory_order_relaxed);
+    metrics_observe_ns((MetricHistogram)(H_HTTP_LATENCY + route), ns);
+}
+
+static uint64_t sum_shards(const _Atomic uint64_t *first, size_t stride) {
+    uint64_t total = 0;
+    for (int i = 0; i < METRICS_SHARDS; i++) {
+        total += atomic_load_explicit((const _Atomic uint64_t *)((const char *)first + i * stride),
+                                      memory_order_relaxed);
+    }
+    return total;
+}
+
+#define SHARD_SUM(field) sum_shards(&shards[0].field, sizeof(MetricsShard))
+
+static void print_header(FILE *out, const char *name, const char *help, const char *type) {
+    fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void print_histogram(FILE *out, const char *name, const char *label, MetricHistogram h) {
+    const char *sep = label ? "," : "";
+    uint64_t cumulative = 0;
+    for (int b = 0; b <= METRICS_BUCKETS; b++) {
+        cumulative += SHARD_SUM(buckets[h][b]);
+        if (b < METRICS_BUCKETS) {
+            fprintf(out, "%s_bucket{%s%sle=\"%g\"} %llu\n", name, label ? label : "", sep,
+                    bucket_bounds_ns[b] / 1e9, (unsigned long long)cumulative);
+        } else {
+            fprintf(out, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, label ? label : "", sep,
+                    (unsigned long long)cumulative);
+        }
+    }
+    const char *open = label ? "{" : "", *close = label ? "}" : "";
+    fprintf(out, "%s_sum%s%s%s %.9f\n", name, open, label ? label : "", close, SHARD_SUM(sum_ns[h]) / 1e9);
+    fprintf(out, "%s_count%s%s%s %llu\n", name, open, label ? label : "", close, (unsigned long long)cumulative);
+}
+
+char* metrics_render(void) {
+    char *text = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    if (!out) return NULL;
+
+    for (int c = 0; c < M_COUNTER_COUNT; c++) {
+        if (counter_defs[c].help) print_header(out, counter_defs[c].name, counter_defs[c].help, "counter");
+        fprintf(out, "%s%s%s%s %llu\n", counter_defs[c].name, counter_defs[c].labels ? "{" : "",
+                counter_defs[c].labels ? counter_defs[c].labels : "", counter_defs[c].labels ? "}" : "",
+                (unsigned long long)SHARD_SUM(counters[c]));
+    }
+
+    print_header(out, "techtemp_http_requests_total", "HTTP requests by route", "counter");
+    for (int r = 0; r < HTTP_ROUTE_COUNT; r++) {
+        fprintf(out, "techtemp_http_requests_total{route=\"%s\"} %llu\n", route_names[r],
+                (unsigned long long)SHARD_SUM(http_requests[r]));
+    }
+
+    for (int g = 0; g < G_GAUGE_COUNT; g++) {
+        if (gauge_defs[g].help) print_header(out, gauge_defs[g].name, gauge_defs[g].help, "gauge");
+        fprintf(out, "%s%s%s%s %lld\n", gauge_defs[g].name, gauge_defs[g].labels ? "{" : "",
+                gauge_defs[g].labels ? gauge_defs[g].labels : "", gauge_defs[g].labels ? "}" : "",
+                (long long)atomic_load_explicit(&gauges[g], memory_order_relaxed));
+    }
+
+    print_header(out, "techtemp_ingest_latency_seconds", "MQTT arrival to end of ingestion", "histogram");
+    print_histogram(out, "techtemp_ingest_latency_seconds", NULL, H_INGEST_LATENCY);
+    print_header(out, "techtemp_firestore_request_seconds", "Firestore request duration", "histogram");
+    print_histogram(out, "techtemp_firestore_request_seconds", NULL, H_FIRESTORE_LATENCY);
+    print_header(out, "techtemp_http_request_seconds", "HTTP request handling time", "histogram");
+    for (int r = 0; r < HTTP_ROUTE_COUNT; r++) {
+        char label[32];
+        snprintf(label, sizeof(label), "route=\"%s\"", route_names[r]);
+        print_histogram(out, "techtemp_http_request_seconds", label, (MetricHistogram)(H_HTTP_LATENCY + r));
+    }
+
+    if (fclose(out) != 0) {
+        free(text);
+        return NULL;
+    }
+    return text;
+}
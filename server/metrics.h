@@ -0,0 +1,71 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+
+// Métriques internes du serveur, exposées au format texte Prometheus sur /metrics.
+// Compteurs et histogrammes répartis en shards par thread (atomiques relaxés, pas de
+// verrou ni de partage de ligne de cache entre threads) ; additionnés au rendu seulement.
+
+#define METRICS_SHARDS 8
+#define METRICS_BUCKETS 16   // bornes fixes de 100 µs à 10 s, + bucket +Inf
+
+typedef enum {
+    M_MQTT_RECEIVED_WEATHER = 0,
+    M_MQTT_RECEIVED_STATUS,
+    M_MQTT_RECEIVED_TELEMETRY,
+    M_MQTT_DECODED,
+    M_MQTT_DROPPED_PARSE,       // JSON illisible
+    M_MQTT_DROPPED_INVALID,     // champs manquants
+    M_MQTT_DROPPED_DUPLICATE,   // (boot, seq) déjà reçu
+    M_READINGS_INGESTED,
+    M_FIRESTORE_2XX,
+    M_FIRESTORE_4XX,
+    M_FIRESTORE_5XX,
+    M_FIRESTORE_ERROR,          // échec réseau / curl
+    M_COUNTER_COUNT
+} MetricCounter;
+
+typedef enum {
+    G_DEVICES_ONLINE = 0,
+    G_DEVICES_WARNING,
+    G_DEVICES_OFFLINE,
+    G_FIRESTORE_INFLIGHT,       // requêtes Firestore en cours (envoi synchrone, pas de file)
+    G_GAUGE_COUNT
+} MetricGauge;
+
+// Routes HTTP (label route="...")
+typedef enum {
+    HTTP_ROUTE_HEALTH = 0,
+    HTTP_ROUTE_STATUS,
+    HTTP_ROUTE_EVENTS,
+    HTTP_ROUTE_RECENT,
+    HTTP_ROUTE_METRICS,
+    HTTP_ROUTE_LATENCY,
+    HTTP_ROUTE_TRIGGER,
+    HTTP_ROUTE_OTHER,
+    HTTP_ROUTE_COUNT
+} MetricsHttpRoute;
+
+typedef enum {
+    H_INGEST_LATENCY = 0,       // réception MQTT -> fin d'ingestion (monitor + Firestore)
+    H_FIRESTORE_LATENCY,
+    H_HTTP_LATENCY,             // + route : H_HTTP_LATENCY + HTTP_ROUTE_*
+    H_HISTOGRAM_COUNT = H_HTTP_LATENCY + HTTP_ROUTE_COUNT
+} MetricHistogram;
+
+uint64_t metrics_now_ns(void);   // horloge monotone
+
+void metrics_inc(MetricCounter c);
+void metrics_add(MetricCounter c, uint64_t n);
+void metrics_gauge_set(MetricGauge g, int64_t v);
+void metrics_gauge_add(MetricGauge g, int64_t delta);
+void metrics_observe_ns(MetricHistogram h, uint64_t ns);
+
+// Requête HTTP traitée : compteur par route + histogramme de durée
+void metrics_observe_http(MetricsHttpRoute route, uint64_t ns);
+
+// Exposition texte (format 0.0.4) ; à libérer avec free()
+char* metrics_render(void);
+
+#endif // METRICS_H
@@ -0,0 +1,553 @@
+/* mqtt_capture.c - enregistrement et rejeu du trafic MQTT des capteurs
+ *
+ * Usage : ./mqtt_capture record <fichier> [-a adresse] [-t filtre]
+ *         ./mqtt_capture replay <fichier> [-a adresse] [-s vitesse|max] [-f début] [-u fin] [-q qos] [-R] [-T]
+ *         ./mqtt_capture info   <fichier>
+ *   ex.  ./mqtt_capture record orage.ttc -a tcp://broker:1883          (Ctrl-C pour arrêter)
+ *        ./mqtt_capture replay orage.ttc -a tcp://localhost:1883 -s 10 -f 120 -u 300
+ *        ./mqtt_capture replay orage.ttc -T          (à répéter contre chaque nouvelle version du serveur)
+ *
+ * record : s'abonne à weather/# (ou -t) et écrit chaque message avec son instant de réception.
+ * replay : republie la capture en respectant les intervalles entre messages, divisés par
+ *          la vitesse (1 = temps réel, 10 = dix fois plus vite, max = sans attente).
+ *          -f/-u : fenêtre en secondes depuis le début de la capture ; -q force la QoS ;
+ *          -R conserve le flag retained (statuts, LWT).
+ *          -T réécrit les payloads JSON pour en faire du trafic neuf : "ts", "period_start",
+ *          "period_end" décalés de (début du rejeu - début de la fenêtre rejouée), "ts_ms"
+ *          d'autant, et "boot" augmenté des secondes epoch du rejeu. Sans -T les mesures gardent
+ *          leur date d'origine (rejeu, dédoublonnage par séquence) et un second rejeu contre le
+ *          même serveur est écarté en doublons. Avec une vitesse > 1 les dates avancent plus
+ *          vite que l'horloge : au-delà de 5 min d'avance le serveur retombe sur la réception.
+ * info   : durée, nombre de messages par topic et pic de messages/s.
+ *
+ * Format (.ttc, entiers little-endian, varint = LEB128 non signé) :
+ *   en-tête  : "TTMC" | u32 version | i64 début de capture (µs epoch)
+ *   message  : varint écart depuis le message précédent (µs) | u8 flags (bits 0-1 qos,
+ *              bit 2 retained, bit 3 nouveau topic) | varint id du topic
+ *              [| varint longueur | topic si nouveau] | varint longueur | payload
+ * Les topics sont numérotés à leur première apparition : ~10 octets d'en-tête par message.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "MQTTClient.h"
+
+#define CAPTURE_MAGIC "TTMC"
+#define CAPTURE_VERSION 1u
+#define CAPTURE_MAX_TOPICS 256
+#define CAPTURE_MAX_PAYLOAD (256 * 1024)
+
+#define FLAG_QOS_MASK 0x03
+#define FLAG_RETAINED 0x04
+#define FLAG_NEW_TOPIC 0x08
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_sig(int s) { (void)s; stop = 1; }
+
+static int64_t realtime_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_us(int64_t us) {
+    struct timespec ts = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000 };
+    while (nanosleep(&ts, &ts) != 0 && !stop) { }
+}
+
+/* ------- Encodage ------- */
+static void put_varint(FILE *f, uint64_t v) {
+    do {
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        fputc(b | (v ? 0x80 : 0), f);
+    } while (v);
+}
+
+// 0 si OK, -1 en fin de fichier ou varint invalide
+static int get_varint(FILE *f, uint64_t *v) {
+    *v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = fgetc(f);
+        if (c == EOF) return -1;
+        *v |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80)) return 0;
+    }
+    return -1;
+}
+
+static void put_le(FILE *f, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) fputc((int)(v >> (8 * i)) & 0xFF, f);
+}
+
+static int get_le(FILE *f, uint64_t *v, int bytes) {
+    *v = 0;
+    for (int i = 0; i < bytes; i++) {
+        int c = fgetc(f);
+        if (c == EOF) return -1;
+        *v |= (uint64_t)c << (8 * i);
+    }
+    return 0;
+}
+
+/* ------- Lecture d'une capture ------- */
+typedef struct {
+    FILE *f;
+    int64_t start_us;
+    int64_t offset_us;                  // instant du message courant depuis le début
+    char *topics[CAPTURE_MAX_TOPICS];
+    int topic_count;
+    // Message courant
+    const char *topic;
+    int topic_id;
+    int qos;
+    bool retained;
+    char *payload;
+    size_t payload_len;
+} CaptureReader;
+
+static int reader_open(CaptureReader *r, const char *path) {
+    memset(r, 0, sizeof(*r));
+    r->f = fopen(path, "rb");
+    if (!r->f) {
+        perror(path);
+        return -1;
+    }
+    char magic[4];
+    uint64_t version, start;
+    if (fread(magic, 1, 4, r->f) != 4 || memcmp(magic, CAPTURE_MAGIC, 4) != 0 ||
+        get_le(r->f, &version, 4) != 0 || version != CAPTURE_VERSION || get_le(r->f, &start, 8) != 0) {
+        fprintf(stderr, "%s: not a capture file (or unsupported version)\n", path);
+        fclose(r->f);
+        return -1;
+    }
+    r->start_us = (int64_t)start;
+    r->payload = malloc(CAPTURE_MAX_PAYLOAD);
+    return r->payload ? 0 : -1;
+}
+
+// 1 si un message a été lu, 0 en fin de capture, -1 si le fichier est corrompu
+// Lecture courte en fin de fichier (enregistreur tué en cours d'écriture) : fin propre,
+// on s'arrête au dernier message complet ; sinon enregistrement corrompu
+static int truncated(const CaptureReader *r) {
+    return feof(r->f) ? 0 : -1;
+}
+
+static int reader_next(CaptureReader *r) {
+    uint64_t delta, id, len;
+    int flags;
+    if (get_varint(r->f, &delta) != 0) return truncated(r);
+    if ((flags = fgetc(r->f)) == EOF || get_varint(r->f, &id) != 0) return truncated(r);
+
+    if (flags & FLAG_NEW_TOPIC) {
+        if (id != (uint64_t)r->topic_count || id >= CAPTURE_MAX_TOPICS) return -1;
+        if (get_varint(r->f, &len) != 0) return truncated(r);
+        if (len > 65535) return -1;
+        char *topic = malloc(len + 1);
+        if (!topic) return -1;
+        if (fread(topic, 1, len, r->f) != len) {
+            free(topic);
+            return truncated(r);
+        }
+        topic[len] = '\0';
+        r->topics[r->topic_count++] = topic;
+    } else if (id >= (uint64_t)r->topic_count) {
+        return -1;
+    }
+    if (get_varint(r->f, &len) != 0) return truncated(r);
+    if (len > CAPTURE_MAX_PAYLOAD) return -1;
+    if (fread(r->payload, 1, len, r->f) != len) return truncated(r);
+    r->offset_us += (int64_t)delta;
+    r->topic_id = (int)id;
+    r->topic = r->topics[id];
+    r->qos = flags & FLAG_QOS_MASK;
+    r->retained = (flags & FLAG_RETAINED) != 0;
+    r->payload_len = len;
+    return 1;
+}
+
+static void reader_close(CaptureReader *r) {
+    for (int i = 0; i < r->topic_count; i++) free(r->topics[i]);
+    free(r->payload);
+    if (r->f) fclose(r->f);
+}
+
+/* ------- record ------- */
+typedef struct {
+    FILE *f;
+    char *topics[CAPTURE_MAX_TOPICS];
+    int topic_count;
+    int64_t last_us;        // monotone, pour les écarts
+    unsigned long messages;
+    unsigned long bytes;
+} CaptureWriter;
+
+static void writer_append(CaptureWriter *w, const char *topic, const void *payload, size_t len, int qos, bool retained) {
+    int64_t now = monotonic_us();
+    int id = 0;
+    while (id < w->topic_count && strcmp(w->topics[id], topic) != 0) id++;
+    uint8_t flags = (uint8_t)((qos & FLAG_QOS_MASK) | (retained ? FLAG_RETAINED : 0));
+    if (id == w->topic_count) {
+        if (id == CAPTURE_MAX_TOPICS || !(w->topics[id] = strdup(topic))) {
+            fprintf(stderr, "[Capture] too many topics, %s ignored\n", topic);
+            return;
+        }
+        w->topic_count++;
+        flags |= FLAG_NEW_TOPIC;
+    }
+
+    put_varint(w->f, (uint64_t)(now - w->last_us));
+    fputc(flags, w->f);
+    put_varint(w->f, (uint64_t)id);
+    if (flags & FLAG_NEW_TOPIC) {
+        put_varint(w->f, strlen(topic));
+        fwrite(topic, 1, strlen(topic), w->f);
+    }
+    put_varint(w->f, len);
+    fwrite(payload, 1, len, w->f);
+    w->last_us = now;
+    w->messages++;
+    w->bytes += len;
+}
+
+// Appelé par le thread Paho ; le thread principal ne fait que flush sous ce verrou
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int connection_lost = 0;
+
+static int on_record_msg(void *context, char *topicName, int topicLen, MQTTClient_message *message) {
+    CaptureWriter *w = context;
+    (void)topicLen;
+    if (message->payloadlen <= CAPTURE_MAX_PAYLOAD) {
+        pthread_mutex_lock(&writer_lock);
+        writer_append(w, topicName, message->payload, (size_t)message->payloadlen, message->qos, message->retained);
+        pthread_mutex_unlock(&writer_lock);
+    }
+    MQTTClient_freeMessage(&message);
+    MQTTClient_free(topicName);
+    return 1;
+}
+
+static void on_record_lost(void *context, char *cause) {
+    (void)context;
+    fprintf(stderr, "[Capture] connection lost: %s\n", cause ? cause : "unknown");
+    connection_lost = 1;
+}
+
+static int record(const char *path, const char *address, const char *filter) {
+    CaptureWriter w;
+    memset(&w, 0, sizeof(w));
+    w.f = fopen(path, "wb");
+    if (!w.f) {
+        perror(path);
+        return 1;
+    }
+    fwrite(CAPTURE_MAGIC, 1, 4, w.f);
+    put_le(w.f, CAPTURE_VERSION, 4);
+    put_le(w.f, (uint64_t)realtime_us(), 8);
+    w.last_us = monotonic_us();
+
+    char client_id[64];
+    snprintf(client_id, sizeof(client_id), "techtemp_capture_%d", (int)getpid());
+    MQTTClient client;
+    MQTTClient_connectOptions conn_opts = MQTTClient_connectOptions_initializer;
+    conn_opts.keepAliveInterval = 20;
+    conn_opts.cleansession = 1;
+    if (MQTTClient_create(&client, address, client_id, MQTTCLIENT_PERSISTENCE_NONE, NULL) != MQTTCLIENT_SUCCESS ||
+        MQTTClient_setCallbacks(client, &w, on_record_lost, on_record_msg, NULL) != MQTTCLIENT_SUCCESS) {
+        fprintf(stderr, "[Capture] cannot create client for %s\n", address);
+        fclose(w.f);
+        return 1;
+    }
+
+    printf("[Capture] recording %s from %s into %s (Ctrl-C to stop)\n", filter, address, path);
+    int64_t started = monotonic_us();
+    connection_lost = 1;
+    while (!stop) {
+        if (connection_lost) {
+            // (Re)connexion : les messages retenus sont rejoués par le broker, comme pour le serveur
+            if (MQTTClient_connect(client, &conn_opts) == MQTTCLIENT_SUCCESS &&
+                MQTTClient_subscribe(client, filter, 1) == MQTTCLIENT_SUCCESS) {
+                connection_lost = 0;
+            } else {
+                sleep_us(2000000);
+                continue;
+            }
+        }
+        sleep_us(1000000);
+        pthread_mutex_lock(&writer_lock);
+        fflush(w.f);
+        pthread_mutex_unlock(&writer_lock);
+    }
+
+    MQTTClient_disconnect(client, 1000);
+    MQTTClient_destroy(&client);
+    pthread_mutex_lock(&writer_lock);
+    long size = ftell(w.f);
+    fclose(w.f);
+    pthread_mutex_unlock(&writer_lock);
+    for (int i = 0; i < w.topic_count; i++) free(w.topics[i]);
+
+    double elapsed = (monotonic_us() - started) / 1e6;
+    printf("[Capture] %lu messages (%lu payload bytes, %ld file bytes) in %.1f s, %d topics\n",
+           w.messages, w.bytes, size, elapsed, w.topic_count);
+    return 0;
+}
+
+/* ------- replay ------- */
+typedef struct {
+    int64_t shift_sec;      // ajouté à "ts", "period_start", "period_end" (et x1000 à "ts_ms")
+    uint32_t boot_offset;   // ajouté à "boot"
+} PayloadRewrite;
+
+// Champ numérique entier réécrit par -T ; 0 si key n'en est pas un
+static int rewrite_delta(const PayloadRewrite *rw, const char *key, size_t key_len, int64_t *delta) {
+    static const struct { const char *key; int kind; } fields[] = {
+        { "ts", 0 }, { "period_start", 0 }, { "period_end", 0 }, { "ts_ms", 1 }, { "boot", 2 },
+    };
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        if (strlen(fields[i].key) != key_len || memcmp(fields[i].key, key, key_len) != 0) continue;
+        *delta = fields[i].kind == 0 ? rw->shift_sec :
+                 fields[i].kind == 1 ? rw->shift_sec * 1000 : (int64_t)rw->boot_offset;
+        return 1;
+    }
+    return 0;
+}
+
+// Copie in dans out en décalant les champs de rewrite_delta, à toute profondeur
+// ("readings" des lots compris). Le reste du payload est recopié octet pour octet.
+// Renvoie la longueur écrite, ou -1 si out est trop petit.
+static long rewrite_payload(const PayloadRewrite *rw, const char *in, size_t len, char *out, size_t cap) {
+    size_t o = 0;
+    for (size_t i = 0; i < len; ) {
+        if (in[i] != '"') {
+            if (o == cap) return -1;
+            out[o++] = in[i++];
+            continue;
+        }
+        // Chaîne (clé ou valeur) recopiée telle quelle
+        size_t start = i++;
+        while (i < len && in[i] != '"') i += in[i] == '\\' ? 2 : 1;
+        if (i < len) i++;
+        if (i > len) i = len;
+        if (cap - o < i - start) return -1;
+        memcpy(out + o, in + start, i - start);
+        o += i - start;
+
+        // Clé suivie d'un entier : "key" [espaces] : [espaces] [-]chiffres (pas de partie décimale)
+        int64_t delta;
+        size_t k = i;
+        while (k < len && (in[k] == ' ' || in[k] == '\t')) k++;
+        if (k >= len || in[k] != ':' || !rewrite_delta(rw, in + start + 1, i - start - 2, &delta)) continue;
+        k++;
+        while (k < len && (in[k] == ' ' || in[k] == '\t')) k++;
+        size_t num = k;
+        if (k < len && in[k] == '-') k++;
+        size_t digits = k;
+        int64_t value = 0;
+        while (k < len && in[k] >= '0' && in[k] <= '9' && k - digits < 18) value = value * 10 + (in[k++] - '0');
+        if (k == digits || (k < len && (in[k] == '.' || in[k] == 'e' || in[k] == 'E' ||
+                                         (in[k] >= '0' && in[k] <= '9')))) {
+            continue;   // pas un entier exploitable : recopié tel quel
+        }
+        if (in[num] == '-') value = -value;
+        char buf[32];
+        int n = snprintf(buf, sizeof(buf), "%lld", (long long)(value + delta));
+        if (cap - o < (num - i) + (size_t)n) return -1;
+        memcpy(out + o, in + i, num - i);   // ':' et espaces
+        o += num - i;
+        memcpy(out + o, buf, (size_t)n);
+        o += (size_t)n;
+        i = k;
+    }
+    return (long)o;
+}
+
+static int replay(const char *path, const char *address, double speed, double from_sec, double until_sec,
+                  int force_qos, bool keep_retained, bool rewrite) {
+    CaptureReader r;
+    if (reader_open(&r, path) != 0) return 1;
+    // Réécriture : les nombres grandissent de quelques chiffres au plus
+    char *rewritten = rewrite ? malloc(2 * CAPTURE_MAX_PAYLOAD) : NULL;
+    if (rewrite && !rewritten) {
+        reader_close(&r);
+        return 1;
+    }
+    PayloadRewrite rw = { 0, 0 };
+
+    char client_id[64];
+    snprintf(client_id, sizeof(client_id), "techtemp_replay_%d", (int)getpid());
+    MQTTClient client;
+    MQTTClient_connectOptions conn_opts = MQTTClient_connectOptions_initializer;
+    conn_opts.keepAliveInterval = 20;
+    conn_opts.cleansession = 1;
+    if (MQTTClient_create(&client, address, client_id, MQTTCLIENT_PERSISTENCE_NONE, NULL) != MQTTCLIENT_SUCCESS ||
+        MQTTClient_connect(client, &conn_opts) != MQTTCLIENT_SUCCESS) {
+        fprintf(stderr, "[Replay] connection to %s failed\n", address);
+        free(rewritten);
+        reader_close(&r);
+        return 1;
+    }
+
+    const int64_t from_us = (int64_t)(from_sec * 1e6);
+    const int64_t until_us = until_sec > 0 ? (int64_t)(until_sec * 1e6) : INT64_MAX;
+    int64_t t0 = 0;             // instant monotone du premier message rejoué
+    int64_t max_lag_us = 0;
+    unsigned long sent = 0, failed = 0;
+    int next = 0;   // résultat de reader_next, distinct du code de publication
+
+    while (!stop && (next = reader_next(&r)) == 1) {
+        if (r.offset_us < from_us) continue;
+        if (r.offset_us > until_us) break;
+
+        int64_t now = monotonic_us();
+        if (t0 == 0) {
+            t0 = now;
+            if (rewrite) {
+                // Le premier message rejoué tombe maintenant ; chaque rejeu est un boot plus récent
+                int64_t start_real = realtime_us();
+                rw.shift_sec = (start_real - (r.start_us + r.offset_us)) / 1000000;
+                rw.boot_offset = (uint32_t)(start_real / 1000000);
+                printf("[Replay] rewriting timestamps by %+lld s, boot ids by +%u\n",
+                       (long long)rw.shift_sec, rw.boot_offset);
+            }
+        }
+        if (speed > 0) {
+            // Échéance relative au premier message : pas de dérive cumulée
+            int64_t due = t0 + (int64_t)((double)(r.offset_us - from_us) / speed);
+            if (due > now) {
+                sleep_us(due - now);
+            } else if (now - due > max_lag_us) {
+                max_lag_us = now - due;
+            }
+        }
+
+        int qos = force_qos >= 0 ? force_qos : r.qos;
+        const char *payload = r.payload;
+        long payload_len = (long)r.payload_len;
+        if (rewrite) {
+            payload_len = rewrite_payload(&rw, r.payload, r.payload_len, rewritten, 2 * CAPTURE_MAX_PAYLOAD);
+            payload = rewritten;
+            if (payload_len < 0) {
+                failed++;
+                continue;
+            }
+        }
+        int rc = MQTTCLIENT_FAILURE;
+        for (int attempt = 0; attempt < 1000; attempt++) {
+            MQTTClient_deliveryToken token;
+            rc = MQTTClient_publish(client, r.topic, (int)payload_len, (void *)payload, qos,
+                                    keep_retained && r.retained, &token);
+            if (rc != MQTTCLIENT_MAX_MESSAGES_INFLIGHT) break;
+            MQTTClient_yield();
+        }
+        if (rc == MQTTCLIENT_SUCCESS) sent++;
+        else failed++;
+    }
+    if (next < 0) fprintf(stderr, "[Replay] %s: corrupted record after %lu messages\n", path, sent + failed);
+
+    double elapsed = t0 ? (monotonic_us() - t0) / 1e6 : 0;
+    printf("[Replay] %lu messages sent, %lu failed in %.2f s (%.0f msg/s), max lag %.1f ms\n",
+           sent, failed, elapsed, elapsed > 0 ? sent / elapsed : 0.0, max_lag_us / 1000.0);
+    MQTTClient_disconnect(client, 5000);
+    MQTTClient_destroy(&client);
+    free(rewritten);
+    reader_close(&r);
+    return 0;
+}
+
+/* ------- info ------- */
+static int info(const char *path) {
+    CaptureReader r;
+    if (reader_open(&r, path) != 0) return 1;
+
+    unsigned long per_topic[CAPTURE_MAX_TOPICS] = { 0 };
+    unsigned long messages = 0, bytes = 0, peak = 0, in_second = 0;
+    int64_t second = 0;
+    int rc;
+    while ((rc = reader_next(&r)) == 1) {
+        messages++;
+        bytes += r.payload_len;
+        per_topic[r.topic_id]++;
+        if (r.offset_us / 1000000 != second) {
+            second = r.offset_us / 1000000;
+            in_second = 0;
+        }
+        if (++in_second > peak) peak = in_second;
+    }
+
+    time_t start = (time_t)(r.start_us / 1000000);
+    char started[32];
+    strftime(started, sizeof(started), "%Y-%m-%dT%H:%M:%SZ", gmtime(&start));
+    printf("capture  %s%s\nstarted  %s\nduration %.1f s\nmessages %lu (%lu payload bytes), peak %lu msg/s\n",
+           path, rc < 0 ? " (corrupted tail)" : "", started, r.offset_us / 1e6, messages, bytes, peak);
+    for (int i = 0; i < r.topic_count; i++) {
+        printf("  %-32s %lu\n", r.topics[i], per_topic[i]);
+    }
+    reader_close(&r);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s record <file> [-a broker] [-t filter]\n"
+                    "       %s replay <file> [-a broker] [-s speed|max] [-f from_sec] [-u until_sec] [-q qos] [-R] [-T]\n"
+                    "       %s info <file>\n", prog, prog, prog);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *mode = argv[1];
+    const char *path = argv[2];
+    const char *address = "tcp://localhost:1883";
+    const char *filter = "weather/#";
+    double speed = 1.0, from_sec = 0, until_sec = 0;
+    int force_qos = -1;
+    bool keep_retained = false;
+    bool rewrite = false;
+
+    optind = 3;
+    int opt;
+    while ((opt = getopt(argc, argv, "a:t:s:f:u:q:RT")) != -1) {
+        switch (opt) {
+            case 'a': address = optarg; break;
+            case 't': filter = optarg; break;
+            case 's': speed = strcmp(optarg, "max") == 0 ? 0 : atof(optarg); break;
+            case 'f': from_sec = atof(optarg); break;
+            case 'u': until_sec = atof(optarg); break;
+            case 'q': force_qos = atoi(optarg) ? 1 : 0; break;
+            case 'R': keep_retained = true; break;
+            case 'T': rewrite = true; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (speed < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    signal(SIGINT, on_sig);
+    signal(SIGTERM, on_sig);
+    if (strcmp(mode, "record") == 0) return record(path, address, filter);
+    if (strcmp(mode, "replay") == 0) return replay(path, address, speed, from_sec, until_sec, force_qos, keep_retained, rewrite);
+    if (strcmp(mode, "info") == 0) return info(path);
+    usage(argv[0]);
+    return 1;
+}
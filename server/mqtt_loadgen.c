@@ -0,0 +1,541 @@
+/* mqtt_loadgen.c - flotte de capteurs virtuels pour tester la charge du serveur
+ *
+ * Usage : ./mqtt_loadgen [options]
+ *   -a adresse     broker (tcp://localhost:1883)
+ *   -H hôte:port   API HTTP du serveur pour /metrics et /api/system/latency (localhost:8080)
+ *   -n capteurs    nombre de capteurs virtuels (10 = MAX_DEVICES du serveur ;
+ *                  au-delà, lancer le serveur avec -d capacité)
+ *   -c connexions  connexions MQTT, les capteurs y sont répartis (4)
+ *   -i secondes    intervalle de mesure par capteur (300)
+ *   -r msg/s       débit total visé (remplace -i : intervalle = n / r)
+ *   -d secondes    durée du test (60)
+ *   -f format      reading | legacy | batch | summary (reading)
+ *   -p motif       spread   : capteurs répartis dans l'intervalle
+ *                  aligned  : tous en début de créneau (k * intervalle, horloge murale)
+ *                  storm:S  : spread + "capture all" de tous les capteurs toutes les S secondes
+ *   -D ratio       part de messages republiés en double (0)
+ *   -O ratio       part de messages envoyés après le suivant (0)
+ *   -q qos         0 ou 1 (1)
+ *   -s id          premier sensor_id virtuel (10000)
+ *   -t trigger     trigger des mesures (on-demand : le serveur n'écrit pas dans Firestore ;
+ *                  "scheduled" pour inclure l'envoi Firestore dans la mesure).
+ *                  Les résumés (-f summary) sont toujours envoyés à Firestore par le serveur.
+ *
+ * Chaque capteur a son boot et sa séquence, comme le client : doublons et
+ * désordre injectés doivent être écartés / acceptés par la fenêtre de séquence.
+ * Le débit d'ingestion et les percentiles de latence sont relevés côté serveur,
+ * avant et après le test : seules les mesures de la fenêtre du test comptent.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+
+#include "MQTTClient.h"
+#include "latency_trace.h"
+#include "cJSON.h"
+
+#define TOPIC_DATA "weather"
+#define PAYLOAD_MAX 1024
+#define BATCH_SIZE 10
+
+typedef enum { FMT_READING, FMT_LEGACY, FMT_BATCH, FMT_SUMMARY } PayloadFormat;
+typedef enum { PATTERN_SPREAD, PATTERN_ALIGNED, PATTERN_STORM } BurstPattern;
+
+typedef struct {
+    const char *address;
+    const char *http_host;
+    const char *http_port;
+    int sensors;
+    int connections;
+    double interval_sec;
+    double rate;
+    int duration_sec;
+    PayloadFormat format;
+    BurstPattern pattern;
+    int storm_sec;
+    double dup_ratio;
+    double ooo_ratio;
+    int qos;
+    int first_id;
+    const char *trigger;
+} LoadOptions;
+
+// Capteur virtuel
+typedef struct {
+    int sensor_id;
+    uint32_t boot;
+    uint32_t seq;
+    int64_t next_ms;        // prochaine mesure (ms epoch)
+    char *held;             // message retenu pour l'envoi hors ordre
+    int held_len;
+} VirtualSensor;
+
+typedef struct {
+    int index;
+    MQTTClient client;
+    VirtualSensor *sensors;
+    int count;
+    unsigned int rng;
+} Connection;
+
+static LoadOptions opts = {
+    "tcp://localhost:1883", "localhost", "8080", 10, 4, 300.0, 0.0, 60,
+    FMT_READING, PATTERN_SPREAD, 0, 0.0, 0.0, 1, 10000, "on-demand"
+};
+
+static atomic_int stop = 0;
+static atomic_ulong published = 0;
+static atomic_ulong duplicates = 0;
+static atomic_ulong reordered = 0;
+static atomic_ulong failures = 0;
+
+static void on_sig(int s) { (void)s; stop = 1; }
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static double rand01(unsigned int *rng) {
+    return (double)rand_r(rng) / ((double)RAND_MAX + 1.0);
+}
+
+/* ------- Payloads (mêmes formats que le client) ------- */
+static int format_payload(char *buf, size_t size, VirtualSensor *s, const char *trigger, unsigned int *rng) {
+    int64_t ms = now_ms();
+    int room_id = s->sensor_id % 4 + 1;
+    double t = 20.0 + 3.0 * rand01(rng);
+    double h = 40.0 + 20.0 * rand01(rng);
+    uint32_t seq = ++s->seq;
+
+    switch (opts.format) {
+        case FMT_LEGACY:
+            return snprintf(buf, size, "{\"sensor_id\":%d,\"room_id\":%d,\"temperature\":%.2f,\"humidity\":%.0f,"
+                            "\"trigger\":\"%s\"}", s->sensor_id, room_id, t, h, trigger);
+        case FMT_BATCH: {
+            // Lot de backlog : BATCH_SIZE mesures espacées d'une minute
+            int n = snprintf(buf, size, "{\"sensor_id\":%d,\"room_id\":%d,\"trigger\":\"backlog\",\"readings\":[",
+                             s->sensor_id, room_id);
+            s->seq += BATCH_SIZE - 1;
+            for (int i = 0; i < BATCH_SIZE && n < (int)size; i++) {
+                n += snprintf(buf + n, size - (size_t)n,
+                              "%s{\"ts\":%lld,\"temperature\":%.2f,\"humidity\":%.0f,\"trigger\":\"%s\","
+                              "\"boot\":%u,\"seq\":%u}", i ? "," : "",
+                              (long long)(ms / 1000 - (BATCH_SIZE - 1 - i) * 60), t + 0.01 * i, h, trigger,
+                              s->boot, seq + (uint32_t)i);
+            }
+            if (n < (int)size) n += snprintf(buf + n, size - (size_t)n, "]}");
+            return n;
+        }
+        case FMT_SUMMARY:
+            return snprintf(buf, size, "{\"sensor_id\":%d,\"room_id\":%d,\"trigger\":\"summary\",\"boot\":%u,"
+                            "\"seq\":%u,\"period_start\":%lld,\"period_end\":%lld,\"count\":15,"
+                            "\"temperature\":{\"min\":%.2f,\"max\":%.2f,\"mean\":%.2f,\"last\":%.2f},"
+                            "\"humidity\":{\"min\":%.0f,\"max\":%.0f,\"mean\":%.1f,\"last\":%.0f}}",
+                            s->sensor_id, room_id, s->boot, seq, (long long)(ms / 1000 - 900),
+                            (long long)(ms / 1000), t - 0.3, t + 0.3, t, t, h - 2, h + 2, h, h);
+        case FMT_READING:
+        default:
+            return snprintf(buf, size, "{\"sensor_id\":%d,\"room_id\":%d,\"temperature\":%.2f,\"humidity\":%.0f,"
+                            "\"trigger\":\"%s\",\"ts\":%lld,\"ts_ms\":%lld,\"boot\":%u,\"seq\":%u}",
+                            s->sensor_id, room_id, t, h, trigger, (long long)(ms / 1000), (long long)ms,
+                            s->boot, seq);
+    }
+}
+
+/* Publication ; en QoS1, attend qu'une place se libère si la fenêtre en vol est pleine */
+static int publish(Connection *c, const char *payload, int len) {
+    for (int attempt = 0; attempt < 1000 && !stop; attempt++) {
+        MQTTClient_deliveryToken token;
+        int rc = MQTTClient_publish(c->client, TOPIC_DATA, len, payload, opts.qos, 0, &token);
+        if (rc == MQTTCLIENT_SUCCESS) {
+            published++;
+            return 0;
+        }
+        if (rc != MQTTCLIENT_MAX_MESSAGES_INFLIGHT) break;
+        MQTTClient_yield();
+    }
+    failures++;
+    return -1;
+}
+
+static void emit(Connection *c, VirtualSensor *s, const char *trigger) {
+    char payload[PAYLOAD_MAX];
+    int len = format_payload(payload, sizeof(payload), s, trigger, &c->rng);
+    if (len <= 0 || len >= (int)sizeof(payload)) return;
+
+    // Hors ordre : on garde ce message et on l'envoie après le suivant
+    if (!s->held && opts.ooo_ratio > 0 && rand01(&c->rng) < opts.ooo_ratio) {
+        s->held = malloc((size_t)len);
+        if (s->held) {
+            memcpy(s->held, payload, (size_t)len);
+            s->held_len = len;
+            return;
+        }
+    }
+    publish(c, payload, len);
+    if (s->held) {
+        publish(c, s->held, s->held_len);
+        free(s->held);
+        s->held = NULL;
+        reordered++;
+    }
+    if (opts.dup_ratio > 0 && rand01(&c->rng) < opts.dup_ratio) {
+        publish(c, payload, len);
+        duplicates++;
+    }
+}
+
+/* ------- Ordonnancement ------- */
+static int64_t first_slot(const VirtualSensor *s, int64_t start_ms, int64_t interval_ms) {
+    int64_t slot = start_ms - start_ms % interval_ms + interval_ms;
+    if (opts.pattern == PATTERN_ALIGNED) return slot;
+    // Même répartition que le client (hachage de Fibonacci du sensor_id)
+    uint32_t h = (uint32_t)s->sensor_id * 2654435769u;
+    return start_ms + (int64_t)((uint64_t)h * (uint64_t)interval_ms >> 32);
+}
+
+static void* connection_thread(void *arg) {
+    Connection *c = arg;
+    const int64_t interval_ms = (int64_t)(opts.interval_sec * 1000.0);
+    const int64_t start = now_ms();
+    const int64_t end = start + (int64_t)opts.duration_sec * 1000;
+    int64_t next_storm = opts.pattern == PATTERN_STORM ? start + opts.storm_sec * 1000LL : INT64_MAX;
+
+    for (int i = 0; i < c->count; i++) {
+        c->sensors[i].next_ms = first_slot(&c->sensors[i], start, interval_ms);
+    }
+
+    while (!stop) {
+        int64_t now = now_ms();
+        if (now >= end) break;
+
+        if (now >= next_storm) {
+            // "capture all" : chaque capteur répond en même temps
+            for (int i = 0; i < c->count && !stop; i++) emit(c, &c->sensors[i], "on-demand");
+            next_storm += opts.storm_sec * 1000LL;
+        }
+
+        int64_t wake = end < next_storm ? end : next_storm;
+        for (int i = 0; i < c->count && !stop; i++) {
+            VirtualSensor *s = &c->sensors[i];
+            if (s->next_ms <= now) {
+                emit(c, s, opts.trigger);
+                s->next_ms += interval_ms;
+                if (s->next_ms <= now) s->next_ms = now + interval_ms;  // retard : pas de rattrapage en rafale
+            }
+            if (s->next_ms < wake) wake = s->next_ms;
+        }
+
+        int64_t wait = wake - now_ms();
+        if (wait > 0) sleep_ms(wait > 10 ? 10 : (int)wait);
+        if (opts.qos > 0) MQTTClient_yield();
+    }
+
+    for (int i = 0; i < c->count; i++) {
+        if (c->sensors[i].held) {
+            publish(c, c->sensors[i].held, c->sensors[i].held_len);
+            free(c->sensors[i].held);
+            c->sensors[i].held = NULL;
+        }
+    }
+    return NULL;
+}
+
+/* ------- Relevés côté serveur ------- */
+// GET http://host:port/path ; renvoie le corps (à libérer) ou NULL
+static char* http_get(const char *path) {
+    struct addrinfo hints = { 0 }, *res = NULL;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(opts.http_host, opts.http_port, &hints, &res) != 0) return NULL;
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd < 0 || connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+        if (fd >= 0) close(fd);
+        freeaddrinfo(res);
+        return NULL;
+    }
+    freeaddrinfo(res);
+
+    char req[256];
+    int n = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", path, opts.http_host);
+    if (send(fd, req, (size_t)n, 0) != n) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t cap = 65536, len = 0;
+    char *buf = malloc(cap);
+    ssize_t r;
+    while (buf && (r = recv(fd, buf + len, cap - len - 1, 0)) > 0) {
+        len += (size_t)r;
+        if (len + 1 == cap) {
+            char *bigger = realloc(buf, cap * 2);
+            if (!bigger) break;
+            buf = bigger;
+            cap *= 2;
+        }
+    }
+    close(fd);
+    if (!buf) return NULL;
+    buf[len] = '\0';
+    char *body = strstr(buf, "\r\n\r\n");
+    if (!body) {
+        free(buf);
+        return NULL;
+    }
+    memmove(buf, body + 4, strlen(body + 4) + 1);
+    return buf;
+}
+
+// Valeur d'une série sans label dans l'exposition Prometheus ; -1 si absente
+static double scrape_counter(const char *name) {
+    char *text = http_get("/metrics");
+    double v = -1;
+    if (text) {
+        size_t len = strlen(name);
+        for (char *line = text; line && *line; line = strchr(line, '\n') ? strchr(line, '\n') + 1 : NULL) {
+            if (strncmp(line, name, len) == 0 && line[len] == ' ') {
+                v = strtod(line + len + 1, NULL);
+                break;
+            }
+        }
+        free(text);
+    }
+    return v;
+}
+
+// Histogramme cumulé d'une étape côté serveur (/api/system/latency?buckets=1), buckets croissants
+typedef struct {
+    int n;
+    double high[TRACE_HIST_BUCKETS];    // borne haute du bucket (µs)
+    double count[TRACE_HIST_BUCKETS];
+    double sum_us;
+} StageHist;
+
+static const char *latency_stages[TRACE_STAGE_COUNT] = { "transport", "decode", "monitor", "sink", "total" };
+static StageHist latency_before[TRACE_STAGE_COUNT], latency_after[TRACE_STAGE_COUNT];
+
+// 0 si le serveur ne répond pas ou n'expose pas les buckets
+static int snapshot_latency(StageHist *hists) {
+    char *text = http_get("/api/system/latency?buckets=1");
+    cJSON *json = text ? cJSON_Parse(text) : NULL;
+    free(text);
+    const cJSON *st = cJSON_GetObjectItemCaseSensitive(json, "stages");
+    int ok = st != NULL;
+    memset(hists, 0, sizeof(StageHist) * TRACE_STAGE_COUNT);
+    for (int s = 0; ok && s < TRACE_STAGE_COUNT; s++) {
+        const cJSON *stage = cJSON_GetObjectItemCaseSensitive(st, latency_stages[s]);
+        const cJSON *buckets = cJSON_GetObjectItemCaseSensitive(stage, "buckets");
+        const cJSON *sum = cJSON_GetObjectItemCaseSensitive(stage, "sum_us");
+        if (!cJSON_IsArray(buckets) || !cJSON_IsNumber(sum)) {
+            ok = 0;
+            break;
+        }
+        StageHist *h = &hists[s];
+        h->sum_us = sum->valuedouble;
+        const cJSON *b;
+        cJSON_ArrayForEach(b, buckets) {
+            if (h->n == TRACE_HIST_BUCKETS) break;
+            h->high[h->n] = cJSON_GetNumberValue(cJSON_GetArrayItem(b, 0));
+            h->count[h->n] = cJSON_GetNumberValue(cJSON_GetArrayItem(b, 1));
+            h->n++;
+        }
+    }
+    cJSON_Delete(json);
+    return ok;
+}
+
+// Percentile de l'histogramme de la fenêtre, même règle de rang que le serveur
+static double window_percentile(const StageHist *w, double total, double p) {
+    double rank = (double)(uint64_t)(p / 100.0 * total + 0.5);
+    double seen = 0;
+    if (rank < 1) rank = 1;
+    for (int i = 0; i < w->n; i++) {
+        seen += w->count[i];
+        if (seen >= rank) return w->high[i];
+    }
+    return 0;
+}
+
+// Percentiles sur la seule durée du test : relevé après - relevé avant, bucket par bucket
+// (les compteurs du serveur sont cumulés depuis son démarrage)
+static void print_latency(const StageHist *before, const StageHist *after) {
+    printf("%-10s %10s %10s %10s %10s %10s %10s\n", "stage", "count", "mean_us", "p50_us", "p99_us", "p999_us", "max_us");
+    for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+        StageHist w = { 0 };
+        double total = 0;
+        int j = 0;
+        for (int i = 0; i < after[s].n; i++) {
+            while (j < before[s].n && before[s].high[j] < after[s].high[i]) j++;
+            double d = after[s].count[i];
+            if (j < before[s].n && before[s].high[j] == after[s].high[i]) d -= before[s].count[j];
+            if (d <= 0) continue;
+            w.high[w.n] = after[s].high[i];
+            w.count[w.n++] = d;
+            total += d;
+        }
+        printf("%-10s %10.0f %10.0f %10.0f %10.0f %10.0f %10.0f\n", latency_stages[s], total,
+               total > 0 ? (after[s].sum_us - before[s].sum_us) / total : 0,
+               window_percentile(&w, total, 50), window_percentile(&w, total, 99),
+               window_percentile(&w, total, 99.9), w.n ? w.high[w.n - 1] : 0);
+    }
+}
+
+/* ------- Options ------- */
+static int parse_args(int argc, char **argv) {
+    static char host[128];
+    int opt;
+    while ((opt = getopt(argc, argv, "a:H:n:c:i:r:d:f:p:D:O:q:s:t:")) != -1) {
+        switch (opt) {
+            case 'a': opts.address = optarg; break;
+            case 'H': {
+                snprintf(host, sizeof(host), "%s", optarg);
+                char *colon = strrchr(host, ':');
+                if (colon) {
+                    *colon = '\0';
+                    opts.http_port = colon + 1;
+                }
+                opts.http_host = host;
+                break;
+            }
+            case 'n': opts.sensors = atoi(optarg); break;
+            case 'c': opts.connections = atoi(optarg); break;
+            case 'i': opts.interval_sec = atof(optarg); break;
+            case 'r': opts.rate = atof(optarg); break;
+            case 'd': opts.duration_sec = atoi(optarg); break;
+            case 'f':
+                if (strcmp(optarg, "reading") == 0) opts.format = FMT_READING;
+                else if (strcmp(optarg, "legacy") == 0) opts.format = FMT_LEGACY;
+                else if (strcmp(optarg, "batch") == 0) opts.format = FMT_BATCH;
+                else if (strcmp(optarg, "summary") == 0) opts.format = FMT_SUMMARY;
+                else return -1;
+                break;
+            case 'p':
+                if (strcmp(optarg, "spread") == 0) opts.pattern = PATTERN_SPREAD;
+                else if (strcmp(optarg, "aligned") == 0) opts.pattern = PATTERN_ALIGNED;
+                else if (strncmp(optarg, "storm:", 6) == 0 && atoi(optarg + 6) > 0) {
+                    opts.pattern = PATTERN_STORM;
+                    opts.storm_sec = atoi(optarg + 6);
+                } else return -1;
+                break;
+            case 'D': opts.dup_ratio = atof(optarg); break;
+            case 'O': opts.ooo_ratio = atof(optarg); break;
+            case 'q': opts.qos = atoi(optarg) ? 1 : 0; break;
+            case 's': opts.first_id = atoi(optarg); break;
+            case 't': opts.trigger = optarg; break;
+            default: return -1;
+        }
+    }
+    if (opts.rate > 0) opts.interval_sec = opts.sensors / opts.rate;
+    if (opts.sensors <= 0 || opts.connections <= 0 || opts.interval_sec < 0.001 || opts.duration_sec <= 0) return -1;
+    if (opts.connections > opts.sensors) opts.connections = opts.sensors;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (parse_args(argc, argv) != 0) {
+        fprintf(stderr, "usage: %s [-a broker] [-H host:port] [-n sensors] [-c connections] [-i interval|-r rate]\n"
+                        "       [-d sec] [-f reading|legacy|batch|summary] [-p spread|aligned|storm:S]\n"
+                        "       [-D dup_ratio] [-O ooo_ratio] [-q 0|1] [-s first_id] [-t trigger]\n", argv[0]);
+        return 1;
+    }
+    signal(SIGINT, on_sig);
+    signal(SIGTERM, on_sig);
+
+    Connection *conns = calloc((size_t)opts.connections, sizeof(Connection));
+    VirtualSensor *sensors = calloc((size_t)opts.sensors, sizeof(VirtualSensor));
+    pthread_t *threads = calloc((size_t)opts.connections, sizeof(pthread_t));
+    if (!conns || !sensors || !threads) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    uint32_t boot = (uint32_t)time(NULL);
+    for (int i = 0; i < opts.sensors; i++) {
+        sensors[i].sensor_id = opts.first_id + i;
+        sensors[i].boot = boot;
+    }
+
+    // Capteurs contigus par connexion
+    int per_conn = (opts.sensors + opts.connections - 1) / opts.connections;
+    for (int c = 0; c < opts.connections; c++) {
+        char client_id[64];
+        snprintf(client_id, sizeof(client_id), "techtemp_loadgen_%d_%d", (int)getpid(), c);
+        conns[c].index = c;
+        conns[c].sensors = sensors + c * per_conn;
+        conns[c].count = (c + 1) * per_conn <= opts.sensors ? per_conn : opts.sensors - c * per_conn;
+        conns[c].rng = boot + (unsigned int)c;
+
+        MQTTClient_connectOptions conn_opts = MQTTClient_connectOptions_initializer;
+        conn_opts.keepAliveInterval = 20;
+        conn_opts.cleansession = 1;
+        if (MQTTClient_create(&conns[c].client, opts.address, client_id, MQTTCLIENT_PERSISTENCE_NONE, NULL) != MQTTCLIENT_SUCCESS ||
+            MQTTClient_connect(conns[c].client, &conn_opts) != MQTTCLIENT_SUCCESS) {
+            fprintf(stderr, "connection %d to %s failed\n", c, opts.address);
+            return 1;
+        }
+    }
+
+    printf("%d sensors over %d connections, %.1f msg/s (interval %.1f s), %d s, qos %d, trigger %s\n",
+           opts.sensors, opts.connections, opts.sensors / opts.interval_sec, opts.interval_sec,
+           opts.duration_sec, opts.qos, opts.trigger);
+
+    double ingested_before = scrape_counter("techtemp_readings_ingested_total");
+    double dup_dropped_before = scrape_counter("techtemp_mqtt_messages_dropped_total{reason=\"duplicate\"}");
+    int latency_ok = snapshot_latency(latency_before);
+    int64_t t0 = now_ms();
+
+    for (int c = 0; c < opts.connections; c++) {
+        pthread_create(&threads[c], NULL, connection_thread, &conns[c]);
+    }
+    for (int c = 0; c < opts.connections; c++) {
+        pthread_join(threads[c], NULL);
+    }
+    double elapsed = (now_ms() - t0) / 1000.0;
+
+    for (int c = 0; c < opts.connections; c++) {
+        MQTTClient_disconnect(conns[c].client, 5000);
+        MQTTClient_destroy(&conns[c].client);
+    }
+
+    // Laisser le serveur vider ce qui est en transit
+    sleep_ms(2000);
+    double ingested_after = scrape_counter("techtemp_readings_ingested_total");
+    double dup_dropped_after = scrape_counter("techtemp_mqtt_messages_dropped_total{reason=\"duplicate\"}");
+    latency_ok = latency_ok && snapshot_latency(latency_after);
+
+    printf("published %lu messages in %.1f s (%.1f msg/s), %lu failed, %lu duplicates, %lu reordered\n",
+           (unsigned long)published, elapsed, published / elapsed, (unsigned long)failures,
+           (unsigned long)duplicates, (unsigned long)reordered);
+    if (ingested_before >= 0 && ingested_after >= 0) {
+        printf("server ingested %.0f readings (%.1f/s), dropped %.0f duplicates\n",
+               ingested_after - ingested_before, (ingested_after - ingested_before) / (elapsed + 2.0),
+               dup_dropped_after - dup_dropped_before);
+    } else {
+        printf("server metrics unavailable on %s:%s\n", opts.http_host, opts.http_port);
+    }
+    if (latency_ok) {
+        print_latency(latency_before, latency_after);
+    } else {
+        printf("server latency: unavailable\n");
+    }
+
+    free(threads);
+    free(sensors);
+    free(conns);
+    return 0;
+}
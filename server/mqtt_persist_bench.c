@@ -0,0 +1,81 @@
+/* mqtt_persist_bench.c - débit de publication QoS1 selon le mode de persistance
+ *
+ * Usage : ./mqtt_persist_bench [adresse] [nb_messages] [répertoire]
+ *   ex.  ./mqtt_persist_bench tcp://localhost:1883 2000 /tmp/persist_bench
+ *
+ * Publie nb_messages QoS1 (attente du PUBACK, comme le client capteur) pour
+ * chaque mode none / file / mmap et affiche messages/s. Lancer sur la carte SD
+ * cible pour comparer l'usure/latence réelle.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mqtt_transport.h"
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void bench_log(int level, const char* msg, void* user) {
+    (void)user;
+    if (level <= 2) fprintf(stderr, "[mqtt] %s\n", msg);
+}
+
+static int run_mode(const char* address, MqttPersistType mode, const char* name,
+                    const char* dir, int count) {
+    MqttConfig cfg = {
+        .address = address,
+        .client_id = "techtemp_persist_bench",
+        .keepalive_sec = 20,
+        .clean_session = 1,
+        .persist = mode,
+        .persist_dir = dir,
+        .run_background_thread = 1,
+        .loop_interval_ms = 10
+    };
+
+    if (mqtt_init(&cfg) != 0) {
+        fprintf(stderr, "[%s] mqtt_init failed\n", name);
+        return -1;
+    }
+
+    char payload[128];
+    int sent = 0, failed = 0;
+    double t0 = now_sec();
+    for (int i = 0; i < count; ++i) {
+        int n = snprintf(payload, sizeof payload,
+                         "{\"sensor_id\":250,\"room_id\":0,\"temperature\":21.%02d,\"humidity\":50,\"trigger\":\"bench\"}",
+                         i % 100);
+        if (mqtt_publish("bench/persist", payload, (size_t)n, 1, 0, 5000) == MQTT_SEND_OK) {
+            sent++;
+        } else {
+            failed++;
+        }
+    }
+    double elapsed = now_sec() - t0;
+    mqtt_cleanup();
+
+    printf("mode=%-4s sent=%d failed=%d elapsed_s=%.3f rate_msg_s=%.1f\n",
+           name, sent, failed, elapsed, elapsed > 0 ? sent / elapsed : 0.0);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* address = (argc > 1) ? argv[1] : "tcp://localhost:1883";
+    int count = (argc > 2) ? atoi(argv[2]) : 1000;
+    const char* dir = (argc > 3) ? argv[3] : "persist_bench";
+    if (count <= 0) count = 1000;
+
+    mqtt_set_logger(bench_log, NULL);
+    printf("# broker=%s messages=%d qos=1 dir=%s\n", address, count, dir);
+
+    int rc = 0;
+    rc |= run_mode(address, MQTT_PERSIST_NONE, "none", NULL, count);
+    rc |= run_mode(address, MQTT_PERSIST_FILE, "file", dir, count);
+    rc |= run_mode(address, MQTT_PERSIST_MMAP, "mmap", dir, count);
+    return rc ? 1 : 0;
+}
@@ -0,0 +1,132 @@
+/* persist_check.c - journal mmap de la persistance MQTT : rejeu, compaction, réouverture
+ *
+ * Usage : ./persist_check [répertoire]   (make check ; défaut : répertoire temporaire)
+ *
+ * Passe par les callbacks Paho comme le client MQTT : put/remove jusqu'à forcer
+ * des compactions, puis relecture après fermeture / réouverture du journal.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "mqtt_persist_mmap.h"
+#include "check.h"
+
+#define CLIENT_ID "persist_check"
+#define SERVER_URI "check"
+#define CHURN 400
+#define PAYLOAD 1000
+#define LOG_MIN_SIZE (64 * 1024)
+
+static int put(MQTTClient_persistence *p, void *h, const char *key, const char *data, int len) {
+    char *bufs[1] = { (char *)data };
+    int lens[1] = { len };
+    return p->pput(h, (char *)key, 1, bufs, lens);
+}
+
+// 1 si key contient exactement data
+static int holds(MQTTClient_persistence *p, void *h, const char *key, const char *data, int len) {
+    char *buf = NULL;
+    int buflen = 0;
+    if (p->pget(h, (char *)key, &buf, &buflen) != 0) return 0;
+    int same = buflen == len && memcmp(buf, data, (size_t)len) == 0;
+    free(buf);
+    return same;
+}
+
+static long journal_size(const char *dir) {
+    char path[512];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s-%s.mqlog", dir, CLIENT_ID, SERVER_URI);
+    return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+static int key_count(MQTTClient_persistence *p, void *h) {
+    char **keys = NULL;
+    int n = 0;
+    if (p->pkeys(h, &keys, &n) != 0) return -1;
+    for (int i = 0; i < n; i++) free(keys[i]);
+    free(keys);
+    return n;
+}
+
+int main(int argc, char *argv[]) {
+    char tmpl[] = "/tmp/persist_check.XXXXXX";
+    const char *dir = argc > 1 ? argv[1] : mkdtemp(tmpl);
+    if (!dir) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    MQTTClient_persistence p;
+    mqtt_persist_mmap_init(&p, dir);
+    void *h = NULL;
+    CHECK(p.popen(&h, CLIENT_ID, SERVER_URI, p.context) == 0);
+    if (!h) return check_report("persist");
+    CHECK(p.pclear(h) == 0);
+
+    // Entrées vivantes de tailles variées, dont une vide
+    char big[PAYLOAD];
+    for (int i = 0; i < PAYLOAD; i++) big[i] = (char)('a' + i % 26);
+    CHECK(put(&p, h, "s-1", "hello", 5) == 0);
+    CHECK(put(&p, h, "s-2", big, PAYLOAD) == 0);
+    CHECK(put(&p, h, "s-3", "", 0) == 0);
+    CHECK(put(&p, h, "s-1", "HELLO", 5) == 0);   // remplacement
+
+    // Churn : put/remove d'une autre clé jusqu'à dépasser plusieurs fois le journal initial (64 Ko)
+    for (int i = 0; i < CHURN; i++) {
+        big[0] = (char)('A' + i % 26);
+        CHECK(put(&p, h, "churn", big, PAYLOAD) == 0);
+        CHECK(p.premove(h, "churn") == 0);
+    }
+    big[0] = 'a';
+    // Sans compaction le journal dépasserait 400 Ko (CHURN enregistrements de 1 Ko)
+    CHECK(journal_size(dir) > 0 && journal_size(dir) <= 2 * LOG_MIN_SIZE);
+    CHECK(p.pcontainskey(h, "churn") != 0);
+    CHECK(key_count(&p, h) == 3);
+    CHECK(holds(&p, h, "s-1", "HELLO", 5));
+    CHECK(holds(&p, h, "s-2", big, PAYLOAD));
+    CHECK(holds(&p, h, "s-3", "", 0));
+    CHECK(p.premove(h, "absent") != 0);
+    CHECK(p.pclose(h) == 0);
+
+    // Réouverture : l'index est reconstruit en rejouant le journal compacté
+    h = NULL;
+    CHECK(p.popen(&h, CLIENT_ID, SERVER_URI, p.context) == 0);
+    if (!h) return check_report("persist");
+    CHECK(key_count(&p, h) == 3);
+    CHECK(holds(&p, h, "s-1", "HELLO", 5));
+    CHECK(holds(&p, h, "s-2", big, PAYLOAD));
+    CHECK(holds(&p, h, "s-3", "", 0));
+
+    // Écritures après réouverture, puis encore une réouverture
+    CHECK(p.premove(h, "s-2") == 0);
+    CHECK(put(&p, h, "s-4", "after", 5) == 0);
+    CHECK(p.pclose(h) == 0);
+    h = NULL;
+    CHECK(p.popen(&h, CLIENT_ID, SERVER_URI, p.context) == 0);
+    if (!h) return check_report("persist");
+    CHECK(key_count(&p, h) == 3);
+    CHECK(p.pcontainskey(h, "s-2") != 0);
+    CHECK(holds(&p, h, "s-4", "after", 5));
+
+    // clear : journal vide, y compris après réouverture
+    CHECK(p.pclear(h) == 0);
+    CHECK(key_count(&p, h) == 0);
+    CHECK(p.pclose(h) == 0);
+    h = NULL;
+    CHECK(p.popen(&h, CLIENT_ID, SERVER_URI, p.context) == 0);
+    if (!h) return check_report("persist");
+    CHECK(key_count(&p, h) == 0);
+    CHECK(p.pclose(h) == 0);
+
+    if (argc <= 1) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s-%s.mqlog", dir, CLIENT_ID, SERVER_URI);
+        unlink(path);
+        rmdir(dir);
+    }
+    return check_report("persist");
+}
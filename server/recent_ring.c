@@ -0,0 +1,156 @@
+#include "recent_ring.h"
+#include <math.h>
+
+static int16_t to_centi(double v) {
+    double c = v * 100.0;
+    if (c > INT16_MAX) return INT16_MAX;
+    if (c < INT16_MIN) return INT16_MIN;
+    return (int16_t)(c < 0 ? c - 0.5 : c + 0.5);
+}
+
+static uint32_t slot(const RecentRing *r, uint32_t i) {
+    uint32_t s = r->head + i;
+    return s >= RECENT_RING_CAPACITY ? s - RECENT_RING_CAPACITY : s;
+}
+
+static void store(RecentRing *r, uint32_t s, time_t ts, double temperature, double humidity) {
+    r->ts[s] = (int32_t)ts;
+    r->temperature[s] = to_centi(temperature);
+    r->humidity[s] = to_centi(humidity);
+}
+
+// Capture plus ancienne que le dernier point (backlog/backfill) : insertion à sa place.
+// Coût O(n) par décalage, réservé à ce cas ; l'ajout en fin reste O(1).
+static void insert_older(RecentRing *r, time_t ts, double temperature, double humidity) {
+    r->out_of_order++;
+    uint32_t i = recent_ring_find(r, ts);
+
+    // Minute déjà présente : la capture la plus récente l'emporte
+    if (i < r->count && r->ts[slot(r, i)] / RECENT_RING_SLOT_SEC == ts / RECENT_RING_SLOT_SEC) {
+        if (ts > r->ts[slot(r, i)]) store(r, slot(r, i), ts, temperature, humidity);
+        return;
+    }
+    if (i > 0 && r->ts[slot(r, i - 1)] / RECENT_RING_SLOT_SEC == ts / RECENT_RING_SLOT_SEC) {
+        store(r, slot(r, i - 1), ts, temperature, humidity);
+        return;
+    }
+
+    if (r->count == RECENT_RING_CAPACITY) {
+        if (i == 0) {
+            // Plus ancienne que tout l'anneau plein
+            r->dropped++;
+            return;
+        }
+        r->head = slot(r, 1);
+        r->count--;
+        i--;
+    }
+    for (uint32_t k = r->count; k > i; k--) {
+        uint32_t dst = slot(r, k), src = slot(r, k - 1);
+        r->ts[dst] = r->ts[src];
+        r->temperature[dst] = r->temperature[src];
+        r->humidity[dst] = r->humidity[src];
+    }
+    r->count++;
+    store(r, slot(r, i), ts, temperature, humidity);
+}
+
+void recent_ring_push(RecentRing *r, time_t ts, double temperature, double humidity) {
+    uint32_t s;
+    if (r->count > 0) {
+        int32_t last = r->ts[slot(r, r->count - 1)];
+        if (ts < last) {
+            insert_older(r, ts, temperature, humidity);
+            return;
+        }
+        if (ts / RECENT_RING_SLOT_SEC == last / RECENT_RING_SLOT_SEC) {
+            store(r, slot(r, r->count - 1), ts, temperature, humidity);
+            return;
+        }
+    }
+
+    if (r->count == RECENT_RING_CAPACITY) {
+        s = r->head;
+        r->head = slot(r, 1);
+    } else {
+        s = slot(r, r->count++);
+    }
+    store(r, s, ts, temperature, humidity);
+}
+
+uint32_t recent_ring_find(const RecentRing *r, time_t since) {
+    // Recherche dichotomique sur les index logiques (points triés)
+    uint32_t lo = 0, hi = r->count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (r->ts[slot(r, mid)] < since) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void recent_ring_get(const RecentRing *r, uint32_t i, time_t *ts, double *temperature, double *humidity) {
+    uint32_t s = slot(r, i);
+    *ts = r->ts[s];
+    *temperature = r->temperature[s] / 100.0;
+    *humidity = r->humidity[s] / 100.0;
+}
+
+typedef struct {
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    int64_t sumsq;
+} SpanAcc;
+
+// Noyau sur un segment contigu : boucles sans dépendance entre itérations,
+// vectorisées par le compilateur à -O3 (min/max/somme/somme des carrés en entiers)
+static void span_accumulate(const int16_t *restrict v, uint32_t n, SpanAcc *acc) {
+    int32_t mn = acc->min, mx = acc->max;
+    int64_t sum = 0, sumsq = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        int32_t x = v[i];
+        mn = x < mn ? x : mn;
+        mx = x > mx ? x : mx;
+        sum += x;
+        sumsq += x * x;
+    }
+    acc->min = mn;
+    acc->max = mx;
+    acc->sum += sum;
+    acc->sumsq += sumsq;
+}
+
+static void finish(const SpanAcc *acc, uint32_t n, RecentStats *out) {
+    out->count = n;
+    if (n == 0) {
+        out->min = out->max = out->mean = out->stddev = 0.0;
+        return;
+    }
+    double mean = (double)acc->sum / n;
+    double var = (double)acc->sumsq / n - mean * mean;
+    out->min = acc->min / 100.0;
+    out->max = acc->max / 100.0;
+    out->mean = mean / 100.0;
+    out->stddev = var > 0.0 ? sqrt(var) / 100.0 : 0.0;
+}
+
+uint32_t recent_ring_stats(const RecentRing *r, time_t since, RecentStats *temperature, RecentStats *humidity) {
+    uint32_t first = recent_ring_find(r, since);
+    uint32_t n = r->count - first;
+    SpanAcc t = { INT16_MAX, INT16_MIN, 0, 0 };
+    SpanAcc h = { INT16_MAX, INT16_MIN, 0, 0 };
+
+    // Au plus deux segments contigus (avant / après le bouclage de l'anneau)
+    uint32_t start = slot(r, first);
+    uint32_t len1 = RECENT_RING_CAPACITY - start;
+    if (len1 > n) len1 = n;
+    span_accumulate(r->temperature + start, len1, &t);
+    span_accumulate(r->humidity + start, len1, &h);
+    span_accumulate(r->temperature, n - len1, &t);
+    span_accumulate(r->humidity, n - len1, &h);
+
+    finish(&t, n, temperature);
+    finish(&h, n, humidity);
+    return n;
+}
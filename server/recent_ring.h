@@ -0,0 +1,47 @@
+#ifndef RECENT_RING_H
+#define RECENT_RING_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Mesures récentes d'un device en mémoire, structure de tableaux :
+// horodatage int32 + centièmes int16 => 8 octets par point, 1440 points
+// (24 h à une mesure par minute) = 11,5 Ko par device.
+// Une minute = un point : une mesure dans la même minute remplace la précédente.
+// Les points restent triés : une capture plus ancienne que le dernier point (backlog/backfill)
+// est insérée à sa place ; elle n'est écartée que si elle précède tout l'anneau plein.
+// L'appelant filtre les horodatages dans le futur, qui bloqueraient l'ajout en fin.
+
+#define RECENT_RING_CAPACITY 1440
+#define RECENT_RING_SLOT_SEC 60
+
+typedef struct {
+    int32_t ts[RECENT_RING_CAPACITY];           // epoch (s)
+    int16_t temperature[RECENT_RING_CAPACITY];  // centièmes de °C
+    int16_t humidity[RECENT_RING_CAPACITY];     // centièmes de %
+    uint32_t head;          // index du plus ancien
+    uint32_t count;
+    uint32_t out_of_order;  // captures hors ordre (cumul)
+    uint32_t dropped;       // captures écartées (cumul)
+} RecentRing;
+
+typedef struct {
+    uint32_t count;
+    double min;
+    double max;
+    double mean;
+    double stddev;
+} RecentStats;
+
+void recent_ring_push(RecentRing *r, time_t ts, double temperature, double humidity);
+
+// Statistiques des points de ts >= since ; renvoie le nombre de points
+uint32_t recent_ring_stats(const RecentRing *r, time_t since, RecentStats *temperature, RecentStats *humidity);
+
+// Index logique (0 = plus ancien) du premier point de ts >= since
+uint32_t recent_ring_find(const RecentRing *r, time_t since);
+
+// Point d'index logique i
+void recent_ring_get(const RecentRing *r, uint32_t i, time_t *ts, double *temperature, double *humidity);
+
+#endif // RECENT_RING_H
@@ -0,0 +1,112 @@
+/* recent_ring_check.c - anneau des mesures récentes : minute, ordre, bouclage, statistiques
+ *
+ * Usage : ./recent_ring_check   (make check)
+ *
+ * Ajouts dans l'ordre et hors ordre (backlog/backfill), anneau plein, recherche
+ * par horodatage et statistiques comparées à un calcul direct en double.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "recent_ring.h"
+#include "check.h"
+
+#define T0 1700000000
+
+// Points triés par horodatage strictement croissant, au plus un par minute
+static int well_formed(const RecentRing *r) {
+    for (uint32_t i = 1; i < r->count; i++) {
+        time_t a, b;
+        double t, h;
+        recent_ring_get(r, i - 1, &a, &t, &h);
+        recent_ring_get(r, i, &b, &t, &h);
+        if (a >= b || a / RECENT_RING_SLOT_SEC == b / RECENT_RING_SLOT_SEC) return 0;
+    }
+    return 1;
+}
+
+static double value_at(const RecentRing *r, uint32_t i) {
+    time_t ts;
+    double t, h;
+    recent_ring_get(r, i, &ts, &t, &h);
+    return t;
+}
+
+static time_t ts_at(const RecentRing *r, uint32_t i) {
+    time_t ts;
+    double t, h;
+    recent_ring_get(r, i, &ts, &t, &h);
+    return ts;
+}
+
+int main(void) {
+    RecentRing *r = calloc(1, sizeof(RecentRing));
+    if (!r) return 1;
+
+    // Même minute : remplacement par la capture la plus récente
+    recent_ring_push(r, T0, 20.0, 40.0);
+    recent_ring_push(r, T0 + 30, 21.0, 41.0);
+    CHECK(r->count == 1 && value_at(r, 0) == 21.0);
+    recent_ring_push(r, T0 + 10, 19.0, 39.0);   // plus ancienne, même minute : ignorée
+    CHECK(r->count == 1 && value_at(r, 0) == 21.0);
+
+    // Hors ordre : insertion à sa place, rien n'est perdu
+    recent_ring_push(r, T0 + 600, 25.0, 45.0);
+    recent_ring_push(r, T0 + 300, 23.0, 43.0);
+    recent_ring_push(r, T0 - 600, 15.0, 35.0);
+    CHECK(r->count == 4 && well_formed(r));
+    CHECK(value_at(r, 0) == 15.0 && value_at(r, 2) == 23.0 && value_at(r, 3) == 25.0);
+    CHECK(r->out_of_order == 3 && r->dropped == 0);
+
+    // Arrondi au centième, valeurs négatives comprises
+    recent_ring_push(r, T0 + 900, -3.456, 50.004);
+    CHECK(fabs(value_at(r, 4) - -3.46) < 1e-9);
+
+    // Anneau plein : le plus ancien point sort, une capture antérieure à tout l'anneau est écartée
+    free(r);
+    r = calloc(1, sizeof(RecentRing));
+    if (!r) return 1;
+    for (int i = 0; i < RECENT_RING_CAPACITY + 100; i++) {
+        recent_ring_push(r, T0 + (time_t)i * 120, (double)(i % 50), 50.0);
+    }
+    CHECK(r->count == RECENT_RING_CAPACITY && well_formed(r));
+    CHECK(ts_at(r, 0) == T0 + 100 * 120);
+    recent_ring_push(r, T0, 99.0, 99.0);
+    CHECK(r->dropped == 1 && ts_at(r, 0) == T0 + 100 * 120);
+    // Trou comblé dans un anneau plein bouclé : le plus ancien cède sa place
+    recent_ring_push(r, T0 + 500 * 120 + 60, 77.0, 77.0);
+    CHECK(r->count == RECENT_RING_CAPACITY && well_formed(r));
+    CHECK(ts_at(r, 0) == T0 + 101 * 120);
+    CHECK(recent_ring_find(r, T0 + 500 * 120 + 60) == 500 - 101 + 1);
+    CHECK(value_at(r, 500 - 101 + 1) == 77.0);
+
+    // Recherche : premier point de ts >= since
+    CHECK(recent_ring_find(r, 0) == 0);
+    CHECK(recent_ring_find(r, T0 + 1000 * 120 + 1) == 1000 - 101 + 2);
+    CHECK(recent_ring_find(r, T0 + 10000000) == r->count);
+
+    // Statistiques (deux segments après bouclage) comparées à un calcul direct
+    time_t since = ts_at(r, 200);
+    double sum = 0, sumsq = 0, mn = 1e9, mx = -1e9;
+    uint32_t n = 0;
+    for (uint32_t i = 200; i < r->count; i++, n++) {
+        double v = value_at(r, i);
+        sum += v;
+        sumsq += v * v;
+        mn = v < mn ? v : mn;
+        mx = v > mx ? v : mx;
+    }
+    RecentStats t, h;
+    CHECK(recent_ring_stats(r, since, &t, &h) == n && t.count == n);
+    CHECK(t.min == mn && t.max == mx);
+    CHECK(fabs(t.mean - sum / n) < 1e-9);
+    CHECK(fabs(t.stddev - sqrt(sumsq / n - (sum / n) * (sum / n))) < 1e-6);
+    CHECK(h.count == n && h.min == 50.0 && h.max == 77.0);   // point comblé inclus
+
+    // Fenêtre vide
+    CHECK(recent_ring_stats(r, T0 + 10000000, &t, &h) == 0 && t.count == 0 && t.mean == 0.0);
+
+    free(r);
+    return check_report("recent_ring");
+}
@@ -0,0 +1,105 @@
+/* router_check.c - correspondance des filtres MQTT du routeur de topics
+ *
+ * Usage : ./router_check   (make check)
+ *
+ * Filtres littéraux, '+', '#' (y compris le niveau parent), topics '$SYS',
+ * validation des filtres, ordre des handlers, retrait et vidage.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "mqtt_router.h"
+#include "check.h"
+
+static void count_call(const char *topic, const void *payload, size_t len, void *user) {
+    (void)topic;
+    (void)payload;
+    (void)len;
+    (*(int *)user)++;
+}
+
+// Nombre d'appels de l'unique filtre filter pour topic
+static int matches(const char *filter, const char *topic) {
+    MqttRouter *r = mqtt_router_create();
+    int calls = 0;
+    if (!r || mqtt_router_add(r, filter, count_call, &calls) != 0) {
+        mqtt_router_destroy(r);
+        return -1;
+    }
+    int dispatched = mqtt_router_dispatch(r, topic, "", 0);
+    mqtt_router_destroy(r);
+    return dispatched == calls ? calls : -1;
+}
+
+static char order[8];
+static size_t order_len;
+
+static void record_call(const char *topic, const void *payload, size_t len, void *user) {
+    (void)topic;
+    (void)payload;
+    (void)len;
+    if (order_len + 1 < sizeof(order)) order[order_len++] = *(const char *)user;
+}
+
+int main(void) {
+    // Littéraux
+    CHECK(matches("weather", "weather") == 1);
+    CHECK(matches("weather", "weather/status") == 0);
+    CHECK(matches("weather/status", "weather") == 0);
+    CHECK(matches("weather/command/1", "weather/command/1") == 1);
+    CHECK(matches("weather/command/1", "weather/command/12") == 0);
+
+    // '+' : exactement un niveau, éventuellement vide
+    CHECK(matches("weather/command/+", "weather/command/7") == 1);
+    CHECK(matches("weather/command/+", "weather/command/room/2") == 0);
+    CHECK(matches("weather/command/+", "weather/command/") == 1);
+    CHECK(matches("weather/+/room/+", "weather/command/room/3") == 1);
+    CHECK(matches("+", "weather") == 1);
+    CHECK(matches("+", "weather/status") == 0);
+
+    // '#' : tous les niveaux suivants et le niveau parent
+    CHECK(matches("weather/#", "weather") == 1);
+    CHECK(matches("weather/#", "weather/command/room/3") == 1);
+    CHECK(matches("weather/#", "weatherx") == 0);
+    CHECK(matches("#", "weather/telemetry") == 1);
+    CHECK(matches("weather/+/#", "weather/command") == 1);
+
+    // '$SYS' : jamais capturé par un wildcard de tête
+    CHECK(matches("#", "$SYS/broker/uptime") == 0);
+    CHECK(matches("+/broker/uptime", "$SYS/broker/uptime") == 0);
+    CHECK(matches("$SYS/#", "$SYS/broker/uptime") == 1);
+
+    // Validation
+    CHECK(mqtt_topic_filter_valid("weather/+/status"));
+    CHECK(mqtt_topic_filter_valid("#"));
+    CHECK(!mqtt_topic_filter_valid(""));
+    CHECK(!mqtt_topic_filter_valid("weather/#/status"));
+    CHECK(!mqtt_topic_filter_valid("weather/com+"));
+    CHECK(!mqtt_topic_filter_valid("weather#"));
+    CHECK(matches("weather/#/x", "weather/a/x") == -1);
+
+    // Plusieurs handlers : tous appelés, dans l'ordre d'enregistrement par filtre
+    MqttRouter *r = mqtt_router_create();
+    CHECK(r != NULL);
+    if (!r) return check_report("router");
+    CHECK(mqtt_router_add(r, "weather/command/1", record_call, "a") == 0);
+    CHECK(mqtt_router_add(r, "weather/command/+", record_call, "b") == 0);
+    CHECK(mqtt_router_add(r, "weather/#", record_call, "c") == 0);
+    CHECK(mqtt_router_add(r, "weather/command/1", record_call, "d") == 0);
+    CHECK(mqtt_router_dispatch(r, "weather/command/1", "", 0) == 4);
+    CHECK(order_len == 4 && strchr(order, 'a') < strchr(order, 'd'));
+    CHECK(mqtt_router_dispatch(r, "weather/command/2", "", 0) == 2);
+
+    // Retrait : tous les handlers du filtre, les autres restent
+    CHECK(mqtt_router_remove(r, "weather/command/1") == 2);
+    CHECK(mqtt_router_remove(r, "weather/command/1") == 0);
+    CHECK(mqtt_router_remove(r, "absent/topic") == 0);
+    CHECK(mqtt_router_dispatch(r, "weather/command/1", "", 0) == 2);
+    mqtt_router_clear(r);
+    CHECK(mqtt_router_dispatch(r, "weather/command/1", "", 0) == 0);
+    CHECK(mqtt_router_add(r, "weather", record_call, "e") == 0);
+    CHECK(mqtt_router_dispatch(r, "weather", "", 0) == 1);
+    mqtt_router_destroy(r);
+
+    return check_report("router");
+}
@@ -0,0 +1,93 @@
+#include "seq_window.h"
+#include <string.h>
+
+static void shift_left(uint64_t *bits, uint32_t n) {
+    if (n >= SEQ_WINDOW_BITS) {
+        memset(bits, 0, sizeof(uint64_t) * SEQ_WINDOW_WORDS);
+        return;
+    }
+    uint32_t words = n / 64, off = n % 64;
+    for (int i = SEQ_WINDOW_WORDS - 1; i >= 0; i--) {
+        uint64_t v = 0;
+        int src = i - (int)words;
+        if (src >= 0) {
+            v = bits[src] << off;
+            if (off && src > 0) v |= bits[src - 1] >> (64 - off);
+        }
+        bits[i] = v;
+    }
+}
+
+static void reset(SeqWindow *w, uint32_t boot, uint32_t seq) {
+    w->initialized = true;
+    w->boot = boot;
+    w->highest = seq;
+    memset(w->bits, 0, sizeof(w->bits));
+    w->bits[0] = 1;
+}
+
+uint32_t seq_window_oldest(const SeqWindow *w) {
+    return w->highest >= SEQ_WINDOW_BITS ? w->highest - SEQ_WINDOW_BITS + 1 : 1;
+}
+
+bool seq_window_has_all(const SeqWindow *w, uint32_t from, uint32_t to) {
+    if (!w->initialized || to > w->highest) return false;
+    if (from < seq_window_oldest(w)) from = seq_window_oldest(w);
+    for (uint32_t s = from; s <= to; s++) {
+        uint32_t d = w->highest - s;
+        if (!(w->bits[d / 64] & ((uint64_t)1 << (d % 64)))) return false;
+    }
+    return true;
+}
+
+SeqVerdict seq_window_check(SeqWindow *w, uint32_t boot, uint32_t seq) {
+    w->gap_from = w->gap_to = 0;
+    
+    // Message retardé d'un démarrage précédent : ingéré, sans toucher à la fenêtre courante
+    if (w->initialized && boot < w->boot) {
+        w->stale++;
+        w->accepted++;
+        return SEQ_STALE;
+    }
+    
+    // Nouveau démarrage client (compteur croissant) : les messages arrivent dans l'ordre
+    // (le client vide son tampon avant de republier en direct), on repart sur ce boot
+    if (!w->initialized || boot != w->boot) {
+        if (w->initialized) w->restarts++;
+        reset(w, boot, seq);
+        w->accepted++;
+        return SEQ_NEW;
+    }
+    
+    if (seq > w->highest) {
+        uint32_t d = seq - w->highest;
+        w->gaps += d - 1;
+        if (d > 1) {
+            w->gap_from = w->highest + 1;
+            w->gap_to = seq - 1;
+        }
+        shift_left(w->bits, d);
+        w->bits[0] |= 1;
+        w->highest = seq;
+        w->accepted++;
+        return SEQ_NEW;
+    }
+    
+    uint32_t d = w->highest - seq;
+    if (d >= SEQ_WINDOW_BITS) {
+        w->stale++;
+        w->accepted++;
+        return SEQ_STALE;
+    }
+    
+    uint64_t mask = (uint64_t)1 << (d % 64);
+    if (w->bits[d / 64] & mask) {
+        w->duplicates++;
+        return SEQ_DUPLICATE;
+    }
+    w->bits[d / 64] |= mask;
+    if (w->gaps > 0) w->gaps--;
+    w->late++;
+    w->accepted++;
+    return SEQ_NEW;
+}
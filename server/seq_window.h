@@ -0,0 +1,45 @@
+#ifndef SEQ_WINDOW_H
+#define SEQ_WINDOW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Fenêtre glissante de numéros de séquence (un capteur, un démarrage client).
+// Bit i du bitmap = séquence (highest - i) déjà reçue. Doublons écartés en O(1).
+#define SEQ_WINDOW_BITS 256
+#define SEQ_WINDOW_WORDS (SEQ_WINDOW_BITS / 64)
+
+typedef enum {
+    SEQ_NEW = 0,        // première réception, à ingérer
+    SEQ_DUPLICATE,      // déjà reçue : à ignorer
+    SEQ_STALE           // plus ancienne que la fenêtre : ingérée, doublon indétectable
+} SeqVerdict;
+
+typedef struct {
+    bool initialized;
+    uint32_t boot;
+    uint32_t highest;
+    uint64_t bits[SEQ_WINDOW_WORDS];
+    
+    // Compteurs cumulés (non remis à zéro au changement de boot)
+    unsigned long accepted;
+    unsigned long duplicates;
+    unsigned long gaps;         // séquences jamais reçues (trous ouverts - trous comblés)
+    unsigned long late;         // arrivées hors ordre qui comblent un trou
+    unsigned long stale;        // hors fenêtre ou d'un boot antérieur
+    unsigned long restarts;     // passages à un boot plus récent
+    
+    // Trou ouvert par le dernier appel (gap_from = 0 : aucun)
+    uint32_t gap_from;
+    uint32_t gap_to;
+} SeqWindow;
+
+SeqVerdict seq_window_check(SeqWindow *w, uint32_t boot, uint32_t seq);
+
+// Plus ancienne séquence encore suivie par la fenêtre
+uint32_t seq_window_oldest(const SeqWindow *w);
+
+// true si toutes les séquences [from, to] de la fenêtre ont été reçues
+bool seq_window_has_all(const SeqWindow *w, uint32_t from, uint32_t to);
+
+#endif // SEQ_WINDOW_H
@@ -0,0 +1,95 @@
+/* seq_window_check.c - fenêtre de séquence : doublons, trous, retards, redémarrages
+ *
+ * Usage : ./seq_window_check   (make check)
+ *
+ * Les décalages du bitmap traversent les mots de 64 bits ; chaque verdict est
+ * comparé à un modèle naïf (ensemble des séquences reçues) sur un flux pseudo-aléatoire.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "seq_window.h"
+#include "check.h"
+
+#define MODEL_MAX 20000
+
+int main(void) {
+    SeqWindow w;
+    memset(&w, 0, sizeof(w));
+
+    // Ordre normal, doublon, trou puis comblement
+    CHECK(seq_window_check(&w, 7, 1) == SEQ_NEW);
+    CHECK(seq_window_check(&w, 7, 2) == SEQ_NEW);
+    CHECK(seq_window_check(&w, 7, 2) == SEQ_DUPLICATE);
+    CHECK(seq_window_check(&w, 7, 6) == SEQ_NEW);
+    CHECK(w.gap_from == 3 && w.gap_to == 5 && w.gaps == 3);
+    CHECK(seq_window_check(&w, 7, 4) == SEQ_NEW);
+    CHECK(w.gap_from == 0 && w.gaps == 2 && w.late == 1);
+    CHECK(seq_window_check(&w, 7, 4) == SEQ_DUPLICATE);
+    CHECK(!seq_window_has_all(&w, 1, 6));
+    CHECK(seq_window_has_all(&w, 4, 4));
+    CHECK(seq_window_check(&w, 7, 3) == SEQ_NEW);
+    CHECK(seq_window_check(&w, 7, 5) == SEQ_NEW);
+    CHECK(seq_window_has_all(&w, 1, 6) && w.gaps == 0);
+    CHECK(!seq_window_has_all(&w, 1, 7));
+    CHECK(w.duplicates == 2 && w.accepted == 6);
+
+    // Saut au-delà de la fenêtre : les anciennes séquences deviennent indétectables
+    CHECK(seq_window_check(&w, 7, 6 + SEQ_WINDOW_BITS + 10) == SEQ_NEW);
+    CHECK(seq_window_oldest(&w) == 6 + 10 + 1);
+    CHECK(seq_window_check(&w, 7, 6) == SEQ_STALE && w.stale == 1);
+    CHECK(seq_window_check(&w, 7, seq_window_oldest(&w)) == SEQ_NEW);
+
+    // Nouveau boot : repart de zéro, compteurs cumulés conservés
+    unsigned long accepted = w.accepted;
+    CHECK(seq_window_check(&w, 8, 1) == SEQ_NEW);
+    CHECK(w.restarts == 1 && w.accepted == accepted + 1 && w.highest == 1);
+    CHECK(seq_window_check(&w, 8, 1) == SEQ_DUPLICATE);
+    
+    // Message retardé d'un boot antérieur : stale, la fenêtre du boot courant reste en place
+    unsigned long stale = w.stale;
+    CHECK(seq_window_check(&w, 7, 3) == SEQ_STALE);
+    CHECK(w.stale == stale + 1 && w.restarts == 1 && w.boot == 8 && w.highest == 1);
+    CHECK(seq_window_check(&w, 8, 1) == SEQ_DUPLICATE);
+
+    // Décalages de 1 à 300 (mots de 64 bits, fenêtre entière) : les bits restent à leur place
+    for (uint32_t step = 1; step <= 300; step += 7) {
+        memset(&w, 0, sizeof(w));
+        seq_window_check(&w, 1, 1000);
+        seq_window_check(&w, 1, 1000 - 63);
+        seq_window_check(&w, 1, 1000 - 64);
+        seq_window_check(&w, 1, 1000 + step);
+        int old = step + 64 < SEQ_WINDOW_BITS;
+        CHECK(seq_window_check(&w, 1, 1000) == (step < SEQ_WINDOW_BITS ? SEQ_DUPLICATE : SEQ_STALE));
+        CHECK(seq_window_check(&w, 1, 1000 - 64) == (old ? SEQ_DUPLICATE : SEQ_STALE));
+        CHECK(seq_window_check(&w, 1, 1000 - 62) == (step + 62 < SEQ_WINDOW_BITS ? SEQ_NEW : SEQ_STALE));
+    }
+
+    // Flux pseudo-aléatoire (retards, doublons) comparé au modèle naïf
+    static unsigned char seen[MODEL_MAX];
+    memset(&w, 0, sizeof(w));
+    memset(seen, 0, sizeof(seen));
+    uint32_t highest = 0, rng = 12345;
+    int mismatches = 0;
+    for (int i = 0; i < 50000; i++) {
+        rng = rng * 1103515245u + 12345u;
+        uint32_t r = (rng >> 16) % 100;
+        uint32_t seq;
+        if (r < 70 || highest == 0) seq = highest + 1 + (r % 3 == 0);   // en avance, trou parfois
+        else if (r < 95) seq = highest > 40 ? highest - r % 40 : 1;     // retard ou doublon
+        else seq = highest > 300 ? highest - (rng >> 8) % 300 : 1;      // parfois hors fenêtre
+        if (seq >= MODEL_MAX) break;
+
+        SeqVerdict expect;
+        if (highest != 0 && seq + SEQ_WINDOW_BITS <= highest) expect = SEQ_STALE;
+        else expect = seen[seq] ? SEQ_DUPLICATE : SEQ_NEW;
+        if (seq_window_check(&w, 1, seq) != expect) mismatches++;
+        if (expect != SEQ_DUPLICATE) seen[seq] = 1;
+        if (seq > highest) highest = seq;
+    }
+    CHECK(mismatches == 0);
+    CHECK(w.highest == highest);
+
+    return check_report("seq_window");
+}
@@ -0,0 +1,320 @@
+/* server_bench.c - micro-benchmarks des chemins chauds du serveur
+ *
+ * Usage : ./server_bench [-c cpu] [-t ms] [-r répétitions] [-f filtre] [-d répertoire] [-o fichier]
+ *   ex.  make bench
+ *        ./server_bench -c 3 -t 500 -f monitor_update_device -o bench.jsonl
+ *
+ *   -c  CPU sur lequel le processus est épinglé (défaut : dernier CPU en ligne)
+ *   -t  durée visée d'une répétition en ms (200) ; la chauffe dure autant
+ *   -r  nombre de répétitions mesurées (5)
+ *   -f  ne lance que les cas dont le nom contient ce filtre
+ *   -d  répertoire de la base SQLite temporaire (/tmp)
+ *
+ * Une ligne JSON par cas (stdout ou -o), pour comparer deux versions avant déploiement :
+ *   {"bench":"monitor_update_device","param":1000,"cpu":3,"iterations":...,
+ *    "ns_per_op":...,"ns_per_op_min":...,"allocs_per_op":...,"bytes_per_op":...}
+ * ns_per_op est la médiane des répétitions. Les allocations sont comptées en
+ * remplaçant malloc/calloc/realloc (glibc) : cJSON et SQLite compris.
+ * Les logs des fonctions mesurées partent dans /dev/null.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "cJSON.h"
+#include "sqlite3.h"
+#include "system_monitor.h"
+#include "http_server.h"
+#include "db_sqlite.h"
+#include "weather_payload.h"
+
+/* ------- Comptage des allocations ------- */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+// Le banc est mono-thread : compteurs simples
+static uint64_t alloc_count;
+static uint64_t alloc_bytes;
+
+void *malloc(size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+    alloc_count++;
+    alloc_bytes += n * size;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __libc_realloc(ptr, size);
+}
+
+/* ------- Exécution d'un cas ------- */
+typedef void (*BenchFn)(void *ctx, uint64_t i);
+
+typedef struct {
+    const char *name;
+    long param;
+    BenchFn fn;
+    void *ctx;
+    uint64_t calls;     // index passé à fn, continu entre chauffe et mesures
+} BenchCase;
+
+static FILE *out;
+static int bench_cpu = -1;
+static long target_ms = 200;
+static int repetitions = 5;
+static const char *filter;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t run_batch(BenchCase *c, uint64_t n) {
+    uint64_t t0 = now_ns();
+    for (uint64_t k = 0; k < n; k++) {
+        c->fn(c->ctx, c->calls++);
+    }
+    return now_ns() - t0;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static bool selected(const char *name) {
+    return !filter || strstr(name, filter) != NULL;
+}
+
+static void run_case(BenchCase *c) {
+    const uint64_t target_ns = (uint64_t)target_ms * 1000000ull;
+
+    // Chauffe (caches, prédicteurs, pages) et estimation du coût d'une opération
+    uint64_t n = 1, done = 0, spent = 0;
+    while (spent < target_ns) {
+        spent += run_batch(c, n);
+        done += n;
+        if (n < (1u << 20)) n *= 2;
+    }
+    uint64_t iterations = (uint64_t)((double)target_ns * done / (double)spent);
+    if (iterations == 0) iterations = 1;
+
+    double ns[repetitions];
+    double allocs = 0, bytes = 0;
+    for (int r = 0; r < repetitions; r++) {
+        uint64_t count0 = alloc_count, bytes0 = alloc_bytes;
+        ns[r] = (double)run_batch(c, iterations) / (double)iterations;
+        // La dernière répétition fait foi (les allocations ne varient pas d'une répétition à l'autre)
+        allocs = (double)(alloc_count - count0) / (double)iterations;
+        bytes = (double)(alloc_bytes - bytes0) / (double)iterations;
+    }
+    qsort(ns, (size_t)repetitions, sizeof(double), cmp_double);
+
+    fprintf(out, "{\"bench\":\"%s\",\"param\":%ld,\"cpu\":%d,\"iterations\":%llu,"
+                 "\"ns_per_op\":%.1f,\"ns_per_op_min\":%.1f,\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f}\n",
+            c->name, c->param, bench_cpu, (unsigned long long)iterations,
+            ns[repetitions / 2], ns[0], allocs, bytes);
+    fflush(out);
+}
+
+/* ------- Décodage des payloads (weather_payload_decode, comme on_mqtt_msg) ------- */
+static const char reading_payload[] =
+    "{\"sensor_id\":1,\"room_id\":1,\"temperature\":21.37,\"humidity\":48,\"trigger\":\"scheduled\","
+    "\"ts\":1760000000,\"ts_ms\":1760000000123,\"boot\":1759990000,\"seq\":4242}";
+
+static char batch_payload[2048];
+
+static volatile int decode_sink;
+
+static void bench_decode(void *ctx, uint64_t i) {
+    (void)i;
+    const char *payload = ctx;
+    WeatherPayload p;
+    // Réception datée juste après les captures des payloads : horodatages plausibles
+    if (weather_payload_decode(&p, payload, strlen(payload), 1760003600) == 0) {
+        decode_sink = p.count + p.invalid;
+    }
+    weather_payload_free(&p);
+}
+
+static void build_batch_payload(void) {
+    int n = snprintf(batch_payload, sizeof(batch_payload),
+                     "{\"sensor_id\":1,\"room_id\":1,\"trigger\":\"backlog\",\"readings\":[");
+    for (int k = 0; k < 10; k++) {
+        n += snprintf(batch_payload + n, sizeof(batch_payload) - (size_t)n,
+                      "%s{\"ts\":%d,\"temperature\":%.2f,\"humidity\":%d,\"trigger\":\"scheduled\","
+                      "\"boot\":1759990000,\"seq\":%d}", k ? "," : "", 1760000000 + k * 300, 21.0 + k * 0.1,
+                      45 + k, 4200 + k);
+    }
+    snprintf(batch_payload + n, sizeof(batch_payload) - (size_t)n, "]}");
+}
+
+/* ------- Monitoring ------- */
+#define BENCH_FIRST_SENSOR 1000
+
+typedef struct {
+    int devices;
+    time_t start;
+} MonitorCtx;
+
+// Table de devices déjà connus (cas courant : pas d'enregistrement pendant la mesure)
+static int monitor_setup(MonitorCtx *m, int devices, bool with_readings) {
+    monitor_cleanup();
+    if (monitor_init_capacity(devices) != 0) return -1;
+    m->devices = devices;
+    m->start = time(NULL) - 60;   // en deçà de ALERT_REPLAY_AGE_SEC : mesures en direct
+    for (int d = 0; d < devices; d++) {
+        int sensor_id = BENCH_FIRST_SENSOR + d;
+        if (with_readings) {
+            monitor_update_device(sensor_id, d % 4 + 1, 21.0, 45.0, m->start, "scheduled");
+        } else {
+            monitor_accept_sequence(sensor_id, d % 4 + 1, 1, 1);
+        }
+    }
+    return 0;
+}
+
+static void bench_monitor_update(void *ctx, uint64_t i) {
+    const MonitorCtx *m = ctx;
+    int d = (int)(i % (uint64_t)m->devices);
+    // Une seconde par tour de flotte, bornée à l'heure courante : comme en production la capture
+    // reste dans la fenêtre plausible (anneau récent alimenté, règles évaluées, pas de rejeu).
+    // Légères variations autour de 21 °C / 45 %
+    time_t captured_at = m->start + (time_t)(i / (uint64_t)m->devices);
+    time_t now = time(NULL);
+    if (captured_at > now) captured_at = now;
+    monitor_update_device(BENCH_FIRST_SENSOR + d, d % 4 + 1, 21.0 + (double)(i % 7) * 0.05,
+                          45.0 + (double)(i % 5) * 0.2, captured_at, "scheduled");
+}
+
+static void bench_monitor_json(void *ctx, uint64_t i) {
+    (void)ctx;
+    (void)i;
+    free(monitor_get_json_status());
+}
+
+/* ------- HTTP ------- */
+static volatile int header_sink;
+
+static void bench_http_header(void *ctx, uint64_t i) {
+    (void)ctx;
+    char header[1024];
+    header_sink = http_format_header(header, sizeof(header), 200, "application/json", 4096 + (int)(i & 255));
+}
+
+/* ------- SQLite ------- */
+static void bench_sqlite_insert(void *ctx, uint64_t i) {
+    db_sqlite_insert(ctx, BENCH_FIRST_SENSOR + (int)(i % 10), 21.5, 45.0, "2025-10-09T12:00:00Z");
+}
+
+static void pin_cpu(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        fprintf(stderr, "[Bench] Warning: could not pin to CPU %d\n", cpu);
+        bench_cpu = -1;
+        return;
+    }
+    bench_cpu = cpu;
+}
+
+int main(int argc, char *argv[]) {
+    const char *db_dir = "/tmp";
+    const char *out_path = NULL;
+    int cpu = (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:t:r:f:d:o:")) != -1) {
+        switch (opt) {
+            case 'c': cpu = atoi(optarg); break;
+            case 't': target_ms = atol(optarg); break;
+            case 'r': repetitions = atoi(optarg); break;
+            case 'f': filter = optarg; break;
+            case 'd': db_dir = optarg; break;
+            case 'o': out_path = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-c cpu] [-t ms] [-r repetitions] [-f filter] [-d dir] [-o file]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (target_ms <= 0 || repetitions <= 0) {
+        fprintf(stderr, "[Bench] -t and -r must be positive\n");
+        return 1;
+    }
+
+    // Résultats sur la sortie d'origine, logs du serveur vers /dev/null
+    out = out_path ? fopen(out_path, "w") : fdopen(dup(STDOUT_FILENO), "w");
+    if (!out || !freopen("/dev/null", "w", stdout)) {
+        fprintf(stderr, "[Bench] cannot open output\n");
+        return 1;
+    }
+    pin_cpu(cpu < 0 ? 0 : cpu);
+
+    build_batch_payload();
+    BenchCase decode_cases[] = {
+        { "decode_reading", (long)strlen(reading_payload), bench_decode, (void *)reading_payload, 0 },
+        { "decode_batch", 0, bench_decode, batch_payload, 0 },
+    };
+    decode_cases[1].param = (long)strlen(batch_payload);
+    for (size_t k = 0; k < sizeof(decode_cases) / sizeof(decode_cases[0]); k++) {
+        if (selected(decode_cases[k].name)) run_case(&decode_cases[k]);
+    }
+
+    static const int fleet_sizes[] = { 10, 1000, 100000 };
+    MonitorCtx monitor;
+    for (size_t k = 0; k < sizeof(fleet_sizes) / sizeof(fleet_sizes[0]); k++) {
+        BenchCase c = { "monitor_update_device", fleet_sizes[k], bench_monitor_update, &monitor, 0 };
+        if (!selected(c.name)) continue;
+        if (monitor_setup(&monitor, fleet_sizes[k], false) != 0) {
+            fprintf(stderr, "[Bench] monitor_init_capacity(%d) failed\n", fleet_sizes[k]);
+            continue;
+        }
+        run_case(&c);
+    }
+
+    // Le rendu complet est servi au dashboard : flottes réalistes seulement
+    static const int json_sizes[] = { 10, 1000 };
+    for (size_t k = 0; k < sizeof(json_sizes) / sizeof(json_sizes[0]); k++) {
+        BenchCase c = { "monitor_get_json_status", json_sizes[k], bench_monitor_json, NULL, 0 };
+        if (!selected(c.name)) continue;
+        if (monitor_setup(&monitor, json_sizes[k], true) != 0) continue;
+        run_case(&c);
+    }
+    monitor_cleanup();
+
+    BenchCase header = { "http_format_header", 0, bench_http_header, NULL, 0 };
+    if (selected(header.name)) run_case(&header);
+
+    BenchCase insert = { "sqlite_insert", 0, bench_sqlite_insert, NULL, 0 };
+    if (selected(insert.name)) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/server_bench_%d.sqlite", db_dir, (int)getpid());
+        sqlite3 *db = NULL;
+        if (sqlite3_open(path, &db) == SQLITE_OK && db_sqlite_create_tables(db) == 0) {
+            insert.ctx = db;
+            run_case(&insert);
+        } else {
+            fprintf(stderr, "[Bench] cannot open %s\n", path);
+        }
+        sqlite3_close(db);
+        unlink(path);
+    }
+
+    fclose(out);
+    return 0;
+}
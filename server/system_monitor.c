@@ -1,12 +1,26 @@
 #include "system_monitor.h"
 #include "cJSON.h"
+#include "metrics.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <pthread.h>
 
 static SystemHealth system_health;
 static bool monitor_initialized = false;
+// Mises à jour depuis le thread MQTT, lectures depuis le thread HTTP
+static pthread_mutex_t monitor_lock = PTHREAD_MUTEX_INITIALIZER;
+static AlertRuleSet alert_rules;
+static AlertEventLog alert_log;
+static int max_devices;
+// Index sensor_id -> position dans devices (adressage ouvert, 0 = case vide, sinon index + 1)
+static int *device_slots;
+static uint32_t device_slots_mask;
+
+// Capture plus ancienne que ce délai (ou que la dernière mesure) : donnée rejouée
+// (backlog/backfill), historisée mais sans évaluation des règles d'alerte
+#define ALERT_REPLAY_AGE_SEC 120
 
 // Table de correspondance room_id -> nom (à adapter selon vos rooms)
 static const struct {
@@ -56,8 +70,14 @@ int calculate_readings_last_hour(DeviceStatus *device) {
     return count;
 }
 
+static uint32_t device_slot(int sensor_id) {
+    uint32_t h = (uint32_t)sensor_id * 2654435769u;
+    return (h ^ (h >> 16)) & device_slots_mask;
+}
+
 int find_device_index(int sensor_id) {
-    for (int i = 0; i < system_health.total_devices; i++) {
+    for (uint32_t s = device_slot(sensor_id); device_slots[s]; s = (s + 1) & device_slots_mask) {
+        int i = device_slots[s] - 1;
         if (system_health.devices[i].sensor_id == sensor_id) {
             return i;
         }
@@ -67,7 +87,19 @@ int find_device_index(int sensor_id) {
 
 void update_device_status(DeviceStatus *device) {
     time_t now = time(NULL);
-    double minutes_since_last = difftime(now, device->last_seen) / 60.0;
+    time_t last_activity = device->last_seen;
+    
+    // Un "offline" (LWT ou arrêt propre) vaut jusqu'à la prochaine mesure ;
+    // un "online" compte comme une activité (utile juste après un redémarrage du serveur)
+    if (device->presence == PRESENCE_OFFLINE && device->presence_at >= device->last_seen) {
+        strcpy(device->status, "offline");
+        device->is_online = false;
+        return;
+    }
+    if (device->presence == PRESENCE_ONLINE && device->presence_at > last_activity) {
+        last_activity = device->presence_at;
+    }
+    double minutes_since_last = difftime(now, last_activity) / 60.0;
     
     if (minutes_since_last > OFFLINE_THRESHOLD_MINUTES) {
         strcpy(device->status, "offline");
@@ -85,9 +117,14 @@ void update_global_status(void) {
     system_health.online_devices = 0;
     system_health.warning_devices = 0;
     system_health.offline_devices = 0;
+    system_health.duplicates = 0;
+    system_health.gaps = 0;
     
     for (int i = 0; i < system_health.total_devices; i++) {
-        update_device_status(&system_health.devices[i]);
+        DeviceStatus *device = &system_health.devices[i];
+        update_device_status(device);
+        system_health.duplicates += system_health.devices[i].seq.duplicates;
+        system_health.gaps += system_health.devices[i].seq.gaps;
         
         if (strcmp(system_health.devices[i].status, "online") == 0) {
             system_health.online_devices++;
@@ -98,6 +135,10 @@ void update_global_status(void) {
         }
     }
     
+    metrics_gauge_set(G_DEVICES_ONLINE, system_health.online_devices);
+    metrics_gauge_set(G_DEVICES_WARNING, system_health.warning_devices);
+    metrics_gauge_set(G_DEVICES_OFFLINE, system_health.offline_devices);
+    
     // Déterminer statut global
     if (system_health.offline_devices > 0) {
         strcpy(system_health.global_status, "critical");
@@ -111,16 +152,31 @@ void update_global_status(void) {
 }
 
 int monitor_init(void) {
+    return monitor_init_capacity(MAX_DEVICES);
+}
+
+int monitor_init_capacity(int capacity) {
     if (monitor_initialized) return 0;
+    if (capacity <= 0) return -1;
     
     memset(&system_health, 0, sizeof(SystemHealth));
-    system_health.devices = malloc(MAX_DEVICES * sizeof(DeviceStatus));
-    if (!system_health.devices) {
+    system_health.devices = malloc((size_t)capacity * sizeof(DeviceStatus));
+    // Index au plus à moitié plein
+    uint32_t slots = 2;
+    while (slots < 2u * (uint32_t)capacity) slots <<= 1;
+    device_slots = calloc(slots, sizeof(int));
+    if (!system_health.devices || !device_slots) {
+        free(system_health.devices);
+        free(device_slots);
         return -1;
     }
+    device_slots_mask = slots - 1;
+    max_devices = capacity;
     
     strcpy(system_health.global_status, "healthy");
     system_health.last_update = time(NULL);
+    alert_rules_load(&alert_rules, ALERT_RULES_FILE);
+    memset(&alert_log, 0, sizeof(alert_log));
     monitor_initialized = true;
     
     printf("[Monitor] System monitor initialized\n");
@@ -129,46 +185,171 @@ int monitor_init(void) {
 
 void monitor_cleanup(void) {
     if (monitor_initialized) {
+        for (int i = 0; i < system_health.total_devices; i++) {
+            free(system_health.devices[i].recent);
+        }
         free(system_health.devices);
+        free(device_slots);
+        device_slots = NULL;
         monitor_initialized = false;
         printf("[Monitor] System monitor cleaned up\n");
     }
 }
 
-void monitor_update_device(int sensor_id, int room_id, double temperature, double humidity) {
-    if (!monitor_initialized) return;
-    
-    time_t now = time(NULL);
+// Retourne le device, créé s'il est nouveau ; NULL si la table est pleine
+static DeviceStatus* find_or_add_device(int sensor_id, int room_id) {
     int device_index = find_device_index(sensor_id);
     
     if (device_index == -1) {
         // Nouveau device
-        if (system_health.total_devices >= MAX_DEVICES) {
-            printf("[Monitor] Warning: Max devices reached\n");
-            return;
+        if (system_health.total_devices >= max_devices) {
+            // Une fois par minute au plus : chaque message d'un device refusé passerait ici
+            static time_t last_warning;
+            static unsigned long refused;
+            time_t now = time(NULL);
+            refused++;
+            if (now - last_warning >= 60) {
+                printf("[Monitor] Warning: Max devices reached (%d), %lu message(s) refused\n",
+                       max_devices, refused);
+                last_warning = now;
+                refused = 0;
+            }
+            return NULL;
         }
         
         device_index = system_health.total_devices++;
+        uint32_t s = device_slot(sensor_id);
+        while (device_slots[s]) s = (s + 1) & device_slots_mask;
+        device_slots[s] = device_index + 1;
         DeviceStatus *device = &system_health.devices[device_index];
+        memset(device, 0, sizeof(*device));
         
         device->sensor_id = sensor_id;
         device->room_id = room_id;
         strncpy(device->room_name, get_room_name(room_id), sizeof(device->room_name) - 1);
-        device->readings_count_last_hour = 0;
-        
-        // Initialiser l'historique des lectures
-        device->reading_history_index = 0;
-        device->reading_history_count = 0;
-        memset(device->reading_timestamps, 0, sizeof(device->reading_timestamps));
+        strcpy(device->status, "offline");
+        alert_bind(&alert_rules, &device->alerts, sensor_id, room_id);
+        device->recent = calloc(1, sizeof(RecentRing));
+        if (!device->recent) {
+            printf("[Monitor] Warning: no memory for recent readings of sensor_%d\n", sensor_id);
+        }
         
         printf("[Monitor] New device registered: sensor_%d in %s\n", sensor_id, device->room_name);
     }
+    return &system_health.devices[device_index];
+}
+
+SeqVerdict monitor_accept_sequence(int sensor_id, int room_id, uint32_t boot, uint32_t seq) {
+    if (!monitor_initialized) return SEQ_NEW;
+    
+    pthread_mutex_lock(&monitor_lock);
+    DeviceStatus *device = find_or_add_device(sensor_id, room_id);
+    SeqVerdict verdict = SEQ_NEW;
+    if (device) {
+        verdict = seq_window_check(&device->seq, boot, seq);
+        DeviceBackfill *bf = &device->backfill;
+        if (bf->pending && bf->boot != device->seq.boot) {
+            // Client redémarré : son historique est perdu (un message retardé d'un boot
+            // antérieur ne change pas de fenêtre)
+            bf->pending = false;
+            bf->abandoned++;
+        }
+        if (device->seq.gap_from) {
+            if (bf->pending) {
+                if (device->seq.gap_from < bf->from) bf->from = device->seq.gap_from;
+                if (device->seq.gap_to > bf->to) bf->to = device->seq.gap_to;
+            } else {
+                bf->pending = true;
+                bf->boot = boot;
+                bf->from = device->seq.gap_from;
+                bf->to = device->seq.gap_to;
+                bf->last_sent = 0;
+                bf->attempts = 0;
+            }
+        }
+    }
+    pthread_mutex_unlock(&monitor_lock);
+    return verdict;
+}
+
+int monitor_next_backfill(int *sensor_id, uint32_t *boot, uint32_t *from, uint32_t *to) {
+    if (!monitor_initialized) return 0;
+    
+    time_t now = time(NULL);
+    int found = 0;
+    pthread_mutex_lock(&monitor_lock);
+    for (int i = 0; i < system_health.total_devices && !found; i++) {
+        DeviceStatus *device = &system_health.devices[i];
+        DeviceBackfill *bf = &device->backfill;
+        if (!bf->pending) continue;
+        
+        // Les séquences sorties de la fenêtre ne sont plus vérifiables
+        uint32_t oldest = seq_window_oldest(&device->seq);
+        if (bf->from < oldest) bf->from = oldest;
+        if (bf->from > bf->to || seq_window_has_all(&device->seq, bf->from, bf->to)) {
+            bf->pending = false;
+            continue;
+        }
+        if (difftime(now, bf->last_sent) < BACKFILL_RETRY_SEC) continue;
+        if (bf->attempts >= BACKFILL_MAX_ATTEMPTS) {
+            bf->pending = false;
+            bf->abandoned++;
+            continue;
+        }
+        
+        bf->attempts++;
+        bf->requests++;
+        bf->last_sent = now;
+        *sensor_id = device->sensor_id;
+        *boot = bf->boot;
+        *from = bf->from;
+        *to = bf->to;
+        found = 1;
+    }
+    pthread_mutex_unlock(&monitor_lock);
+    return found;
+}
+
+void monitor_update_device(int sensor_id, int room_id, double temperature, double humidity, time_t captured_at,
+                           const char *trigger) {
+    if (!monitor_initialized) return;
+    
+    time_t now = time(NULL);
+    pthread_mutex_lock(&monitor_lock);
+    DeviceStatus *device = find_or_add_device(sensor_id, room_id);
+    if (!device) {
+        pthread_mutex_unlock(&monitor_lock);
+        return;
+    }
+    
+    // Règles de seuil / variation sur l'horloge de capture, avant d'écraser la mesure précédente
+    bool replayed = captured_at < now - ALERT_REPLAY_AGE_SEC ||
+                    (device->last_captured != 0 && captured_at < device->last_captured);
+    if (!replayed) {
+        alert_eval_reading(&alert_rules, &device->alerts, &alert_log, sensor_id, temperature, humidity,
+                           device->last_temperature, device->last_humidity, device->last_captured, captured_at);
+    }
+    // Cadence régulière : client sans trigger (ancien format), "scheduled" ou résumé
+    int periodic = !trigger || strcmp(trigger, "scheduled") == 0 || strcmp(trigger, "summary") == 0;
+    uint8_t anomalies = anomaly_update(&alert_rules.anomaly, &device->anomaly, temperature, humidity,
+                                       captured_at, periodic, now);
+    if (anomalies) {
+        printf("[Monitor] Anomaly on sensor_%d (flags 0x%02x): %.2f C, %.1f %%\n",
+               sensor_id, anomalies, temperature, humidity);
+    }
+    
+    // Capture datée dans le futur : elle figerait l'anneau (ajout en fin uniquement)
+    if (device->recent && captured_at <= now + 300) {
+        recent_ring_push(device->recent, captured_at, temperature, humidity);
+    }
     
     // Mettre à jour les données du device
-    DeviceStatus *device = &system_health.devices[device_index];
     device->last_seen = now;
-    device->last_temperature = temperature;
-    device->last_humidity = humidity;
+    if (captured_at >= device->last_captured) {
+        device->last_captured = captured_at;
+        device->last_temperature = temperature;
+        device->last_humidity = humidity;
+    }
     
     // Ajouter cette lecture à l'historique
     add_reading_to_history(device, now);
@@ -178,24 +359,303 @@ void monitor_update_device(int sensor_id, int room_id, double temperature, doubl
     
     // Mettre à jour le statut global
     update_global_status();
+    pthread_mutex_unlock(&monitor_lock);
 }
 
-SystemHealth* monitor_get_system_health(void) {
-    if (!monitor_initialized) return NULL;
+void monitor_update_presence(int sensor_id, int room_id, bool online) {
+    if (!monitor_initialized) return;
+    
+    pthread_mutex_lock(&monitor_lock);
+    DeviceStatus *device = find_or_add_device(sensor_id, room_id);
+    if (device) {
+        if (room_id > 0 && device->room_id != room_id) {
+            device->room_id = room_id;
+            snprintf(device->room_name, sizeof(device->room_name), "%s", get_room_name(room_id));
+            alert_rebind(&alert_rules, &device->alerts, &alert_log, sensor_id, room_id, time(NULL));
+        }
+        device->presence = online ? PRESENCE_ONLINE : PRESENCE_OFFLINE;
+        device->presence_at = time(NULL);
+        update_global_status();
+    }
+    pthread_mutex_unlock(&monitor_lock);
+}
+
+int monitor_update_summary(int sensor_id, const DeviceSummary *summary) {
+    if (!monitor_initialized || !summary) return -1;
+    
+    // Appelé après monitor_update_device : le device existe déjà
+    pthread_mutex_lock(&monitor_lock);
+    int device_index = find_device_index(sensor_id);
+    if (device_index != -1) {
+        DeviceStatus *device = &system_health.devices[device_index];
+        device->summary = *summary;
+        device->summary.present = true;
+    }
+    pthread_mutex_unlock(&monitor_lock);
+    return device_index == -1 ? -1 : 0;
+}
+
+static cJSON* metric_to_json(double min, double max, double mean, double last) {
+    cJSON *m = cJSON_CreateObject();
+    cJSON_AddNumberToObject(m, "min", min);
+    cJSON_AddNumberToObject(m, "max", max);
+    cJSON_AddNumberToObject(m, "mean", mean);
+    cJSON_AddNumberToObject(m, "last", last);
+    return m;
+}
+
+int monitor_update_telemetry(int sensor_id, const DeviceTelemetry *telemetry) {
+    if (!monitor_initialized || !telemetry) return -1;
+    
+    // La télémétrie ne crée pas de device : il apparaît à sa première mesure
+    pthread_mutex_lock(&monitor_lock);
+    int device_index = find_device_index(sensor_id);
+    if (device_index != -1) {
+        DeviceStatus *device = &system_health.devices[device_index];
+        device->telemetry = *telemetry;
+        device->telemetry.present = true;
+        device->telemetry.received_at = time(NULL);
+    }
+    pthread_mutex_unlock(&monitor_lock);
+    return device_index == -1 ? -1 : 0;
+}
+
+// Bloc "i2c" d'un device : compteurs cumulés + taux d'erreur
+static cJSON* telemetry_to_json(const DeviceTelemetry *t) {
+    static const char *op_names[TELEMETRY_OPS] = { "write", "read", "combined" };
+    cJSON *i2c = cJSON_CreateObject();
+    unsigned int transfers = 0, errors = 0, naks = 0;
+    
+    cJSON_AddNumberToObject(i2c, "received_at", (double)t->received_at);
+    cJSON_AddNumberToObject(i2c, "client_uptime_sec", (double)t->uptime_sec);
+    cJSON_AddNumberToObject(i2c, "measurements", t->measurements);
+    cJSON_AddNumberToObject(i2c, "crc_errors", t->crc_errors);
+    cJSON_AddNumberToObject(i2c, "busy_timeouts", t->busy_timeouts);
+    cJSON_AddNumberToObject(i2c, "busy_at_fetch", t->busy_at_fetch);
+    cJSON_AddNumberToObject(i2c, "sensor_iic_errors", t->iic_errors);
+    
+    cJSON *bounds = cJSON_CreateArray();
+    for (int b = 0; b < TELEMETRY_HIST_BUCKETS; b++) {
+        cJSON_AddItemToArray(bounds, cJSON_CreateNumber(t->bounds_us[b]));
+    }
+    cJSON_AddItemToObject(i2c, "bounds_us", bounds);
+    
+    for (int op = 0; op < TELEMETRY_OPS; op++) {
+        const I2cOpTelemetry *o = &t->ops[op];
+        cJSON *op_json = cJSON_CreateObject();
+        cJSON_AddNumberToObject(op_json, "count", o->count);
+        cJSON_AddNumberToObject(op_json, "errors", o->errors);
+        cJSON_AddNumberToObject(op_json, "nak", o->nak);
+        cJSON_AddNumberToObject(op_json, "avg_us", o->avg_us);
+        cJSON_AddNumberToObject(op_json, "max_us", o->max_us);
+        cJSON *hist = cJSON_CreateArray();
+        for (int b = 0; b < TELEMETRY_HIST_BUCKETS; b++) {
+            cJSON_AddItemToArray(hist, cJSON_CreateNumber(o->hist[b]));
+        }
+        cJSON_AddItemToObject(op_json, "hist", hist);
+        cJSON_AddItemToObject(i2c, op_names[op], op_json);
+        transfers += o->count;
+        errors += o->errors;
+        naks += o->nak;
+    }
+    
+    cJSON_AddNumberToObject(i2c, "transfers", transfers);
+    cJSON_AddNumberToObject(i2c, "errors", errors);
+    cJSON_AddNumberToObject(i2c, "nak", naks);
+    cJSON_AddNumberToObject(i2c, "error_rate", transfers ? (double)errors / transfers : 0.0);
+    return i2c;
+}
+
+int monitor_get_system_health(SystemHealth *out) {
+    if (!monitor_initialized) return -1;
+    pthread_mutex_lock(&monitor_lock);
+    update_global_status();
+    *out = system_health;
+    pthread_mutex_unlock(&monitor_lock);
+    out->devices = NULL;   // table partagée : lisible uniquement sous monitor_lock
+    return 0;
+}
+
+// true si une règle error de même kind/metric est active : seule la plus grave est affichée
+static bool alert_superseded(const AlertBinding *b, int i) {
+    const AlertRule *r = &alert_rules.rules[b->idx[i]];
+    if (r->level == ALERT_LEVEL_ERROR) return false;
+    for (int j = 0; j < b->count; j++) {
+        const AlertRule *o = &alert_rules.rules[b->idx[j]];
+        if (j != i && b->state[j].active && o->kind == r->kind && o->metric == r->metric &&
+            o->level == ALERT_LEVEL_ERROR) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static const struct {
+    uint8_t flag;
+    const char *name;
+} anomaly_names[] = {
+    { ANOMALY_TEMPERATURE_SPIKE, "temperature_spike" },
+    { ANOMALY_HUMIDITY_SPIKE, "humidity_spike" },
+    { ANOMALY_INTERVAL_JITTER, "interval_jitter" },
+    { ANOMALY_STUCK, "stuck" },
+};
+
+static cJSON* ewma_to_json(const EwmaStat *stat) {
+    cJSON *m = cJSON_CreateObject();
+    cJSON_AddNumberToObject(m, "mean", stat->mean);
+    cJSON_AddNumberToObject(m, "stddev", anomaly_stddev(stat));
+    return m;
+}
+
+// Bloc "anomaly" : drapeaux actifs (signalés depuis moins de ANOMALY_HOLD_SEC) + statistiques
+static cJSON* anomaly_to_json(const AnomalyState *s, time_t now) {
+    cJSON *a = cJSON_CreateObject();
+    cJSON *flags = cJSON_CreateArray();
+    if (s->flags && difftime(now, s->flagged_at) < ANOMALY_HOLD_SEC) {
+        for (size_t i = 0; i < sizeof(anomaly_names) / sizeof(anomaly_names[0]); i++) {
+            if (s->flags & anomaly_names[i].flag) {
+                cJSON_AddItemToArray(flags, cJSON_CreateString(anomaly_names[i].name));
+            }
+        }
+    }
+    cJSON_AddItemToObject(a, "flags", flags);
+    cJSON_AddNumberToObject(a, "count", s->count);
+    cJSON_AddNumberToObject(a, "last_flagged_at", (double)s->flagged_at);
+    cJSON_AddBoolToObject(a, "warming_up", s->samples < alert_rules.anomaly.warmup);
+    cJSON_AddItemToObject(a, "temperature", ewma_to_json(&s->temperature));
+    cJSON_AddItemToObject(a, "humidity", ewma_to_json(&s->humidity));
+    cJSON_AddItemToObject(a, "interval_sec", ewma_to_json(&s->interval));
+    return a;
+}
+
+// Même forme que les alertes calculées par le dashboard (type, level, sensor_id, room_name, message)
+static cJSON* alert_to_json(int rule, const DeviceStatus *device, double value) {
+    const AlertRule *r = &alert_rules.rules[rule];
+    char message[128];
+    alert_format_message(r, value, message, sizeof(message));
+    
+    cJSON *a = cJSON_CreateObject();
+    cJSON_AddStringToObject(a, "type", alert_type_label(r));
+    cJSON_AddStringToObject(a, "level", alert_level_label(r->level));
+    cJSON_AddNumberToObject(a, "sensor_id", device ? device->sensor_id : 0);
+    cJSON_AddStringToObject(a, "room_name", device ? device->room_name : "");
+    cJSON_AddStringToObject(a, "message", message);
+    cJSON_AddNumberToObject(a, "rule", rule);
+    cJSON_AddNumberToObject(a, "value", value);
+    cJSON_AddNumberToObject(a, "threshold", r->threshold);
+    return a;
+}
+
+void monitor_check_alerts(void) {
+    if (!monitor_initialized) return;
+    
+    // Règles "stale" : ici seulement (tick de la boucle principale), pas à chaque mesure ou requête
+    time_t now = time(NULL);
+    pthread_mutex_lock(&monitor_lock);
     update_global_status();
-    return &system_health;
+    for (int i = 0; i < system_health.total_devices; i++) {
+        DeviceStatus *device = &system_health.devices[i];
+        alert_eval_stale(&alert_rules, &device->alerts, &alert_log, device->sensor_id, device->last_seen, now);
+    }
+    pthread_mutex_unlock(&monitor_lock);
+}
+
+char* monitor_get_events_json(unsigned long since) {
+    if (!monitor_initialized) return NULL;
+    
+    static AlertEvent events[ALERT_EVENT_RING];   // sous monitor_lock
+    pthread_mutex_lock(&monitor_lock);
+    int n = alert_events_since(&alert_log, since, events, ALERT_EVENT_RING);
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON *list = cJSON_CreateArray();
+    cJSON_AddNumberToObject(root, "next", alert_log.next_id ? alert_log.next_id - 1 : 0);
+    for (int i = 0; i < n; i++) {
+        int device_index = find_device_index(events[i].sensor_id);
+        const DeviceStatus *device = device_index != -1 ? &system_health.devices[device_index] : NULL;
+        cJSON *e = alert_to_json(events[i].rule, device, events[i].value);
+        cJSON_AddNumberToObject(e, "id", events[i].id);
+        cJSON_AddNumberToObject(e, "timestamp", (double)events[i].at);
+        cJSON_AddStringToObject(e, "state", events[i].raised ? "raised" : "cleared");
+        cJSON_AddItemToArray(list, e);
+    }
+    cJSON_AddItemToObject(root, "events", list);
+    pthread_mutex_unlock(&monitor_lock);
+    
+    char *json_string = cJSON_Print(root);
+    cJSON_Delete(root);
+    return json_string;
+}
+
+static cJSON* recent_stats_to_json(const RecentStats *s) {
+    cJSON *m = cJSON_CreateObject();
+    cJSON_AddNumberToObject(m, "min", s->min);
+    cJSON_AddNumberToObject(m, "max", s->max);
+    cJSON_AddNumberToObject(m, "mean", s->mean);
+    cJSON_AddNumberToObject(m, "stddev", s->stddev);
+    return m;
+}
+
+char* monitor_get_recent_json(int sensor_id, long window, bool with_points) {
+    if (!monitor_initialized) return NULL;
+    
+    time_t now = time(NULL);
+    time_t since = now - window;
+    pthread_mutex_lock(&monitor_lock);
+    int device_index = find_device_index(sensor_id);
+    if (device_index == -1 || !system_health.devices[device_index].recent) {
+        pthread_mutex_unlock(&monitor_lock);
+        return NULL;
+    }
+    const RecentRing *ring = system_health.devices[device_index].recent;
+    
+    RecentStats temperature, humidity;
+    uint32_t count = recent_ring_stats(ring, since, &temperature, &humidity);
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "sensor_id", sensor_id);
+    cJSON_AddNumberToObject(root, "window", window);
+    cJSON_AddNumberToObject(root, "from", (double)since);
+    cJSON_AddNumberToObject(root, "to", (double)now);
+    cJSON_AddNumberToObject(root, "count", count);
+    cJSON_AddNumberToObject(root, "out_of_order", ring->out_of_order);
+    cJSON_AddNumberToObject(root, "dropped", ring->dropped);
+    cJSON_AddItemToObject(root, "temperature", recent_stats_to_json(&temperature));
+    cJSON_AddItemToObject(root, "humidity", recent_stats_to_json(&humidity));
+    
+    if (with_points) {
+        // [[ts, température, humidité], ...] plus anciens d'abord
+        cJSON *points = cJSON_CreateArray();
+        for (uint32_t i = ring->count - count; i < ring->count; i++) {
+            time_t ts;
+            double t, h;
+            recent_ring_get(ring, i, &ts, &t, &h);
+            cJSON *p = cJSON_CreateArray();
+            cJSON_AddItemToArray(p, cJSON_CreateNumber((double)ts));
+            cJSON_AddItemToArray(p, cJSON_CreateNumber(t));
+            cJSON_AddItemToArray(p, cJSON_CreateNumber(h));
+            cJSON_AddItemToArray(points, p);
+        }
+        cJSON_AddItemToObject(root, "points", points);
+    }
+    pthread_mutex_unlock(&monitor_lock);
+    
+    char *json_string = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return json_string;
 }
 
 char* monitor_get_json_status(void) {
     if (!monitor_initialized) return NULL;
     
-    SystemHealth *health = monitor_get_system_health();
-    if (!health) return NULL;
+    pthread_mutex_lock(&monitor_lock);
+    update_global_status();
+    SystemHealth *health = &system_health;
     
     cJSON *root = cJSON_CreateObject();
     cJSON *summary = cJSON_CreateObject();
     cJSON *devices = cJSON_CreateArray();
-    cJSON *alerts = cJSON_CreateArray(); // Ajouter tableau d'alertes vide pour compatibilité
+    cJSON *alerts = cJSON_CreateArray();
     
     // Informations globales
     cJSON_AddStringToObject(root, "global_status", health->global_status);
@@ -206,6 +666,8 @@ char* monitor_get_json_status(void) {
     cJSON_AddNumberToObject(summary, "online", health->online_devices);
     cJSON_AddNumberToObject(summary, "warning", health->warning_devices);
     cJSON_AddNumberToObject(summary, "offline", health->offline_devices);
+    cJSON_AddNumberToObject(summary, "duplicates", health->duplicates);
+    cJSON_AddNumberToObject(summary, "gaps", health->gaps);
     cJSON_AddItemToObject(root, "summary", summary);
     
     // Devices individuels
@@ -225,13 +687,66 @@ char* monitor_get_json_status(void) {
         // Calcul minutes depuis dernière lecture
         double minutes_since = difftime(time(NULL), device->last_seen) / 60.0;
         cJSON_AddNumberToObject(device_json, "minutes_since_last_reading", minutes_since);
+        if (device->presence != PRESENCE_UNKNOWN) {
+            cJSON_AddStringToObject(device_json, "presence",
+                                    device->presence == PRESENCE_ONLINE ? "online" : "offline");
+            cJSON_AddNumberToObject(device_json, "presence_since", (double)device->presence_at);
+        }
+        
+        if (device->seq.initialized) {
+            const SeqWindow *w = &device->seq;
+            cJSON *seq = cJSON_CreateObject();
+            cJSON_AddNumberToObject(seq, "boot", w->boot);
+            cJSON_AddNumberToObject(seq, "last_seq", w->highest);
+            cJSON_AddNumberToObject(seq, "accepted", w->accepted);
+            cJSON_AddNumberToObject(seq, "duplicates", w->duplicates);
+            cJSON_AddNumberToObject(seq, "gaps", w->gaps);
+            cJSON_AddNumberToObject(seq, "late", w->late);
+            cJSON_AddNumberToObject(seq, "stale", w->stale);
+            cJSON_AddNumberToObject(seq, "restarts", w->restarts);
+            cJSON_AddBoolToObject(seq, "backfill_pending", device->backfill.pending);
+            cJSON_AddNumberToObject(seq, "backfill_requests", device->backfill.requests);
+            cJSON_AddNumberToObject(seq, "backfill_abandoned", device->backfill.abandoned);
+            cJSON_AddItemToObject(device_json, "sequence", seq);
+        }
+        
+        if (device->summary.present) {
+            const DeviceSummary *sm = &device->summary;
+            cJSON *summary = cJSON_CreateObject();
+            cJSON_AddNumberToObject(summary, "period_start", (double)sm->period_start);
+            cJSON_AddNumberToObject(summary, "period_end", (double)sm->period_end);
+            cJSON_AddNumberToObject(summary, "count", sm->count);
+            cJSON_AddItemToObject(summary, "temperature",
+                                  metric_to_json(sm->temp_min, sm->temp_max, sm->temp_mean, sm->temp_last));
+            cJSON_AddItemToObject(summary, "humidity",
+                                  metric_to_json(sm->hum_min, sm->hum_max, sm->hum_mean, sm->hum_last));
+            cJSON_AddItemToObject(device_json, "summary", summary);
+        }
+        
+        if (device->anomaly.samples > 0) {
+            cJSON_AddItemToObject(device_json, "anomaly", anomaly_to_json(&device->anomaly, time(NULL)));
+        }
+        
+        if (device->telemetry.present) {
+            cJSON_AddItemToObject(device_json, "i2c", telemetry_to_json(&device->telemetry));
+        }
         
         cJSON_AddItemToArray(devices, device_json);
+        
+        // Alertes actives du device
+        const AlertBinding *b = &device->alerts;
+        for (int a = 0; a < b->count; a++) {
+            if (!b->state[a].active || alert_superseded(b, a)) continue;
+            cJSON *alert = alert_to_json(b->idx[a], device, b->state[a].value);
+            cJSON_AddNumberToObject(alert, "since", (double)b->state[a].since);
+            cJSON_AddItemToArray(alerts, alert);
+        }
     }
     cJSON_AddItemToObject(root, "devices", devices);
-    
-    // Ajouter le tableau d'alertes (vide pour l'instant, mais maintient la compatibilité)
     cJSON_AddItemToObject(root, "alerts", alerts);
+    // Règles évaluées côté serveur : le dashboard n'utilise alors plus son calcul local
+    cJSON_AddNumberToObject(root, "alert_rules", alert_rules.count);
+    pthread_mutex_unlock(&monitor_lock);
     
     char *json_string = cJSON_Print(root);
     cJSON_Delete(root);
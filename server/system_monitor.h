@@ -3,8 +3,67 @@
 
 #include <time.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "seq_window.h"
+#include "alert_rules.h"
+#include "recent_ring.h"
 
 #define MAX_READINGS_HISTORY 100  // Garder max 100 dernières lectures
+#define TELEMETRY_HIST_BUCKETS 8  // Buckets de latence I2C envoyés par le client
+#define TELEMETRY_OPS 3           // write, read, combined
+
+// Compteurs d'un type de transfert I2C (cumul depuis le démarrage du client)
+typedef struct {
+    unsigned int count;
+    unsigned int errors;
+    unsigned int nak;
+    unsigned int avg_us;
+    unsigned int max_us;
+    unsigned int hist[TELEMETRY_HIST_BUCKETS];
+} I2cOpTelemetry;
+
+// Dernier résumé d'agrégation publié par le client (trigger "summary")
+typedef struct {
+    bool present;
+    time_t period_start;
+    time_t period_end;
+    int count;
+    double temp_min, temp_max, temp_mean, temp_last;
+    double hum_min, hum_max, hum_mean, hum_last;
+} DeviceSummary;
+
+// Demande de renvoi (backfill) en cours pour un trou de séquence
+typedef struct {
+    bool pending;
+    uint32_t boot;
+    uint32_t from;
+    uint32_t to;
+    time_t last_sent;
+    int attempts;
+    unsigned long requests;     // cumul des demandes publiées
+    unsigned long abandoned;    // trous abandonnés (client sans historique, redémarré...)
+} DeviceBackfill;
+
+// Présence annoncée par le client sur weather/status/<sensor_id> (LWT ou statut retenu)
+typedef enum {
+    PRESENCE_UNKNOWN = 0,
+    PRESENCE_ONLINE,
+    PRESENCE_OFFLINE
+} DevicePresence;
+
+// Dernière télémétrie reçue sur weather/telemetry
+typedef struct {
+    bool present;
+    time_t received_at;
+    long uptime_sec;
+    unsigned int measurements;
+    unsigned int iic_errors;
+    unsigned int crc_errors;
+    unsigned int busy_timeouts;
+    unsigned int busy_at_fetch;
+    unsigned int bounds_us[TELEMETRY_HIST_BUCKETS]; // 0 = bucket ouvert
+    I2cOpTelemetry ops[TELEMETRY_OPS];
+} DeviceTelemetry;
 
 // Structure pour l'état d'un device
 typedef struct {
@@ -14,6 +73,7 @@ typedef struct {
     time_t last_seen;
     double last_temperature;
     double last_humidity;
+    time_t last_captured;  // capture de last_temperature / last_humidity
     int readings_count_last_hour;
     
     // Historique pour calcul fenêtre glissante
@@ -23,6 +83,16 @@ typedef struct {
     
     bool is_online;
     char status[16]; // "online", "warning", "offline"
+    DevicePresence presence;
+    time_t presence_at;  // réception du dernier message de statut
+    
+    DeviceTelemetry telemetry;
+    DeviceSummary summary;
+    SeqWindow seq;   // dédoublonnage / détection de trous (boot + seq du client)
+    DeviceBackfill backfill;
+    AlertBinding alerts;   // règles d'alerte applicables et leur état
+    AnomalyState anomaly;  // EWMA température / humidité / intervalle
+    RecentRing *recent;    // 24 h de mesures à la minute (alloué à l'enregistrement, NULL si échec)
 } DeviceStatus;
 
 // Structure pour l'état global du système
@@ -31,21 +101,49 @@ typedef struct {
     int online_devices;
     int warning_devices;
     int offline_devices;
+    unsigned long duplicates;   // cumul tous devices
+    unsigned long gaps;
     time_t last_update;
     DeviceStatus *devices;
     char global_status[16]; // "healthy", "warning", "critical"
 } SystemHealth;
 
-// Fonctions principales
+// Fonctions principales (thread-safe : callbacks MQTT et thread HTTP)
 int monitor_init(void);
+// Table de capacity devices au lieu de MAX_DEVICES (banc d'essai, grosses flottes)
+int monitor_init_capacity(int capacity);
 void monitor_cleanup(void);
-void monitor_update_device(int sensor_id, int room_id, double temperature, double humidity);
-SystemHealth* monitor_get_system_health(void);
+// captured_at : horodatage de capture (intervalle entre mesures pour la détection d'anomalies)
+// trigger : "scheduled", "change", "on-demand"... (NULL = ancien client, périodique)
+void monitor_update_device(int sensor_id, int room_id, double temperature, double humidity, time_t captured_at,
+                           const char *trigger);
+// Vérifie (boot, seq) avant ingestion ; crée le device si besoin.
+// Un trou de séquence ouvre une demande de backfill.
+SeqVerdict monitor_accept_sequence(int sensor_id, int room_id, uint32_t boot, uint32_t seq);
+
+// Prochaine demande de backfill à publier ; 1 si *out rempli, 0 sinon.
+// Un trou comblé ou parti de la fenêtre est clos, réémis toutes les BACKFILL_RETRY_SEC.
+int monitor_next_backfill(int *sensor_id, uint32_t *boot, uint32_t *from, uint32_t *to);
+// Statut online/offline publié par le client ; crée le device si besoin
+// (statuts retenus rejoués par le broker au démarrage du serveur).
+void monitor_update_presence(int sensor_id, int room_id, bool online);
+int monitor_update_summary(int sensor_id, const DeviceSummary *summary);     // -1 si device inconnu
+int monitor_update_telemetry(int sensor_id, const DeviceTelemetry *telemetry); // -1 si device inconnu
+// Copie des compteurs globaux prise sous verrou (devices = NULL) ; -1 si non initialisé
+int monitor_get_system_health(SystemHealth *out);
 char* monitor_get_json_status(void);
+// Réévalue les règles dépendant du temps (stale) ; appelé périodiquement
+void monitor_check_alerts(void);
+// Événements d'alerte d'id > since : {"next":..,"events":[...]}
+char* monitor_get_events_json(unsigned long since);
+// Statistiques (et points si with_points) des window dernières secondes ; NULL si device inconnu
+char* monitor_get_recent_json(int sensor_id, long window, bool with_points);
 
 // Configuration
 #define MAX_DEVICES 10
 #define OFFLINE_THRESHOLD_MINUTES 30
 #define WARNING_THRESHOLD_MINUTES 10
+#define BACKFILL_RETRY_SEC 30
+#define BACKFILL_MAX_ATTEMPTS 3
 
 #endif // SYSTEM_MONITOR_H
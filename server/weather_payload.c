@@ -0,0 +1,137 @@
+#include "weather_payload.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool weather_plausible_time(double ts, time_t received_at) {
+    return ts >= (double)(received_at - 86400) && ts <= (double)(received_at + 300);
+}
+
+// Horodatage key s'il est plausible, sinon fallback
+static time_t time_field(const cJSON *obj, const char *key, time_t fallback, time_t received_at) {
+    const cJSON *ts_json = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (!cJSON_IsNumber(ts_json) || !weather_plausible_time(ts_json->valuedouble, received_at)) return fallback;
+    return (time_t)ts_json->valuedouble;
+}
+
+// (boot, seq) du client ; messages sans séquence (anciens clients) : has_seq = false
+static void sequence_fields(const cJSON *obj, WeatherReading *r) {
+    const cJSON *boot_json = cJSON_GetObjectItemCaseSensitive(obj, "boot");
+    const cJSON *seq_json = cJSON_GetObjectItemCaseSensitive(obj, "seq");
+    r->seq = cJSON_IsNumber(seq_json) ? (uint32_t)seq_json->valuedouble : 0;
+    r->has_seq = cJSON_IsNumber(boot_json) && cJSON_IsNumber(seq_json) && seq_json->valuedouble >= 1;
+    r->boot = r->has_seq ? (uint32_t)boot_json->valuedouble : 0;
+}
+
+/* Lit {"min","max","mean","last"} ; 0 si incomplet */
+static int summary_metric(const cJSON *obj, double *min, double *max, double *mean, double *last) {
+    const cJSON *mn = cJSON_GetObjectItemCaseSensitive(obj, "min");
+    const cJSON *mx = cJSON_GetObjectItemCaseSensitive(obj, "max");
+    const cJSON *me = cJSON_GetObjectItemCaseSensitive(obj, "mean");
+    const cJSON *la = cJSON_GetObjectItemCaseSensitive(obj, "last");
+    if (!cJSON_IsNumber(mn) || !cJSON_IsNumber(mx) || !cJSON_IsNumber(me) || !cJSON_IsNumber(la)) return 0;
+    *min = mn->valuedouble;
+    *max = mx->valuedouble;
+    *mean = me->valuedouble;
+    *last = la->valuedouble;
+    return 1;
+}
+
+static void decode_reading(WeatherPayload *p, const cJSON *json, time_t received_at) {
+    WeatherReading *r = &p->single;
+    const cJSON *ts_ms_json = cJSON_GetObjectItemCaseSensitive(json, "ts_ms");
+    r->temperature = cJSON_GetObjectItemCaseSensitive(json, "temperature")->valuedouble;
+    r->humidity = cJSON_GetObjectItemCaseSensitive(json, "humidity")->valuedouble;
+    r->captured_at = time_field(json, "ts", received_at, received_at);
+    r->captured_ms = cJSON_IsNumber(ts_ms_json) ? (int64_t)ts_ms_json->valuedouble : 0;
+    r->trigger = cJSON_GetStringValue(cJSON_GetObjectItemCaseSensitive(json, "trigger"));
+    sequence_fields(json, r);
+    p->readings = r;
+    p->count = 1;
+    p->kind = WEATHER_READING;
+}
+
+// Lot hors-ligne : pas de repli sur la réception, tout le lot s'empilerait sur la même seconde
+static void decode_batch(WeatherPayload *p, const cJSON *readings, time_t received_at) {
+    int size = cJSON_GetArraySize(readings);
+    p->kind = WEATHER_BATCH;
+    if (size == 0) return;
+    p->readings = calloc((size_t)size, sizeof(WeatherReading));
+    if (!p->readings) {
+        p->invalid = size;
+        return;
+    }
+    const cJSON *e;
+    cJSON_ArrayForEach(e, readings) {
+        const cJSON *ts_json = cJSON_GetObjectItemCaseSensitive(e, "ts");
+        const cJSON *t_json = cJSON_GetObjectItemCaseSensitive(e, "temperature");
+        const cJSON *h_json = cJSON_GetObjectItemCaseSensitive(e, "humidity");
+        if (!cJSON_IsNumber(ts_json) || !cJSON_IsNumber(t_json) || !cJSON_IsNumber(h_json) ||
+            !weather_plausible_time(ts_json->valuedouble, received_at)) {
+            p->invalid++;
+            continue;
+        }
+        WeatherReading *r = &p->readings[p->count++];
+        r->temperature = t_json->valuedouble;
+        r->humidity = h_json->valuedouble;
+        r->captured_at = (time_t)ts_json->valuedouble;
+        r->trigger = cJSON_GetStringValue(cJSON_GetObjectItemCaseSensitive(e, "trigger"));
+        sequence_fields(e, r);
+    }
+}
+
+// Résumé d'agrégation en bordure : la moyenne alimente l'historique, min/max/last le monitoring
+static void decode_summary(WeatherPayload *p, const cJSON *json, time_t received_at) {
+    DeviceSummary *sm = &p->summary;
+    if (!summary_metric(cJSON_GetObjectItemCaseSensitive(json, "temperature"),
+                        &sm->temp_min, &sm->temp_max, &sm->temp_mean, &sm->temp_last) ||
+        !summary_metric(cJSON_GetObjectItemCaseSensitive(json, "humidity"),
+                        &sm->hum_min, &sm->hum_max, &sm->hum_mean, &sm->hum_last)) {
+        return;
+    }
+    const cJSON *count_json = cJSON_GetObjectItemCaseSensitive(json, "count");
+    sm->period_end = time_field(json, "period_end", received_at, received_at);
+    sm->period_start = time_field(json, "period_start", sm->period_end, received_at);
+    if (sm->period_start > sm->period_end) sm->period_start = sm->period_end;
+    sm->count = cJSON_IsNumber(count_json) ? count_json->valueint : 0;
+
+    WeatherReading *r = &p->single;
+    r->temperature = sm->temp_mean;
+    r->humidity = sm->hum_mean;
+    r->captured_at = sm->period_end;
+    r->trigger = "summary";
+    sequence_fields(json, r);
+    p->readings = r;
+    p->count = 1;
+    p->kind = WEATHER_SUMMARY;
+}
+
+int weather_payload_decode(WeatherPayload *p, const void *payload, size_t len, time_t received_at) {
+    memset(p, 0, sizeof(*p));
+    p->json = cJSON_ParseWithLength(payload, len);
+    if (!p->json) return -1;
+
+    const cJSON *json = p->json;
+    const cJSON *sensor_id_json = cJSON_GetObjectItemCaseSensitive(json, "sensor_id");
+    const cJSON *room_id_json = cJSON_GetObjectItemCaseSensitive(json, "room_id");
+    const cJSON *temperature_json = cJSON_GetObjectItemCaseSensitive(json, "temperature");
+    const cJSON *humidity_json = cJSON_GetObjectItemCaseSensitive(json, "humidity");
+    const cJSON *readings_json = cJSON_GetObjectItemCaseSensitive(json, "readings");
+    if (!cJSON_IsNumber(sensor_id_json)) return 0;
+    p->sensor_id = sensor_id_json->valueint;
+    p->room_id = cJSON_IsNumber(room_id_json) ? room_id_json->valueint : 0;
+
+    if (cJSON_IsNumber(temperature_json) && cJSON_IsNumber(humidity_json)) {
+        decode_reading(p, json, received_at);
+    } else if (cJSON_IsArray(readings_json)) {
+        decode_batch(p, readings_json, received_at);
+    } else if (cJSON_IsObject(temperature_json) && cJSON_IsObject(humidity_json)) {
+        decode_summary(p, json, received_at);
+    }
+    return 0;
+}
+
+void weather_payload_free(WeatherPayload *p) {
+    if (p->readings && p->readings != &p->single) free(p->readings);
+    cJSON_Delete(p->json);
+    memset(p, 0, sizeof(*p));
+}
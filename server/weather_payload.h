@@ -0,0 +1,57 @@
+#ifndef WEATHER_PAYLOAD_H
+#define WEATHER_PAYLOAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include "cJSON.h"
+#include "system_monitor.h"
+
+// Décodage des messages du topic "weather", sans effet de bord (ni monitor, ni métriques) :
+// utilisé par on_mqtt_msg et par server_bench, qui mesure ainsi le vrai chemin.
+//   mesure   {"sensor_id","room_id","temperature","humidity","trigger","ts","ts_ms","boot","seq"}
+//   lot      {"sensor_id","room_id","readings":[{"ts","temperature","humidity","trigger","boot","seq"}...]}
+//   résumé   {"sensor_id","room_id","temperature":{min,max,mean,last},"humidity":{...},
+//             "count","period_start","period_end","boot","seq"}
+
+typedef enum {
+    WEATHER_INVALID = 0,    // JSON valide mais forme inconnue ou champs manquants
+    WEATHER_READING,
+    WEATHER_BATCH,
+    WEATHER_SUMMARY
+} WeatherKind;
+
+typedef struct {
+    double temperature;
+    double humidity;
+    time_t captured_at;     // "ts" plausible, sinon réception (mesure seule)
+    int64_t captured_ms;    // "ts_ms" (0 = absent)
+    const char *trigger;    // dans le JSON décodé, NULL si absent
+    bool has_seq;           // "boot" et "seq" >= 1 présents
+    uint32_t boot;
+    uint32_t seq;
+} WeatherReading;
+
+typedef struct {
+    cJSON *json;            // arbre décodé, propriétaire des chaînes trigger
+    WeatherKind kind;
+    int sensor_id;
+    int room_id;            // 0 = absent
+    WeatherReading *readings;   // une entrée (mesure, résumé) ou les entrées valides du lot
+    int count;
+    int invalid;            // entrées du lot écartées (champs manquants, horodatage aberrant)
+    DeviceSummary summary;  // WEATHER_SUMMARY : readings[0] porte la moyenne et period_end
+    WeatherReading single;
+} WeatherPayload;
+
+// Horodatage client plausible : au plus 24 h dans le passé et 5 min dans le futur
+// (Pi sans RTC avant NTP)
+bool weather_plausible_time(double ts, time_t received_at);
+
+// 0 si le JSON est lisible (kind peut valoir WEATHER_INVALID), -1 sinon.
+// weather_payload_free doit être appelé dans les deux cas.
+int weather_payload_decode(WeatherPayload *p, const void *payload, size_t len, time_t received_at);
+void weather_payload_free(WeatherPayload *p);
+
+#endif // WEATHER_PAYLOAD_H
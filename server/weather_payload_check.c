@@ -0,0 +1,84 @@
+/* weather_payload_check.c - décodage des messages "weather" : mesure, lot, résumé, horodatages
+ *
+ * Usage : ./weather_payload_check   (make check)
+ *
+ * Formes publiées par le client (avec et sans séquence), entrées de lot invalides,
+ * horodatages hors de la fenêtre plausible, JSON illisible ou incomplet.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "weather_payload.h"
+#include "check.h"
+
+#define NOW 1760003600
+
+static int decode(WeatherPayload *p, const char *json) {
+    return weather_payload_decode(p, json, strlen(json), NOW);
+}
+
+int main(void) {
+    WeatherPayload p;
+
+    // Mesure en direct avec séquence ; payload non terminé par '\0' (tampon MQTT)
+    const char live[] = "{\"sensor_id\":3,\"room_id\":2,\"temperature\":21.5,\"humidity\":48,"
+                        "\"trigger\":\"scheduled\",\"ts\":1760003590,\"ts_ms\":1760003590123,"
+                        "\"boot\":7,\"seq\":42}garbage";
+    CHECK(weather_payload_decode(&p, live, strlen(live) - 7, NOW) == 0);
+    CHECK(p.kind == WEATHER_READING && p.sensor_id == 3 && p.room_id == 2 && p.count == 1);
+    CHECK(p.readings[0].temperature == 21.5 && p.readings[0].humidity == 48.0);
+    CHECK(p.readings[0].captured_at == 1760003590 && p.readings[0].captured_ms == 1760003590123LL);
+    CHECK(p.readings[0].has_seq && p.readings[0].boot == 7 && p.readings[0].seq == 42);
+    CHECK(p.readings[0].trigger && strcmp(p.readings[0].trigger, "scheduled") == 0);
+    weather_payload_free(&p);
+
+    // Ancien client : ni ts, ni séquence, ni room_id ; horloge aberrante => réception
+    CHECK(decode(&p, "{\"sensor_id\":1,\"temperature\":20,\"humidity\":40}") == 0);
+    CHECK(p.kind == WEATHER_READING && p.room_id == 0 && !p.readings[0].has_seq);
+    CHECK(p.readings[0].captured_at == NOW && p.readings[0].captured_ms == 0 && !p.readings[0].trigger);
+    weather_payload_free(&p);
+    CHECK(decode(&p, "{\"sensor_id\":1,\"temperature\":20,\"humidity\":40,\"ts\":86400,\"seq\":0,\"boot\":1}") == 0);
+    CHECK(p.readings[0].captured_at == NOW && !p.readings[0].has_seq);
+    weather_payload_free(&p);
+    CHECK(weather_plausible_time(NOW - 86400, NOW) && !weather_plausible_time(NOW - 86401, NOW));
+    CHECK(weather_plausible_time(NOW + 300, NOW) && !weather_plausible_time(NOW + 301, NOW));
+
+    // Lot hors-ligne : entrées incomplètes ou mal datées écartées, pas de repli sur la réception
+    CHECK(decode(&p, "{\"sensor_id\":4,\"room_id\":1,\"trigger\":\"backlog\",\"readings\":["
+                     "{\"ts\":1760000000,\"temperature\":19,\"humidity\":50,\"boot\":2,\"seq\":10},"
+                     "{\"ts\":1760000300,\"temperature\":19.5,\"humidity\":51,\"trigger\":\"on-demand\"},"
+                     "{\"temperature\":20,\"humidity\":52},"
+                     "{\"ts\":1000,\"temperature\":20,\"humidity\":52},"
+                     "{\"ts\":1760000600,\"humidity\":52}]}") == 0);
+    CHECK(p.kind == WEATHER_BATCH && p.count == 2 && p.invalid == 3);
+    CHECK(p.readings[0].captured_at == 1760000000 && p.readings[0].has_seq && p.readings[0].seq == 10);
+    CHECK(p.readings[1].humidity == 51.0 && !p.readings[1].has_seq);
+    CHECK(p.readings[1].trigger && strcmp(p.readings[1].trigger, "on-demand") == 0);
+    weather_payload_free(&p);
+    CHECK(decode(&p, "{\"sensor_id\":4,\"readings\":[]}") == 0 && p.kind == WEATHER_BATCH && p.count == 0);
+    weather_payload_free(&p);
+
+    // Résumé : la moyenne et period_end forment la mesure, début borné par la fin
+    CHECK(decode(&p, "{\"sensor_id\":5,\"room_id\":3,\"trigger\":\"summary\",\"count\":12,"
+                     "\"temperature\":{\"min\":20,\"max\":22,\"mean\":21,\"last\":21.5},"
+                     "\"humidity\":{\"min\":40,\"max\":44,\"mean\":42,\"last\":43},"
+                     "\"period_start\":1760003500,\"period_end\":1760003000,\"boot\":3,\"seq\":9}") == 0);
+    CHECK(p.kind == WEATHER_SUMMARY && p.count == 1 && p.summary.count == 12);
+    CHECK(p.summary.temp_max == 22.0 && p.summary.hum_last == 43.0);
+    CHECK(p.summary.period_end == 1760003000 && p.summary.period_start == 1760003000);
+    CHECK(p.readings[0].temperature == 21.0 && p.readings[0].humidity == 42.0);
+    CHECK(p.readings[0].captured_at == 1760003000 && strcmp(p.readings[0].trigger, "summary") == 0);
+    CHECK(p.readings[0].has_seq && p.readings[0].seq == 9);
+    weather_payload_free(&p);
+    CHECK(decode(&p, "{\"sensor_id\":5,\"temperature\":{\"min\":20},\"humidity\":{\"min\":40}}") == 0);
+    CHECK(p.kind == WEATHER_INVALID);
+    weather_payload_free(&p);
+
+    // Illisible, ou lisible mais sans capteur
+    CHECK(decode(&p, "{\"sensor_id\":1,") == -1);
+    weather_payload_free(&p);
+    CHECK(decode(&p, "{\"temperature\":20,\"humidity\":40}") == 0 && p.kind == WEATHER_INVALID);
+    weather_payload_free(&p);
+
+    return check_report("weather_payload");
+}
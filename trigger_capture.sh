@@ -4,7 +4,7 @@ echo "🎛️ TechTemp - Déclencheur de Capture à la Demande"
 echo "================================================="
 
 BROKER_IP="192.168.0.42"
-COMMAND_TOPIC="weather/command"
+COMMAND_TOPIC="weather/command"   # + /<sensor_id>, /room/<room_id> ou /all
 
 # Vérifier que mosquitto_pub est disponible
 if ! command -v mosquitto_pub &> /dev/null; then
@@ -13,7 +13,7 @@ if ! command -v mosquitto_pub &> /dev/null; then
 fi
 
 echo "📡 Broker MQTT: $BROKER_IP:1883"
-echo "📢 Topic: $COMMAND_TOPIC"
+echo "📢 Topics: $COMMAND_TOPIC/<sensor_id> | $COMMAND_TOPIC/room/<room_id> | $COMMAND_TOPIC/all"
 echo ""
 
 # Menu des options
@@ -22,37 +22,38 @@ echo "1) Capturer données du Sensor 1 (eetkamer)"
 echo "2) Capturer données du Sensor 3 (bureau_achter)"  
 echo "3) Capturer données de TOUS les capteurs"
 echo "4) Test custom"
+echo "5) Capturer données de toute une pièce"
 echo ""
 
-read -p "Votre choix (1-4): " choice
+read -p "Votre choix (1-5): " choice
 
 case $choice in
     1)
         echo "🌡️ Déclenchement capture Sensor 1..."
-        mosquitto_pub -h $BROKER_IP -t $COMMAND_TOPIC -m '{
+        mosquitto_pub -h $BROKER_IP -t $COMMAND_TOPIC/1 -m '{
             "action": "capture",
-            "sensor_id": 1,
             "timestamp": "'$(date -u +%Y-%m-%dT%H:%M:%SZ)'",
+            "ts": '$(date +%s)',
             "requested_by": "manual"
         }'
         echo "✅ Commande envoyée pour Sensor 1"
         ;;
     2)
         echo "🌡️ Déclenchement capture Sensor 3..."
-        mosquitto_pub -h $BROKER_IP -t $COMMAND_TOPIC -m '{
-            "action": "capture", 
-            "sensor_id": 3,
+        mosquitto_pub -h $BROKER_IP -t $COMMAND_TOPIC/3 -m '{
+            "action": "capture",
             "timestamp": "'$(date -u +%Y-%m-%dT%H:%M:%SZ)'",
+            "ts": '$(date +%s)',
             "requested_by": "manual"
         }'
         echo "✅ Commande envoyée pour Sensor 3"
         ;;
     3)
         echo "🌡️ Déclenchement capture TOUS les capteurs..."
-        mosquitto_pub -h $BROKER_IP -t $COMMAND_TOPIC -m '{
+        mosquitto_pub -h $BROKER_IP -t $COMMAND_TOPIC/all -m '{
             "action": "capture",
-            "sensor_id": "all", 
             "timestamp": "'$(date -u +%Y-%m-%dT%H:%M:%SZ)'",
+            "ts": '$(date +%s)',
             "requested_by": "manual"
         }'
         echo "✅ Commande envoyée pour TOUS les capteurs"
@@ -60,14 +61,25 @@ case $choice in
     4)
         read -p "Sensor ID: " sensor_id
         echo "🌡️ Déclenchement capture Sensor $sensor_id..."
-        mosquitto_pub -h $BROKER_IP -t $COMMAND_TOPIC -m '{
+        mosquitto_pub -h $BROKER_IP -t $COMMAND_TOPIC/$sensor_id -m '{
             "action": "capture",
-            "sensor_id": '$sensor_id',
             "timestamp": "'$(date -u +%Y-%m-%dT%H:%M:%SZ)'",
+            "ts": '$(date +%s)',
             "requested_by": "manual"
         }'
         echo "✅ Commande envoyée pour Sensor $sensor_id"
         ;;
+    5)
+        read -p "Room ID: " room_id
+        echo "🌡️ Déclenchement capture pièce $room_id..."
+        mosquitto_pub -h $BROKER_IP -t $COMMAND_TOPIC/room/$room_id -m '{
+            "action": "capture",
+            "timestamp": "'$(date -u +%Y-%m-%dT%H:%M:%SZ)'",
+            "ts": '$(date +%s)',
+            "requested_by": "manual"
+        }'
+        echo "✅ Commande envoyée pour la pièce $room_id"
+        ;;
     *)
         echo "❌ Choix invalide"
         exit 1
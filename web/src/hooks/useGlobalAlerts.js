@@ -14,17 +14,24 @@ export const useGlobalAlerts = () => {
   const devicesData = useDevicesData(systemHealth?.devices, useRealTime);
   const deviceAlerts = useDeviceAlerts(devicesData.devices);
 
-  // Séparation des alertes
-  const environmentalAlerts = deviceAlerts.filter(alert =>
+  // Séparation des alertes. Les seuils sont évalués par le serveur (hystérésis,
+  // durée minimale) ; le calcul local ne sert que si la réponse n'annonce aucune règle
+  // (liste d'alertes vide = rien d'actif, pas absence de règles).
+  const isEnvironmental = alert =>
     alert.type?.includes('Température') ||
-    alert.type?.includes('Humidité')
-  );
+    alert.type?.includes('Humidité');
+  const serverAlerts = systemHealth?.alerts || [];
+  const serverRules = systemHealth?.alert_rules > 0 && Array.isArray(systemHealth?.alerts);
+
+  const environmentalAlerts = serverRules
+    ? serverAlerts.filter(isEnvironmental)
+    : deviceAlerts.filter(isEnvironmental);
 
   const technicalAlerts = [
-    ...systemHealth?.alerts || [],
+    ...serverAlerts.filter(alert => !isEnvironmental(alert)),
     ...deviceAlerts.filter(alert =>
       alert.type?.includes('Offline') ||
-      alert.type?.includes('Données') ||
+      (alert.type?.includes('Données') && !(serverRules && alert.type?.includes('Obsolètes'))) ||
       alert.type?.includes('Système')
     )
   ];